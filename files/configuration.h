@@ -16,6 +16,8 @@
 #include "../utilities/json_file_utility.hpp"  // file utility type
 #include "../gps/gps_manager.h"
 #include "../imu/imu_manager.h"
+#include "../utilities/pwm_backend.h"      // pwm backend type
+#include "../utilities/pwm_calibration.h"  // fin calibration curves
 //
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -28,6 +30,22 @@ struct Configuration : JsonType
     std::string gpsPort     = "";
     SerialClient::BaudRate gpsBaudRate  = SerialClient::BaudRate::BAUDRATE_38400;
 
+    // GPS navigation profile
+    int gpsNavigationRateHz     = 0;        // 0 = unit default, ublox 10, 20 or 25, novatel any INSPVAX rate
+    bool gpsHighRateCovDop      = false;    // keep covariance and DOP in the high rate output set
+    std::string gpsRawLogPath   = "";       // raw measurement recording path, empty = disabled
+    int gpsParserBufferSize     = 0;        // parser buffer size in bytes per receiver, 0 = unit default
+
+    // Secondary GPS for redundancy, Unknown = none
+    GpsManager::GpsOptions gpsSecondaryUnit     = GpsManager::GpsOptions::Unknown;
+    std::string gpsSecondaryPort                = "";   // serial port, or "address:port" for network units
+    SerialClient::BaudRate gpsSecondaryBaudRate = SerialClient::BaudRate::BAUDRATE_115200;
+
+    // IMU acquisition thread
+    int imuCpuCore              = -1;       // core to pin the IMU thread to, -1 = any
+    int imuRtPriority           = 0;        // SCHED_FIFO priority for the IMU thread, 0 = normal scheduling
+    bool lockMemory             = false;    // mlockall the process so page faults cannot stall acquisition
+
     // PWMs / Fins
     std::string fin1Path    = "";
     int fin1Channel         = -1;
@@ -39,10 +57,30 @@ struct Configuration : JsonType
     int fin4Channel         = -1;
     double finMinDegrees    = -25.0;
     double finMaxDegrees    = 25.0;
+    PwmCalibration::Curve fin1Calibration = {}; // [[degrees, pulse us], ...], empty = linear 900 - 2100 us over +/-60 deg
+    PwmCalibration::Curve fin2Calibration = {};
+    PwmCalibration::Curve fin3Calibration = {};
+    PwmCalibration::Curve fin4Calibration = {};
+    double fin1TrimDegrees  = 0.0;      // added to every fin 1 deflection
+    double fin2TrimDegrees  = 0.0;
+    double fin3TrimDegrees  = 0.0;
+    double fin4TrimDegrees  = 0.0;
+    int actuatorRateHz      = 200;      // fin command frames written per second
+    double finSlewRateDegPerSec = 0.0;  // fastest a fin is driven, 0 = no limit
+    double finDeadbandDegrees   = 0.1;  // a fin holds while its command is within this
+    std::string pwmTracePath    = "";   // simulated fins only, where the fin writes are saved
+    std::string pwmReferencePath = "";  // simulated fins only, saved trace replayed through the fins in place of flying, its writes checked
+
+    // GPIOs / Discretes, lines are offsets on the chip, -1 = unused
+    std::string discreteChipPath = "";  // gpio character device, typically "/dev/gpiochipX", empty = no discretes
+    int armLine             = -1;       // output, driven low on startup
+    int releaseLine         = -1;       // output, driven low on startup
+    int statusLine          = -1;       // input, both edges reported
 
     // Hardware Selection
     GpsManager::GpsOptions gpsUnit       = GpsManager::GpsOptions::Ublox;
     ImuManager::ImuOptions imuUnit       = ImuManager::ImuOptions::IL_Kernel210;
+    PwmBackendType pwmBackend            = PwmBackendType::Sysfs;
 
     /// @brief map for json item to variables
     std::unordered_map<std::string, std::function<void(const nlohmann::json&)>> jsonMapping
@@ -51,6 +89,16 @@ struct Configuration : JsonType
         {"imuBaudRate",         [this](const nlohmann::json& j) { j.at("imuBaudRate").get_to(imuBaudRate);                  }},
         {"gpsPort",             [this](const nlohmann::json& j) { j.at("gpsPort").get_to(gpsPort);                          }},
         {"gpsBaudRate",         [this](const nlohmann::json& j) { j.at("gpsBaudRate").get_to(gpsBaudRate);                  }},
+        {"gpsNavigationRateHz", [this](const nlohmann::json& j) { j.at("gpsNavigationRateHz").get_to(gpsNavigationRateHz);  }},
+        {"gpsHighRateCovDop",   [this](const nlohmann::json& j) { j.at("gpsHighRateCovDop").get_to(gpsHighRateCovDop);      }},
+        {"gpsRawLogPath",       [this](const nlohmann::json& j) { j.at("gpsRawLogPath").get_to(gpsRawLogPath);              }},
+        {"gpsParserBufferSize", [this](const nlohmann::json& j) { j.at("gpsParserBufferSize").get_to(gpsParserBufferSize);  }},
+        {"gpsSecondaryUnit",    [this](const nlohmann::json& j) { j.at("gpsSecondaryUnit").get_to(gpsSecondaryUnit);        }},
+        {"gpsSecondaryPort",    [this](const nlohmann::json& j) { j.at("gpsSecondaryPort").get_to(gpsSecondaryPort);        }},
+        {"gpsSecondaryBaudRate",[this](const nlohmann::json& j) { j.at("gpsSecondaryBaudRate").get_to(gpsSecondaryBaudRate);}},
+        {"imuCpuCore",          [this](const nlohmann::json& j) { j.at("imuCpuCore").get_to(imuCpuCore);                    }},
+        {"imuRtPriority",       [this](const nlohmann::json& j) { j.at("imuRtPriority").get_to(imuRtPriority);              }},
+        {"lockMemory",          [this](const nlohmann::json& j) { j.at("lockMemory").get_to(lockMemory);                    }},
         {"fin1Path",            [this](const nlohmann::json& j) { j.at("fin1Path").get_to(fin1Path);                        }},
         {"fin1Channel",         [this](const nlohmann::json& j) { j.at("fin1Channel").get_to(fin1Channel);                  }},
         {"fin2Path",            [this](const nlohmann::json& j) { j.at("fin2Path").get_to(fin2Path);                        }},
@@ -61,8 +109,26 @@ struct Configuration : JsonType
         {"fin4Channel",         [this](const nlohmann::json& j) { j.at("fin4Channel").get_to(fin4Channel);                  }},
         {"finMinDegrees",       [this](const nlohmann::json& j) { j.at("finMinDegrees").get_to(finMinDegrees);              }},
         {"finMaxDegrees",       [this](const nlohmann::json& j) { j.at("finMaxDegrees").get_to(finMaxDegrees);              }},
+        {"fin1Calibration",     [this](const nlohmann::json& j) { j.at("fin1Calibration").get_to(fin1Calibration);          }},
+        {"fin2Calibration",     [this](const nlohmann::json& j) { j.at("fin2Calibration").get_to(fin2Calibration);          }},
+        {"fin3Calibration",     [this](const nlohmann::json& j) { j.at("fin3Calibration").get_to(fin3Calibration);          }},
+        {"fin4Calibration",     [this](const nlohmann::json& j) { j.at("fin4Calibration").get_to(fin4Calibration);          }},
+        {"fin1TrimDegrees",     [this](const nlohmann::json& j) { j.at("fin1TrimDegrees").get_to(fin1TrimDegrees);          }},
+        {"fin2TrimDegrees",     [this](const nlohmann::json& j) { j.at("fin2TrimDegrees").get_to(fin2TrimDegrees);          }},
+        {"fin3TrimDegrees",     [this](const nlohmann::json& j) { j.at("fin3TrimDegrees").get_to(fin3TrimDegrees);          }},
+        {"fin4TrimDegrees",     [this](const nlohmann::json& j) { j.at("fin4TrimDegrees").get_to(fin4TrimDegrees);          }},
+        {"actuatorRateHz",      [this](const nlohmann::json& j) { j.at("actuatorRateHz").get_to(actuatorRateHz);            }},
+        {"finSlewRateDegPerSec",[this](const nlohmann::json& j) { j.at("finSlewRateDegPerSec").get_to(finSlewRateDegPerSec);}},
+        {"finDeadbandDegrees",  [this](const nlohmann::json& j) { j.at("finDeadbandDegrees").get_to(finDeadbandDegrees);    }},
+        {"pwmTracePath",        [this](const nlohmann::json& j) { j.at("pwmTracePath").get_to(pwmTracePath);                }},
+        {"pwmReferencePath",    [this](const nlohmann::json& j) { j.at("pwmReferencePath").get_to(pwmReferencePath);        }},
+        {"discreteChipPath",    [this](const nlohmann::json& j) { j.at("discreteChipPath").get_to(discreteChipPath);        }},
+        {"armLine",             [this](const nlohmann::json& j) { j.at("armLine").get_to(armLine);                          }},
+        {"releaseLine",         [this](const nlohmann::json& j) { j.at("releaseLine").get_to(releaseLine);                  }},
+        {"statusLine",          [this](const nlohmann::json& j) { j.at("statusLine").get_to(statusLine);                    }},
         {"gpsUnit",             [this](const nlohmann::json& j) { j.at("gpsUnit").get_to(gpsUnit);                          }},
-        {"imuUnit",             [this](const nlohmann::json& j) { j.at("imuUnit").get_to(imuUnit);                          }}
+        {"imuUnit",             [this](const nlohmann::json& j) { j.at("imuUnit").get_to(imuUnit);                          }},
+        {"pwmBackend",          [this](const nlohmann::json& j) { j.at("pwmBackend").get_to(pwmBackend);                    }}
     };
 
     /// @brief Serialize structure to json
@@ -74,6 +140,16 @@ struct Configuration : JsonType
             {"imuBaudRate",         imuBaudRate},
             {"gpsPort",             gpsPort},
             {"gpsBaudRate",         gpsBaudRate},
+            {"gpsNavigationRateHz", gpsNavigationRateHz},
+            {"gpsHighRateCovDop",   gpsHighRateCovDop},
+            {"gpsRawLogPath",       gpsRawLogPath},
+            {"gpsParserBufferSize", gpsParserBufferSize},
+            {"gpsSecondaryUnit",    gpsSecondaryUnit},
+            {"gpsSecondaryPort",    gpsSecondaryPort},
+            {"gpsSecondaryBaudRate",gpsSecondaryBaudRate},
+            {"imuCpuCore",          imuCpuCore},
+            {"imuRtPriority",       imuRtPriority},
+            {"lockMemory",          lockMemory},
             {"fin1Path",            fin1Path},
             {"fin1Channel",         fin1Channel},
             {"fin2Path",            fin2Path},
@@ -84,8 +160,26 @@ struct Configuration : JsonType
             {"fin4Channel",         fin4Channel},
             {"finMinDegrees",       finMinDegrees},
             {"finMaxDegrees",       finMaxDegrees},
+            {"fin1Calibration",     fin1Calibration},
+            {"fin2Calibration",     fin2Calibration},
+            {"fin3Calibration",     fin3Calibration},
+            {"fin4Calibration",     fin4Calibration},
+            {"fin1TrimDegrees",     fin1TrimDegrees},
+            {"fin2TrimDegrees",     fin2TrimDegrees},
+            {"fin3TrimDegrees",     fin3TrimDegrees},
+            {"fin4TrimDegrees",     fin4TrimDegrees},
+            {"actuatorRateHz",      actuatorRateHz},
+            {"finSlewRateDegPerSec",finSlewRateDegPerSec},
+            {"finDeadbandDegrees",  finDeadbandDegrees},
+            {"pwmTracePath",        pwmTracePath},
+            {"pwmReferencePath",    pwmReferencePath},
+            {"discreteChipPath",    discreteChipPath},
+            {"armLine",             armLine},
+            {"releaseLine",         releaseLine},
+            {"statusLine",          statusLine},
             {"gpsUnit",             gpsUnit},
-            {"imuUnit",             imuUnit}
+            {"imuUnit",             imuUnit},
+            {"pwmBackend",          pwmBackend}
         };
     }
 
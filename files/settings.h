@@ -26,6 +26,8 @@ struct Settings : JsonType
     std::string tmIpAddress = "224.1.1.1";
     int tmPort = 5700;
     int webPort = 8080;
+    int telemetryRateHz = 10;           // web gps messages per second until a client subscribes
+    int telemetryKeyframeMs = 1000;     // every field is resent this often, 0 = only changes
 
     // Target
     double targetLatitude       = 0.0;
@@ -46,6 +48,8 @@ struct Settings : JsonType
         {"tmIpAddress",         [this](const nlohmann::json& j) { j.at("tmIpAddress").get_to(tmIpAddress);                  }},
         {"tmPort",              [this](const nlohmann::json& j) { j.at("tmPort").get_to(tmPort);                            }},
         {"webPort",             [this](const nlohmann::json& j) { j.at("webPort").get_to(webPort);                          }},
+        {"telemetryRateHz",     [this](const nlohmann::json& j) { j.at("telemetryRateHz").get_to(telemetryRateHz);          }},
+        {"telemetryKeyframeMs", [this](const nlohmann::json& j) { j.at("telemetryKeyframeMs").get_to(telemetryKeyframeMs);  }},
         {"targetLatitude",      [this](const nlohmann::json& j) { j.at("targetLatitude").get_to(targetLatitude);            }},
         {"targetLongitude",     [this](const nlohmann::json& j) { j.at("targetLongitude").get_to(targetLongitude);          }},
         {"targetAltitudeHAE",   [this](const nlohmann::json& j) { j.at("targetAltitudeHAE").get_to(targetAltitudeHAE);      }},
@@ -63,6 +67,8 @@ struct Settings : JsonType
             {"tmIpAddress",         tmIpAddress},
             {"tmPort",              tmPort},
             {"webPort",             webPort},
+            {"telemetryRateHz",     telemetryRateHz},
+            {"telemetryKeyframeMs", telemetryKeyframeMs},
             {"targetLatitude",      targetLatitude},
             {"targetLongitude",     targetLongitude},
             {"targetAltitudeHAE",   targetAltitudeHAE},
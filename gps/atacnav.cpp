@@ -12,99 +12,138 @@
 //          ------------------              ------------------------
 #include    "atacnav.h"                     // Header
 #include    <iostream>
+#include    <algorithm>                     // max, min
+#include    <cstddef>                       // offsetof
+#include    "../utilities/checksum.h"       // byte sum
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
-AtacnavGps::AtacnavGps(LogClient& logger, const std::string ipAddress, const int port) :
-    GpsType("ATACNAV", logger, "", SerialClient::BaudRate::BAUDRATE_INVALID) 
+AtacnavGps::AtacnavGps(LogClient& logger, const std::string ipAddress, const int port, const size_t bufferSize) :
+    GpsType("ATACNAV", logger, "", SerialClient::BaudRate::BAUDRATE_INVALID),
+    m_slotSize(static_cast<uint32_t>((std::max<size_t>(bufferSize, sizeof(Atacnav::GIG::Message5007)) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE))
 {
+    m_inBuffer = AlignedBuffer(static_cast<size_t>(m_slotSize) * RX_BATCH_SIZE);
 
+    // The unicast socket is nonblocking, ProcessData() drains it in batches
+    if (m_udp.ConfigureThisClient(ipAddress, static_cast<int16_t>(port)) < 0 || m_udp.OpenUnicast() < 0)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Failed to open " + ipAddress + ":" + std::to_string(port) + " - " + m_udp.GetLastError());
+        m_initialized = false;
+        return;
+    }
+
+    m_initialized = true;
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Initialized.");
 }
 
-int AtacnavGps::ProcessData()
+AtacnavGps::~AtacnavGps()
 {
-    static unsigned int bytesInBuffer = 0;
-    static unsigned char inBuffer[BUFFER_SIZE] = {};
-    bool newData = false;
+    m_udp.CloseUnicast();
+}
 
+int AtacnavGps::ProcessData()
+{
     // Make sure we have a good socket
-    //if (!m_udp.IsGood()) return -1;
+    if (!m_udp.IsGood()) return -1;
 
-    // Attempt to read some data
-    int bytesRead = 0; // m_udp.ReceiveBroadcast(inBuffer, sizeof(inBuffer));
+    // Take everything queued on the socket, up to a batch
+    int datagrams = m_udp.ReceiveBatch(m_inBuffer.Data(), m_slotSize, RX_BATCH_SIZE, m_datagramLengths.data());
 
     // If a bad read or no data, return
-    if (bytesRead <= 0) return bytesRead;
-   
-    bytesInBuffer += bytesRead;
+    if (datagrams <= 0) return datagrams;
 
-    // If we didnt read enough for a header, return
-    if (bytesRead <= sizeof(Atacnav::GIG::Header)) return 0;
+    // A datagram arrives whole, its first and last byte share the receive time
+    const int64_t rxTimeNs = MonotonicNowNs();
+    const RxStamp stamp = { rxTimeNs, rxTimeNs };
 
-    // Attempt to process the data
-    unsigned char* bufferPtr = inBuffer;
-    while (bytesInBuffer >= sizeof(Atacnav::GIG::Header))
+    // Newest valid message of each type, viewed in place until the batch is done
+    const Atacnav::GIG::Message5007* latest5007 = nullptr;
+    const Atacnav::GIG::Message5010* latest5010 = nullptr;
+    const unsigned long errorsAtStart = m_data.rxErrorCount;
+
+    for (int i = 0; i < datagrams; i++)
     {
-        // Extract header
-        Atacnav::GIG::Header* tempHeader = reinterpret_cast<Atacnav::GIG::Header*>(bufferPtr);
-
-        // Validate sync bytes
-        if ((tempHeader->Sync1 != Atacnav::GIG::SYNC_1) ||
-            (tempHeader->Sync2 != Atacnav::GIG::SYNC_2) ||
-            (tempHeader->Sync3 != Atacnav::GIG::SYNC_3) ||
-            (tempHeader->Sync4 != Atacnav::GIG::SYNC_4))
-        {
-            // Incorrect sync bytes, discard the message
-            bufferPtr += 1; // Move to the next byte
-            bytesInBuffer -= 1;
-            continue;
-        }
+        const uint8_t* datagram = m_inBuffer.Data() + static_cast<size_t>(i) * m_slotSize;
+        const size_t length = std::min<size_t>(m_datagramLengths[i], m_slotSize);
+        size_t offset = 0;
 
-        // Check if we have enough bytes for the whole message
-        if (bytesInBuffer < tempHeader->ByteCount) 
+        while (length - offset >= sizeof(Atacnav::GIG::Header))
         {
-            // Insufficient data, wait for more
-            break;
+            const Atacnav::GIG::Header* header = reinterpret_cast<const Atacnav::GIG::Header*>(datagram + offset);
+
+            // Validate sync bytes
+            if ((header->Sync1 != Atacnav::GIG::SYNC_1) ||
+                (header->Sync2 != Atacnav::GIG::SYNC_2) ||
+                (header->Sync3 != Atacnav::GIG::SYNC_3) ||
+                (header->Sync4 != Atacnav::GIG::SYNC_4))
+            {
+                // Incorrect sync bytes, move to the next byte
+                offset += 1;
+                continue;
+            }
+
+            // A message never spans datagrams, a short or oversize count ends this one
+            if (header->ByteCount < static_cast<int16_t>(sizeof(Atacnav::GIG::Header)) ||
+                static_cast<size_t>(header->ByteCount) > length - offset)
+            {
+                m_data.rxErrorCount++;
+                break;
+            }
+
+            // Determine the message type based on MessageId
+            switch (header->MessageId)
+            {
+            case static_cast<int>(Atacnav::GIG::MSG_ID::MSG_5007):
+                if (const auto* message = ValidateMessage<Atacnav::GIG::Message5007>(header, m_data.msg5007ChecksumErrorCount))
+                {
+                    // Process PPS_SYNC_NAV message
+                    latest5007 = message;
+                    m_data.msg5007RxCount++;
+                    RecordRxLatency(GpsMessageKey(GpsProtocol::Atacnav, header->MessageId), stamp);
+                }
+                break;
+            case static_cast<int>(Atacnav::GIG::MSG_ID::MSG_5010):
+                if (const auto* message = ValidateMessage<Atacnav::GIG::Message5010>(header, m_data.msg5010ChecksumErrorCount))
+                {
+                    // Process BLENDED_PPS_NAV message
+                    latest5010 = message;
+                    m_data.msg5010RxCount++;
+                    RecordRxLatency(GpsMessageKey(GpsProtocol::Atacnav, header->MessageId), stamp);
+                }
+                break;
+            default:
+                // Unknown message type, skip it whole
+                m_data.rxErrorCount++;
+                break;
+            }
+
+            offset += header->ByteCount;
         }
+    }
 
-        // Determine the message type based on MessageId
-        switch (tempHeader->MessageId)
-        {
-        case static_cast<int>(Atacnav::GIG::MSG_ID::MSG_5007):
-        {
-            // Process PPS_SYNC_NAV message
-            std::memcpy(&m_data.lastReceived5007, bufferPtr, sizeof(Atacnav::GIG::Message5007));
-            bufferPtr += sizeof(Atacnav::GIG::Message5007);
-            bytesInBuffer -= sizeof(Atacnav::GIG::Message5007);
-            m_data.msg5007RxCount++;
-            newData = true;
-        }
-        break;
-        case static_cast<int>(Atacnav::GIG::MSG_ID::MSG_5010):
-        {
-            // Process BLENDED_PPS_NAV message
-            std::memcpy(&m_data.lastReceived5010, bufferPtr, sizeof(Atacnav::GIG::Message5010));
-            bufferPtr += sizeof(Atacnav::GIG::Message5010);
-            bytesInBuffer -= sizeof(Atacnav::GIG::Message5010);
-            m_data.msg5010RxCount++;
-            newData = true;
-        }
-        break;
-        default:
-            // Unknown message type, discard the message
-            bufferPtr += 1; // Move to the next byte
-            bytesInBuffer -= 1;
-            m_commonData.rxErrorCount++;
-            continue;
-        }
+    // Keep one copy per batch for telemetry, the slots are reused by the next receive
+    if (latest5007 != nullptr)
+    {
+        m_data.lastReceived5007 = *latest5007;
+        m_data.msg5007DataValid = true;
     }
 
-    // Move any remaining data to the beginning of the buffer
-    if (bytesInBuffer > 0 && bufferPtr != inBuffer)
-        std::memmove(inBuffer, bufferPtr, bytesInBuffer);
+    if (latest5010 != nullptr)
+    {
+        m_data.lastReceived5010 = *latest5010;
+        m_data.last5010RxStamp = stamp;
+        m_data.msg5010DataValid = true;
+    }
+
+    // Errors are counted on this thread and only reach the common data under its lock
+    if (m_data.rxErrorCount != errorsAtStart)
+    {
+        std::scoped_lock lock(m_commonDataMutex);
+        m_commonData.rxErrorCount = static_cast<long>(m_data.rxErrorCount);
+    }
 
     // Update the common data if we got new data
-    if (newData)
+    if (latest5007 != nullptr || latest5010 != nullptr)
     {
         UpdateCommonData();
         return 1;
@@ -114,19 +153,59 @@ int AtacnavGps::ProcessData()
     return 0;
 }
 
+template <typename Message>
+const Message* AtacnavGps::ValidateMessage(const Atacnav::GIG::Header* header, unsigned long& checksumErrorCount)
+{
+    if (header->ByteCount != static_cast<int16_t>(sizeof(Message)))
+    {
+        m_data.rxErrorCount++;
+        return nullptr;
+    }
+
+    // Checksum is the unsigned 16-bit sum of every byte ahead of it
+    const Message* message = reinterpret_cast<const Message*>(header);
+    if (ByteSum16(reinterpret_cast<const uint8_t*>(message), offsetof(Message, checksum)) != message->checksum)
+    {
+        checksumErrorCount++;
+        m_data.rxErrorCount++;
+        return nullptr;
+    }
+
+    return message;
+}
+
 GpsData AtacnavGps::GetCommonData()
 {
+    std::scoped_lock lock(m_commonDataMutex);
     return m_commonData;
 }
 
 void AtacnavGps::UpdateCommonData()
 {
+    std::scoped_lock lock(m_commonDataMutex);
+
     m_commonData.latitude = m_data.lastReceived5010.latitude * two_31;
     m_commonData.longitude = m_data.lastReceived5010.longitude * two_31;
     m_commonData.altitude = m_data.lastReceived5010.altitudeHae * two_7;
 
+    // a blended solution in navigation mode is treated as a 3D fix
+    const Atacnav::GIG::BlendedPpsStatus& status = m_data.lastReceived5010.blendedStatus;
+    m_commonData.fixType = (status.bits.systemMode == 3 && status.bits.gpsBitFail == 0) ? 3 : 0;
+    m_commonData.horizontalAccuracy = m_data.lastReceived5010.ehe / two_3;
+    m_commonData.verticalAccuracy = m_data.lastReceived5010.eve / two_3;
+
+    // the 5007 velocity is at the IMU and resolved finer than the blended one
+    const Atacnav::GIG::Message5007& nav = m_data.lastReceived5007;
+    m_commonData.velocityNorth = nav.northVelocity / two_18;
+    m_commonData.velocityEast = nav.eastVelocity / two_18;
+    m_commonData.velocityDown = nav.downVelocity / two_18;
+    m_commonData.velocityValid = nav.validity.bits.velocityValid;
+
     ConvertSecondsToHMS(m_data.lastReceived5010.utcTimeOfPps, m_commonData.hour, 
             m_commonData.min, m_commonData.sec);
 
     m_commonData.rxCount = m_data.msg5007RxCount + m_data.msg5010RxCount;
+    m_commonData.rxErrorCount = static_cast<long>(m_data.rxErrorCount);
+    m_commonData.rxFirstByteNs = m_data.last5010RxStamp.firstByteNs;
+    m_commonData.rxLastByteNs = m_data.last5010RxStamp.lastByteNs;
 }
\ No newline at end of file
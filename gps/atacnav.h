@@ -11,10 +11,12 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include <string>                           // strings
+#include <array>                            // datagram lengths
 //
 #include "gps_type.h"                       // base class
 #include "atacnav_info.h"                   // atacnav info
-//#include "../utilities/udp_client.h"        // UDP comms
+#include "../utilities/aligned_buffer.h"    // receive slots
+#include "../utilities/udp_client.h"        // UDP comms
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -25,9 +27,11 @@ struct AtacnavData
     unsigned long     msg5007ChecksumErrorCount;
     unsigned long     msg5010RxCount;
     unsigned long     msg5010ChecksumErrorCount;
+    unsigned long     rxErrorCount;     // framing, size and checksum errors, receiver thread only
 
     Atacnav::GIG::Message5007   lastReceived5007; // whole msg for TM; most recently received (with valid checksum)
     Atacnav::GIG::Message5010   lastReceived5010; // whole msg for TM; most recently received (with valid checksum)
+    RxStamp                     last5010RxStamp;  // receive stamp of lastReceived5010
 
     double ppsTow;                 // ToV of data, GPS ToW of 1-PPS, seconds
     double lat;                    // rad
@@ -57,10 +61,13 @@ class AtacnavGps : public GpsType
 public:
 
     /// @brief 
-    AtacnavGps(LogClient& logger, const std::string ipAddress, const int port);
+    /// @param ipAddress - [in] - Local address to receive GIG datagrams on
+    /// @param port - [in] - Local port to receive GIG datagrams on
+    /// @param bufferSize - [in/opt] - Size of each datagram receive slot
+    AtacnavGps(LogClient& logger, const std::string ipAddress, const int port, const size_t bufferSize = BUFFER_SIZE);
 
     /// @brief 
-    ~AtacnavGps() {}
+    ~AtacnavGps();
 
     /// @brief 
     int ProcessData() override;
@@ -76,9 +83,25 @@ private:
     /// @brief 
     void UpdateCommonData() override;
 
+    /// @brief Validate one GIG message in place, the result is a view into the receive slot
+    /// @tparam Message - GIG message type expected for the header
+    /// @param header - [in] - header of the message, ByteCount already bounds checked
+    /// @param checksumErrorCount - [in/out] - counter for the message type
+    /// @return view of the message if the size and checksum are good, else nullptr
+    template <typename Message>
+    const Message* ValidateMessage(const Atacnav::GIG::Header* header, unsigned long& checksumErrorCount);
+
+    /// Datagrams taken from the socket per ProcessData() call
+    static constexpr uint32_t RX_BATCH_SIZE = 16;
+
     // UDP items
-    //UdpClient m_udp;
+    UdpClient m_udp;
 
     /// Data storage
     AtacnavData m_data = {};
+
+    // Receive slots, each starts on a cache line so message views are aligned
+    alignas(CACHE_LINE_SIZE) AlignedBuffer m_inBuffer;      /// RX_BATCH_SIZE slots of m_slotSize
+    uint32_t            m_slotSize          = 0;            /// Bytes per receive slot
+    std::array<uint32_t, RX_BATCH_SIZE> m_datagramLengths = {};   /// Length of each datagram in the batch
 };
\ No newline at end of file
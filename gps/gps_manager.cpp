@@ -1,4 +1,3 @@
-
 /////////////////////////////////////////////////////////////////////////////////
 // @file            gps_manager.cpp
 // @brief           Implementation for the gps manager
@@ -11,12 +10,12 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include    "gps_manager.h"                 // Header
-// 
+//
 /////////////////////////////////////////////////////////////////////////////////
 
 GpsManager::GpsManager(LogClient& logger) : m_currentGpsType(GpsOptions::Unknown), m_name("GPS MGR"),
-    m_configured(false), m_logger(logger), m_port(""), m_baudrate(SerialClient::BaudRate::BAUDRATE_INVALID), 
-    m_run(false), m_initComplete(false)
+    m_configured(false), m_logger(logger), m_port(""), m_baudrate(SerialClient::BaudRate::BAUDRATE_INVALID),
+    m_run(false), m_initComplete(false), m_selectedIndex(-1), m_selectedUpdates(0), m_selected(), m_topic(nullptr)
 {
     m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Initialized.");
 }
@@ -32,12 +31,13 @@ GpsManager::~GpsManager()
     Stop();
 }
 
-bool GpsManager::Configure(const GpsOptions option, const std::string port, const SerialClient::BaudRate baudrate)
+bool GpsManager::Configure(const GpsOptions option, const std::string port, const SerialClient::BaudRate baudrate,
+    const int navigationRateHz, const bool includeCovDop, const size_t bufferSize)
 {
     bool rtn = false;
 
     // If the requested option is the same as the current option, return true
-    if (m_gps && option == m_currentGpsType)
+    if (!m_receivers.empty() && option == m_currentGpsType)
     {
         m_logger.AddLog(m_name, LogClient::LogLevel::Error, "GPS already configured with the same option.");
         return true; // Already configured with the same option, so return true
@@ -55,34 +55,109 @@ bool GpsManager::Configure(const GpsOptions option, const std::string port, cons
         return false;
     }
 
-    // Validate the serial port
-    std::string portUpdate = ValidateSerialPort(port);
+    // Reconfiguring the primary starts the receiver set over
+    Stop();
+    m_receivers.clear();
+    m_selectedIndex = -1;
 
-    switch (option)
+    std::unique_ptr<GpsType> gps = CreateGps(option, port, baudrate, navigationRateHz, includeCovDop, bufferSize);
+    if (!gps)
     {
-    case GpsOptions::Ublox:
-        m_gps = std::make_unique<UbloxGps>(m_logger, portUpdate, baudrate);
-        break;
-    case GpsOptions::Novatel:
-        //m_gps = std::make_unique<Novatel>(m_logger, portUpdate, baudrate);
-        break;
-    case GpsOptions::Unknown:
-        // Intentional fall through
-    default:
-        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Unsupported GPS option selected.");
         m_currentGpsType = GpsOptions::Unknown;
-        m_gps = nullptr;
-    };
+        m_initComplete = true;
+        m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Failed to configure");
+        return false;
+    }
 
     // Make sure the gps unit is initialized
-    rtn = m_gps->Initialized();
+    rtn = gps->Initialized();
     m_initComplete = true;
 
+    auto receiver = std::make_unique<Receiver>();
+    receiver->option = option;
+    receiver->gps = std::move(gps);
+    m_receivers.push_back(std::move(receiver));
+
     if (rtn) { m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Configured"); }
     else { m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Failed to configure"); }
     return rtn;
 }
 
+bool GpsManager::AddReceiver(const GpsOptions option, const std::string port, const SerialClient::BaudRate baudrate, const size_t bufferSize)
+{
+    if (m_run)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Receivers cannot be added while running.");
+        return false;
+    }
+
+    if (port.empty())
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "GPS Port is empty in AddReceiver()");
+        return false;
+    }
+
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Adding receiver " + GpsOptionsMap.at(option));
+
+    std::unique_ptr<GpsType> gps = CreateGps(option, port, baudrate, 0, false, bufferSize);
+    if (!gps || !gps->Initialized())
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Failed to add receiver " + GpsOptionsMap.at(option));
+        return false;
+    }
+
+    auto receiver = std::make_unique<Receiver>();
+    receiver->option = option;
+    receiver->gps = std::move(gps);
+    m_receivers.push_back(std::move(receiver));
+
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Receiver " + std::to_string(m_receivers.size() - 1) + " added");
+    return true;
+}
+
+std::unique_ptr<GpsType> GpsManager::CreateGps(const GpsOptions option, const std::string& port, const SerialClient::BaudRate baudrate,
+    const int navigationRateHz, const bool includeCovDop, const size_t bufferSize)
+{
+    switch (option)
+    {
+    case GpsOptions::Ublox:
+    {
+        Ublox::NAV_PROFILE profile = Ublox::NAV_PROFILE::STANDARD;
+        switch (navigationRateHz)
+        {
+        case 0:  profile = Ublox::NAV_PROFILE::STANDARD;    break;
+        case 10: profile = Ublox::NAV_PROFILE::HZ10;        break;
+        case 20: profile = Ublox::NAV_PROFILE::HZ20;        break;
+        case 25: profile = Ublox::NAV_PROFILE::HZ25;        break;
+        default:
+            m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Unsupported navigation rate " + std::to_string(navigationRateHz) + "Hz, using standard profile.");
+        }
+        return std::make_unique<UbloxGps>(m_logger, ValidateSerialPort(port), baudrate, profile, includeCovDop, includeCovDop,
+            bufferSize > 0 ? bufferSize : Ublox::FRAME_BUFFER_SIZE);
+    }
+    case GpsOptions::Atacnav:
+    {
+        // network unit, port is "address:port"
+        size_t split = port.rfind(':');
+        if (split == std::string::npos)
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Atacnav port must be address:port, got " + port);
+            return nullptr;
+        }
+        return std::make_unique<AtacnavGps>(m_logger, port.substr(0, split), std::atoi(port.substr(split + 1).c_str()),
+            bufferSize > 0 ? bufferSize : BUFFER_SIZE);
+    }
+    case GpsOptions::Novatel:
+        return std::make_unique<NovatelGps>(m_logger, ValidateSerialPort(port), baudrate, navigationRateHz > 0 ? navigationRateHz : 1,
+            bufferSize > 0 ? bufferSize : Novatel::FRAME_BUFFER_SIZE);
+    case GpsOptions::Unknown:
+        // Intentional fall through
+    default:
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Unsupported GPS option selected.");
+        return nullptr;
+    };
+}
+
 bool GpsManager::AutoConfigure()
 {
     // List of GPS options to iterate through
@@ -93,22 +168,24 @@ bool GpsManager::AutoConfigure()
     {
         m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Attempting to auto-configure for " + GpsOptionsMap.at(option));
 
-        // Configure the m_gps pointer
+        // Configure the primary receiver
         if (!Configure(option, m_port, m_baudrate))
         {
             m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Failed to configure GPS option: " + GpsOptionsMap.at(option));
             continue; // Try next GPS option
         }
 
+        GpsType* gps = m_receivers.front()->gps.get();
+
         // Wait for specified timeout seconds to attempt to get data
         auto startTime = std::chrono::steady_clock::now();
         while (std::chrono::steady_clock::now() - startTime < std::chrono::seconds(AUTO_DISCOVERY_TIMEOUT_SECS))
         {
             // Process data continuously
-            m_gps->ProcessData();
+            gps->ProcessData();
 
             // Check if data is received
-            if (m_gps->GetCommonData().rxCount > 0)
+            if (gps->GetCommonData().rxCount > 0)
             {
                 m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Auto-configuration successful for " + GpsOptionsMap.at(option));
                 return true; // Data received, configuration successful
@@ -134,29 +211,185 @@ bool GpsManager::IsInitializationComplete()
 
 void GpsManager::Start()
 {
+    if (m_run) return;
     m_run = true;
 
-    while (m_run)
+    // each receiver parses on its own thread so a stalled unit cannot hold up the others
+    for (auto& receiver : m_receivers)
     {
-        // Look for new data
-        Read();
-
-        // Rest 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        receiver->thread = std::thread(&GpsManager::ReceiverLoop, this, std::ref(*receiver));
     }
 }
 
 int GpsManager::Read()
 {
-    return m_gps->ProcessData();
+    if (m_receivers.empty()) return -1;
+
+    // without receiver threads poll everything inline
+    if (!m_run)
+    {
+        for (auto& receiver : m_receivers)
+        {
+            PollReceiver(*receiver);
+        }
+    }
+
+    const int64_t now = MonotonicNowNs();
+
+    int         bestIndex       = -1;
+    int         bestRank        = -1;
+    double      bestAccuracy    = 0.0;
+    int64_t     bestAge         = 0;
+    uint64_t    bestUpdates     = 0;
+    GpsData     bestData        = {};
+
+    for (size_t i = 0; i < m_receivers.size(); i++)
+    {
+        Receiver& receiver = *m_receivers[i];
+        std::scoped_lock lock(receiver.mutex);
+
+        if (receiver.updates == 0) continue;
+
+        // stale once a solution is half an interval overdue, one epoch is all failover waits
+        const int64_t age = now - receiver.lastUpdateNs;
+        const int64_t interval = receiver.intervalNs > 0 ? receiver.intervalNs : 1000000000;
+        if (age > interval + interval / 2) continue;
+
+        // unknown accuracy sorts behind any reported accuracy
+        const int rank = FixRank(receiver.latest.fixType);
+        const double accuracy = receiver.latest.horizontalAccuracy > 0.0 ? receiver.latest.horizontalAccuracy : 1e9;
+
+        bool better = false;
+        if (rank != bestRank)               better = rank > bestRank;
+        else if (accuracy != bestAccuracy)  better = accuracy < bestAccuracy;
+        else                                better = age < bestAge;
+
+        if (bestIndex < 0 || better)
+        {
+            bestIndex = static_cast<int>(i);
+            bestRank = rank;
+            bestAccuracy = accuracy;
+            bestAge = age;
+            bestUpdates = receiver.updates;
+            bestData = receiver.latest;
+        }
+    }
+
+    // nothing usable, keep the last selection for consumers but report no new epoch
+    if (bestIndex < 0)
+    {
+        if (m_selectedIndex >= 0)
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "No usable GPS receiver.");
+            m_selectedIndex = -1;
+        }
+        return 0;
+    }
+
+    const bool switched = bestIndex != m_selectedIndex;
+    if (switched)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Selected receiver " + std::to_string(bestIndex) +
+            " (" + GpsOptionsMap.at(m_receivers[bestIndex]->option) + ")");
+        m_selectedIndex = bestIndex;
+    }
+    else if (bestUpdates == m_selectedUpdates)
+    {
+        return 0;
+    }
+
+    m_selectedUpdates = bestUpdates;
+    {
+        std::scoped_lock lock(m_selectedMutex);
+        m_selected = bestData;
+    }
+
+    if (m_topic != nullptr) m_topic->Publish(bestData);
+    return 1;
 }
 
 void GpsManager::Stop()
 {
     m_run = false;
+
+    for (auto& receiver : m_receivers)
+    {
+        if (receiver->thread.joinable()) receiver->thread.join();
+    }
 }
 
 GpsData GpsManager::GetCommonData()
 {
-    return m_gps->GetCommonData();
+    std::scoped_lock lock(m_selectedMutex);
+    return m_selected;
+}
+
+int GpsManager::PollReceiver(Receiver& receiver)
+{
+    int rtn = receiver.gps->ProcessData();
+    if (rtn <= 0) return rtn;
+
+    GpsData data = receiver.gps->GetCommonData();
+    const int64_t now = MonotonicNowNs();
+
+    std::scoped_lock lock(receiver.mutex);
+
+    // smooth the interval so a single late solution does not widen the staleness window
+    if (receiver.lastUpdateNs > 0)
+    {
+        const int64_t interval = now - receiver.lastUpdateNs;
+        receiver.intervalNs = receiver.intervalNs > 0 ? (receiver.intervalNs * 7 + interval) / 8 : interval;
+    }
+
+    receiver.latest = data;
+    receiver.lastUpdateNs = now;
+    receiver.updates++;
+    return rtn;
+}
+
+void GpsManager::ReceiverLoop(Receiver& receiver)
+{
+    while (m_run)
+    {
+        // Look for new data, keep polling while a unit has more buffered
+        if (PollReceiver(receiver) > 0) continue;
+
+        // Rest
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+int GpsManager::FixRank(const int fixType)
+{
+    switch (fixType)
+    {
+    case 3:     // 3D
+    case 4:     // GNSS + dead reckoning
+        return 3;
+    case 2:     // 2D
+        return 2;
+    case 1:     // dead reckoning only
+        return 1;
+    default:    // no fix, time only
+        return 0;
+    }
+}
+
+bool GpsManager::EnableRawMeasurements(const std::string& path)
+{
+    // only the ublox driver supports raw measurements
+    UbloxGps* ublox = m_receivers.empty() ? nullptr : dynamic_cast<UbloxGps*>(m_receivers.front()->gps.get());
+    if (ublox == nullptr)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Raw measurements not supported by " + GpsOptionsMap.at(m_currentGpsType));
+        return false;
+    }
+
+    return ublox->EnableRawMeasurements(path) == 0;
+}
+
+std::unordered_map<uint32_t, LatencyHistogram> GpsManager::GetRxLatency()
+{
+    if (m_receivers.empty()) return {};
+    return m_receivers.front()->gps->GetRxLatency();
 }
\ No newline at end of file
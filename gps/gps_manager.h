@@ -12,11 +12,17 @@
 //          ------------------              ------------------------
 #include <string>                           // strings
 #include <unordered_map>                    // unordered map
+#include <vector>                           // receivers
+#include <memory>                           // unique ptr
+#include <thread>                           // receiver threads
+#include <mutex>                            // mutex
+#include <atomic>                           // atomics
 //
 #include "../utilities/log_client.h"        // logger
 #include "../utilities/constants.h"         // Auto discovery timeout 
 #include "ublox.h"                          // ublox gps
 #include "novatel.h"                        // novatel gps
+#include "atacnav.h"                        // atacnav gps
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -41,12 +47,24 @@ public:
     /// @brief Default deconstructor
     ~GpsManager();
 
-    /// @brief Configure the serial port for the desired GPS unit
+    /// @brief Configure the primary GPS unit, replaces all configured receivers
     /// @param option - desired GPS to be used
     /// @param port - in - port to connect to for communications
     /// @param baudrate - in - baudrate for the connection
+    /// @param navigationRateHz - in - opt - high rate navigation solution rate, ublox 10/20/25, novatel INSPVAX rate. 0 keeps the unit default
+    /// @param includeCovDop - in - opt - keep covariance and DOP messages in a high rate output set
+    /// @param bufferSize - in - opt - parser buffer size in bytes, 0 keeps the unit default
     /// @return - true if successful, false if already configured and connection is opened. 
-    bool Configure(const GpsOptions option, const std::string port, const SerialClient::BaudRate baudrate);
+    bool Configure(const GpsOptions option, const std::string port, const SerialClient::BaudRate baudrate,
+        const int navigationRateHz = 0, const bool includeCovDop = false, const size_t bufferSize = 0);
+
+    /// @brief Add a redundant GPS unit that runs alongside the primary on its own I/O path
+    /// @param option - in - desired GPS to be used
+    /// @param port - in - serial port, or "address:port" for network units
+    /// @param baudrate - in - baudrate for serial units
+    /// @param bufferSize - in - opt - parser buffer size in bytes, 0 keeps the unit default
+    /// @return - true if the receiver initialized and was added, else false
+    bool AddReceiver(const GpsOptions option, const std::string port, const SerialClient::BaudRate baudrate, const size_t bufferSize = 0);
 
     /// @brief Ability for manager to auto detect the GPS unit and the GPS units baudrate
     /// @return true if successful connected to a gps unit, else false
@@ -56,19 +74,38 @@ public:
     /// @return true if complete, else false
     bool IsInitializationComplete();
 
-    /// @brief Start the connection to the GPS and poll it for data in an endless loop
+    /// @brief Start a polling thread for every configured receiver
     void Start();
 
-    /// @brief Read for new data from the configured GPS unit. 
-    /// @return -1 on error, 0 on nothing read, 1 if data was processed. 
+    /// @brief Publish every newly selected solution on a topic
+    /// @param topic - in - topic to publish on, nullptr to stop publishing
+    void SetTopic(GpsTopic* topic) { m_topic = topic; }
+
+    /// @brief Select the best solution across the receivers. Receivers are polled here
+    /// when Start() has not been called.
+    /// @return -1 on error, 0 on no new epoch, 1 if a new epoch was selected. 
     int Read();
 
-    /// @brief Stop the main working loop if it was started
+    /// @brief Stop and join the receiver threads if they were started
     void Stop();
 
-    // Accessible variables
+    /// @brief Get the selected solution
+    /// @return copy of the selected GpsData
     GpsData GetCommonData();
 
+    /// @brief Get the index of the receiver the selected solution came from
+    /// @return receiver index, -1 if none is usable
+    int GetSelectedReceiver() const { return m_selectedIndex; }
+
+    /// @brief Start recording raw measurements on units that support it
+    /// @param path - in - recording path without extension
+    /// @return true if recording started, false if unsupported or failed
+    bool EnableRawMeasurements(const std::string& path);
+
+    /// @brief Get the receive latency histograms of the configured GPS unit
+    /// @return histograms keyed by GpsMessageKey, empty if no unit is configured
+    std::unordered_map<uint32_t, LatencyHistogram> GetRxLatency();
+
 protected:
 
 private:
@@ -82,14 +119,56 @@ private:
         {GpsOptions::Atacnav,   "Atacnav"},
     };
 
-    GpsOptions                  m_currentGpsType;   /// Current GPS type 
+    /// @brief A GPS unit and its latest solution as seen by the selection stage
+    struct Receiver
+    {
+        GpsOptions                  option          = GpsOptions::Unknown;
+        std::unique_ptr<GpsType>    gps;                        /// The unit, owns its own I/O
+        std::thread                 thread;                     /// Polling thread when started
+        std::mutex                  mutex;                      /// Protects the fields below
+        GpsData                     latest          = {};       /// Latest solution
+        int64_t                     lastUpdateNs    = 0;        /// Monotonic time of the latest solution
+        int64_t                     intervalNs      = 0;        /// Smoothed interval between solutions
+        uint64_t                    updates         = 0;        /// Number of solutions received
+    };
+
+    /// @brief Create a GPS unit
+    /// @param option - in - desired GPS to be used
+    /// @param port - in - serial port, or "address:port" for network units
+    /// @param baudrate - in - baudrate for serial units
+    /// @param navigationRateHz - in - high rate navigation solution rate, 0 keeps the unit default
+    /// @param includeCovDop - in - keep covariance and DOP messages in a high rate output set
+    /// @param bufferSize - in - parser buffer size in bytes, 0 keeps the unit default
+    /// @return the unit, nullptr if unsupported
+    std::unique_ptr<GpsType> CreateGps(const GpsOptions option, const std::string& port, const SerialClient::BaudRate baudrate,
+        const int navigationRateHz, const bool includeCovDop, const size_t bufferSize);
+
+    /// @brief Poll a receiver once and latch its solution if a new one was processed
+    /// @param receiver - in - receiver to poll
+    /// @return result of the units ProcessData()
+    int PollReceiver(Receiver& receiver);
+
+    /// @brief Polling loop for a receiver thread
+    /// @param receiver - in - receiver to poll
+    void ReceiverLoop(Receiver& receiver);
+
+    /// @brief Rank a fix type, higher is better
+    /// @param fixType - in - fix type in GpsData convention
+    /// @return rank, 0 for no usable position
+    static int FixRank(const int fixType);
+
+    GpsOptions                  m_currentGpsType;   /// Current GPS type of the primary
     std::string                 m_name;             /// Name for logging
     bool                        m_configured;       /// Flag for if the class is configured
     LogClient&                  m_logger;           /// Logger
-    std::string                 m_port;             /// Holds the port
-    SerialClient::BaudRate      m_baudrate;         /// Holds the baudrate
-    std::unique_ptr<GpsType>    m_gps;              /// Holds a pointer to the utilizes GPS type.  
-    SerialClient                m_commPort;         /// Holds connection to serial port
-    std::atomic_bool            m_run;              /// Holds an bool to kill the main loop
+    std::string                 m_port;             /// Holds the port of the primary
+    SerialClient::BaudRate      m_baudrate;         /// Holds the baudrate of the primary
+    std::vector<std::unique_ptr<Receiver>> m_receivers; /// Receivers, primary first
+    std::atomic_bool            m_run;              /// Holds an bool to kill the receiver loops
     std::atomic_bool            m_initComplete;     /// Holds flag indicating if initialization is complete.
+    std::atomic_int             m_selectedIndex;    /// Receiver of the selected solution
+    uint64_t                    m_selectedUpdates;  /// Update count of the selected solution when last read
+    GpsData                     m_selected;         /// Selected solution
+    std::mutex                  m_selectedMutex;    /// Protects m_selected
+    GpsTopic*                   m_topic;            /// Topic selected solutions are published on, nullptr for none
 };
\ No newline at end of file
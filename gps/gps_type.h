@@ -11,10 +11,14 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include <string>                           // strings
+#include <mutex>                            // mutex
+#include <unordered_map>                    // latency histograms
 //
 #include "../utilities/serial_client.h"     // serial client
+#include "../utilities/rx_timing.h"         // receive stamps
 #include "../utilities/log_client.h"        // log client
 #include "../utilities/constants.h"         // Auto discovery timeout 
+#include "../utilities/topic.h"             // gps topic
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -28,6 +32,28 @@ struct GpsData
     double  longitude       = 0.0;
     double  altitude        = 0.0;
 
+    int     fixType             = 0;    // 0 no fix, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS + dead reckoning, 5 time only
+    double  horizontalAccuracy  = 0.0;  // m, 0 when the unit does not report it
+    double  verticalAccuracy    = 0.0;  // m, 0 when the unit does not report it
+
+    double  velocityNorth       = 0.0;  // m/s
+    double  velocityEast        = 0.0;  // m/s
+    double  velocityDown        = 0.0;  // m/s
+    bool    velocityValid       = false;// unit reported a velocity with this solution
+    double  speedAccuracy       = 0.0;  // m/s, 0 when the unit does not report it
+
+    // NED covariance upper triangles, NN NE ND EE ED DD
+    double  positionCovariance[6]   = {};       // m^2
+    double  velocityCovariance[6]   = {};       // m^2/s^2
+    bool    positionCovarianceValid = false;    // positionCovariance belongs to this solution
+    bool    velocityCovarianceValid = false;    // velocityCovariance belongs to this solution
+
+    double  navRateHz       = 0.0;      // achieved navigation solution rate
+    long    droppedCount    = 0;        // navigation solutions missed by the receiver link
+
+    int64_t rxFirstByteNs   = 0;        // monotonic time the first byte of the solution was read
+    int64_t rxLastByteNs    = 0;        // monotonic time the last byte of the solution was read
+
     bool    hardwareError   = false;    // @todo fix these with some proper error types ??? 
     bool    softwareError   = false;    // @todo fix these with some proper error types ??? 
 
@@ -37,6 +63,27 @@ struct GpsData
     long    rxErrorCount    = 0;        // receive error count
 };
 
+/// @brief Bus topic for GpsData, over half a second at 25Hz for queued subscribers
+using GpsTopic = Topic<GpsData, 16>;
+
+/// @brief Protocol a received message was framed from, the top byte of a latency key
+enum class GpsProtocol : uint8_t
+{
+    Ubx     = 1,
+    Nmea    = 2,
+    Atacnav = 3,
+    Novatel = 4,
+};
+
+/// @brief Build a latency key for a message type
+/// @param protocol - [in] - protocol the message was framed from
+/// @param messageId - [in] - protocol message id, lower 24 bits are used
+/// @return key for the per message latency histograms
+constexpr uint32_t GpsMessageKey(GpsProtocol protocol, uint32_t messageId)
+{
+    return (static_cast<uint32_t>(protocol) << 24) | (messageId & 0x00FFFFFF);
+}
+
 /// @brief The base class for a GPS unit for WASP
 class GpsType
 {
@@ -135,8 +182,27 @@ public:
     /// @returntrue for successfully initalized, else false 
     bool Initialized() const { return m_initialized; }
 
+    /// @brief Get a copy of the receive latency histograms, first byte read to message handled
+    /// @return histograms keyed by GpsMessageKey
+    std::unordered_map<uint32_t, LatencyHistogram> GetRxLatency()
+    {
+        std::scoped_lock lock(m_rxLatencyMutex);
+        return m_rxLatency;
+    }
+
 protected:
 
+    /// @brief Record the latency of a handled message against its message type
+    /// @param key - [in] - message key from GpsMessageKey
+    /// @param stamp - [in] - receive stamp of the message
+    void RecordRxLatency(uint32_t key, const RxStamp& stamp)
+    {
+        if (stamp.firstByteNs == 0) return;
+
+        std::scoped_lock lock(m_rxLatencyMutex);
+        m_rxLatency[key].Record(MonotonicNowNs() - stamp.firstByteNs);
+    }
+
     /// @brief Necessary function to update common data that all GPS units must provide
     virtual void UpdateCommonData() = 0;
 
@@ -157,4 +223,7 @@ protected:
     SerialClient            m_comms;                            /// Holds the serial client
     bool                    m_initialized       = false;        /// Bool to hold if the gps unit is initialized correctly
     std::mutex              m_commonDataMutex   = {};           /// Safety for common data
+    RxTimeline              m_rxTimeline        = {};           /// Read times of the bytes in the parse buffer
+    std::unordered_map<uint32_t, LatencyHistogram> m_rxLatency = {};   /// Latency per message type
+    std::mutex              m_rxLatencyMutex    = {};           /// Safety for latency histograms
 };
\ No newline at end of file
@@ -1,4 +1,3 @@
-
 /////////////////////////////////////////////////////////////////////////////////
 // @file            novatel.cpp
 // @brief           Implementation for the novatel GPS class
@@ -10,21 +9,458 @@
 // Includes:
 //          name                            reason included
 //          ------------------              ------------------------
+#include    <algorithm>                     // max, min
+#include    <cmath>                         // hypot, fmod, sin, cos
+#include    <numbers>                       // pi
+#include    <cstring>                       // memchr, memmove
+//
 #include    "novatel.h"                     // Header
-// 
+#include    "../utilities/checksum.h"       // crc32
+//
 /////////////////////////////////////////////////////////////////////////////////
 
-int Novatel::ProcessData()
+NovatelGps::NovatelGps(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate,
+    const int navigationRateHz, const size_t bufferSize) :
+    GpsType("NOVATEL", logger, path, baudrate), m_navigationRateHz(std::max(navigationRateHz, 1)),
+    m_inBuffer(std::max<size_t>(bufferSize, Novatel::MIN_FRAME_BUFFER_SIZE))
 {
-    return -1;
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Initializing.");
+
+    bool success = false;
+
+    // Attempt to auto discover if we received auto
+    if (m_baudrate != SerialClient::BaudRate::BAUDRATE_AUTO && m_baudrate != SerialClient::BaudRate::BAUDRATE_INVALID)
+    {
+        success = m_comms.OpenConfigure(m_path, m_baudrate, SerialClient::ByteSize::EIGHT, SerialClient::Parity::NONE, SerialClient::StopBits::ONE);
+    }
+    else if (m_baudrate == SerialClient::BaudRate::BAUDRATE_AUTO)
+    {
+        success = AutoDiscoverBaudRate();
+    }
+
+    if (!success)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Initialized Failed");
+        m_initialized = false;
+        return;
+    }
+
+    // Initialize the Novatel receiver
+    Initialize();
 }
 
-GpsData Novatel::GetCommonData()
+int NovatelGps::ProcessData()
 {
+    bool newSolution = false;
+
+    // Framer state lives in the instance so units and threads never share it
+    unsigned int& bytesInBuffer = m_bytesInBuffer;
+    uint8_t* inBuffer = m_inBuffer.Data();
+    const unsigned int bufferSize = static_cast<unsigned int>(m_inBuffer.Size());
+
+    // dump existing data
+    if (m_firstRead)
+    {
+        m_firstRead = false;
+        m_comms.Flush();
+        bytesInBuffer = 0;
+        m_rxTimeline.Reset();
+    }
+
+    // read bytes from port into buffer - only read in the max amount
+    int bytesRead = m_comms.Read(reinterpret_cast<std::byte*>(&inBuffer[bytesInBuffer]), bufferSize - bytesInBuffer);
+
+    if (bytesRead <= 0)
+    {
+        UpdateThroughput();
+        return bytesRead;
+    }
+
+    bytesInBuffer += bytesRead;
+    m_rxTimeline.Append(bytesRead, MonotonicNowNs());
+
+    // Frame every whole log in place, the leftovers are moved down once at the end
+    unsigned int position = 0;
+    while (bytesInBuffer - position >= Novatel::NUM_SYNC_BYTES)
+    {
+        const uint8_t* frame = &inBuffer[position];
+
+        // look for the sync bytes, skip straight to the next candidate on a miss
+        if (frame[0] != Novatel::SYNC_1 || frame[1] != Novatel::SYNC_2 || frame[2] != Novatel::SYNC_3)
+        {
+            const void* next = std::memchr(frame + 1, Novatel::SYNC_1, bytesInBuffer - position - 1);
+            position = (next != nullptr) ? static_cast<unsigned int>(static_cast<const uint8_t*>(next) - inBuffer) : bytesInBuffer;
+            continue;
+        }
+
+        // do we have the whole header?
+        if (bytesInBuffer - position < sizeof(Novatel::Header))
+        {
+            break;
+        }
+
+        const Novatel::Header* header = reinterpret_cast<const Novatel::Header*>(frame);
+        const unsigned int frameLength = header->headerLength + header->messageLength + Novatel::CRC_LENGTH;
+
+        // a header that can never fit the buffer is a false sync, step past it and keep searching
+        if (header->headerLength < sizeof(Novatel::Header) || frameLength > bufferSize)
+        {
+            m_data.crcFailCount++;
+            position += 1;
+            continue;
+        }
+
+        // do we have the whole log? if not, collect more data
+        if (bytesInBuffer - position < frameLength)
+        {
+            break;
+        }
+
+        // the crc trails the log, little endian
+        uint32_t expectedCrc = 0;
+        std::memcpy(&expectedCrc, frame + frameLength - Novatel::CRC_LENGTH, sizeof(expectedCrc));
+        if (Crc32(frame, frameLength - Novatel::CRC_LENGTH) != expectedCrc)
+        {
+            m_data.crcFailCount++;
+            position += 1;
+            continue;
+        }
+
+        if (HandleLog(frame, m_rxTimeline.StampFor(position, frameLength)))
+        {
+            newSolution = true;
+        }
+
+        position += frameLength;
+    }
+
+    // Move any partial log to the front of the buffer
+    if (position > 0)
+    {
+        std::memmove(&inBuffer[0], &inBuffer[position], bytesInBuffer - position);
+        bytesInBuffer -= position;
+        m_rxTimeline.Consume(position);
+    }
+
+    UpdateThroughput();
+
+    // Update the common data if we got a new solution
+    if (newSolution)
+    {
+        UpdateCommonData();
+        return 1;
+    }
+
+    // Default return
+    return 0;
+}
+
+GpsData NovatelGps::GetCommonData()
+{
+    std::scoped_lock lock(m_commonDataMutex);
     return m_commonData;
 }
 
-void Novatel::UpdateCommonData()
+void NovatelGps::Initialize()
+{
+    // Flush any old data sitting on serial port
+    m_comms.Flush();
+
+    if (Configure() < 0)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Failed to configure.");
+        m_initialized = false;
+        return;
+    }
+
+    m_initialized = true;
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Initialized.");
+}
+
+int NovatelGps::Configure()
+{
+    // GNSS logs are capped, the inertial solution carries the high rate
+    const int positionRateHz = std::min(m_navigationRateHz, 20);
+    const std::string positionPeriod = std::to_string(1.0 / positionRateHz);
+    const std::string insPeriod = std::to_string(1.0 / m_navigationRateHz);
+
+    // Check the requested logs fit the link, 10 bits on the wire per byte
+    constexpr int FRAME_OVERHEAD = sizeof(Novatel::Header) + Novatel::CRC_LENGTH;
+    const int bytesPerSecond = (FRAME_OVERHEAD + sizeof(Novatel::BestPos)) * positionRateHz +
+        (FRAME_OVERHEAD + sizeof(Novatel::BestVel)) * positionRateHz +
+        (FRAME_OVERHEAD + sizeof(Novatel::InsPvaX)) * m_navigationRateHz +
+        (FRAME_OVERHEAD + sizeof(Novatel::Time));
+
+    auto baud = m_GpsCommonBaudRateMap.find(m_comms.GetBaudRate());
+    if (baud != m_GpsCommonBaudRateMap.end() && bytesPerSecond * 10 > baud->second)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Requested logs need " + std::to_string(bytesPerSecond * 10) +
+            " bps, port is " + std::to_string(baud->second) + " bps. Logs will be dropped.");
+    }
+
+    if (SendCommand("UNLOGALL THISPORT") < 0 ||
+        SendCommand("LOG THISPORT BESTPOSB ONTIME " + positionPeriod) < 0 ||
+        SendCommand("LOG THISPORT BESTVELB ONTIME " + positionPeriod) < 0 ||
+        SendCommand("LOG THISPORT TIMEB ONTIME 1") < 0)
+    {
+        return -1;
+    }
+
+    // Only SPAN receivers have INSPVAX, the request is harmless elsewhere and BESTPOS carries on
+    if (SendCommand("LOG THISPORT INSPVAXB ONTIME " + insPeriod) < 0)
+    {
+        return -1;
+    }
+
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Logging BESTPOS/BESTVEL at " + std::to_string(positionRateHz) +
+        "Hz, INSPVAX at " + std::to_string(m_navigationRateHz) + "Hz");
+    return 0;
+}
+
+int NovatelGps::SendCommand(const std::string& command)
+{
+    const std::string line = command + "\r\n";
+
+    if (m_comms.Write(reinterpret_cast<const std::byte*>(line.data()), line.size()) < 0)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Failed to send " + command);
+        m_commonData.txErrorCount++;
+        return -1;
+    }
+
+    m_commonData.txCount++;
+    return 0;
+}
+
+bool NovatelGps::HandleLog(const uint8_t* frame, const RxStamp& stamp)
 {
+    const Novatel::Header* header = reinterpret_cast<const Novatel::Header*>(frame);
+    const uint8_t* body = frame + header->headerLength;
+
+    // only binary logs are decoded, responses and other formats are counted and skipped
+    constexpr uint8_t FORMAT_AND_RESPONSE_BITS = 0xE0;
+    if ((header->messageType & FORMAT_AND_RESPONSE_BITS) != 0)
+    {
+        m_data.unhandledRxCount++;
+        return false;
+    }
 
-}
\ No newline at end of file
+    RecordRxLatency(GpsMessageKey(GpsProtocol::Novatel, header->messageId), stamp);
+
+    switch (static_cast<Novatel::MSG_ID>(header->messageId))
+    {
+    case Novatel::MSG_ID::BESTPOS:
+    {
+        if (header->messageLength < sizeof(Novatel::BestPos)) break;
+        const Novatel::BestPos* log = reinterpret_cast<const Novatel::BestPos*>(body);
+        m_data.bestPosRxCount++;
+        m_data.numSolutionSvs = log->numSolutionSvs;
+
+        // while the inertial solution is live it owns the position
+        if (std::chrono::steady_clock::now() - m_lastInsSolution < std::chrono::seconds(1))
+        {
+            return false;
+        }
+
+        m_data.insSolution = false;
+        m_data.positionType = log->positionType;
+        m_data.solutionStatus = log->solutionStatus;
+        m_data.latitude = log->latitude;
+        m_data.longitude = log->longitude;
+        m_data.heightMsl = log->heightMsl;
+        m_data.undulation = log->undulation;
+        m_data.horizontalStdDev = std::hypot(log->latitudeStdDev, log->longitudeStdDev);
+        m_data.verticalStdDev = log->heightStdDev;
+        m_data.latitudeStdDev = log->latitudeStdDev;
+        m_data.longitudeStdDev = log->longitudeStdDev;
+        m_data.gpsWeek = header->week;
+        m_data.gpsMilliseconds = header->milliseconds;
+        m_solutionRxStamp = stamp;
+        m_rateWindowCount++;
+        return true;
+    }
+    case Novatel::MSG_ID::INSPVAX:
+    {
+        if (header->messageLength < sizeof(Novatel::InsPvaX)) break;
+        const Novatel::InsPvaX* log = reinterpret_cast<const Novatel::InsPvaX*>(body);
+        m_data.insPvaxRxCount++;
+
+        // an aligning or inactive system leaves the position to BESTPOS
+        const Novatel::INS_STATUS status = static_cast<Novatel::INS_STATUS>(log->insStatus);
+        if (status != Novatel::INS_STATUS::INS_SOLUTION_GOOD &&
+            status != Novatel::INS_STATUS::INS_SOLUTION_FREE &&
+            status != Novatel::INS_STATUS::INS_ALIGNMENT_COMPLETE &&
+            status != Novatel::INS_STATUS::INS_HIGH_VARIANCE)
+        {
+            return false;
+        }
+
+        m_lastInsSolution = std::chrono::steady_clock::now();
+        m_data.insSolution = true;
+        m_data.positionType = log->positionType;
+        m_data.solutionStatus = log->insStatus;
+        m_data.latitude = log->latitude;
+        m_data.longitude = log->longitude;
+        m_data.heightMsl = log->heightMsl;
+        m_data.undulation = log->undulation;
+        m_data.horizontalStdDev = std::hypot(log->latitudeStdDev, log->longitudeStdDev);
+        m_data.verticalStdDev = log->heightStdDev;
+        m_data.latitudeStdDev = log->latitudeStdDev;
+        m_data.longitudeStdDev = log->longitudeStdDev;
+        m_data.northVelocity = log->northVelocity;
+        m_data.eastVelocity = log->eastVelocity;
+        m_data.upVelocity = log->upVelocity;
+        m_data.northVelocityStdDev = log->northVelStdDev;
+        m_data.eastVelocityStdDev = log->eastVelStdDev;
+        m_data.upVelocityStdDev = log->upVelStdDev;
+        m_data.roll = log->roll;
+        m_data.pitch = log->pitch;
+        m_data.azimuth = log->azimuth;
+        m_data.gpsWeek = header->week;
+        m_data.gpsMilliseconds = header->milliseconds;
+        m_solutionRxStamp = stamp;
+        m_rateWindowCount++;
+        return true;
+    }
+    case Novatel::MSG_ID::BESTVEL:
+    {
+        if (header->messageLength < sizeof(Novatel::BestVel)) break;
+        const Novatel::BestVel* log = reinterpret_cast<const Novatel::BestVel*>(body);
+        m_data.bestVelRxCount++;
+        m_data.horizontalSpeed = log->horizontalSpeed;
+        m_data.trackOverGround = log->trackOverGround;
+        m_data.verticalSpeed = log->verticalSpeed;
+        m_data.velocityValid = log->solutionStatus == static_cast<uint32_t>(Novatel::SOLUTION_STATUS::SOL_COMPUTED);
+        return false;
+    }
+    case Novatel::MSG_ID::TIME:
+    {
+        if (header->messageLength < sizeof(Novatel::Time)) break;
+        const Novatel::Time* log = reinterpret_cast<const Novatel::Time*>(body);
+        m_data.timeRxCount++;
+        m_data.utcValid = log->utcStatus == static_cast<uint32_t>(Novatel::UTC_STATUS::VALID);
+        m_data.utcOffset = log->utcOffset;
+        return false;
+    }
+    default:
+        break;
+    }
+
+    m_data.unhandledRxCount++;
+    return false;
+}
+
+int NovatelGps::FixTypeFor(const uint32_t positionType)
+{
+    switch (static_cast<Novatel::POSITION_TYPE>(positionType))
+    {
+    case Novatel::POSITION_TYPE::NONE:
+    case Novatel::POSITION_TYPE::DOPPLER_VELOCITY:
+        return 0;
+    case Novatel::POSITION_TYPE::PROPAGATED:
+        return 1;
+    case Novatel::POSITION_TYPE::FIXEDHEIGHT:
+        return 2;
+    case Novatel::POSITION_TYPE::RTK_DIRECT_INS:
+    case Novatel::POSITION_TYPE::INS_SBAS:
+    case Novatel::POSITION_TYPE::INS_PSRSP:
+    case Novatel::POSITION_TYPE::INS_PSRDIFF:
+    case Novatel::POSITION_TYPE::INS_RTKFLOAT:
+    case Novatel::POSITION_TYPE::INS_RTKFIXED:
+    case Novatel::POSITION_TYPE::INS_PPP_CONVERGING:
+    case Novatel::POSITION_TYPE::INS_PPP:
+    case Novatel::POSITION_TYPE::INS_PPP_BASIC_CONVERGING:
+    case Novatel::POSITION_TYPE::INS_PPP_BASIC:
+        return 4;
+    default:
+        return 3;
+    }
+}
+
+void NovatelGps::UpdateThroughput()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    if (m_rateWindowStart == std::chrono::steady_clock::time_point{})
+    {
+        m_rateWindowStart = now;
+        return;
+    }
+
+    const double elapsedSecs = std::chrono::duration<double>(now - m_rateWindowStart).count();
+    if (elapsedSecs < 1.0) return;
+
+    {
+        std::scoped_lock lock(m_commonDataMutex);
+        m_data.solutionRateHz = m_rateWindowCount / elapsedSecs;
+        m_commonData.navRateHz = m_data.solutionRateHz;
+    }
+
+    m_rateWindowCount = 0;
+    m_rateWindowStart = now;
+}
+
+void NovatelGps::UpdateCommonData()
+{
+    std::scoped_lock lock(m_commonDataMutex);
+
+    // UTC of the solution from its gps reference time, once TIME has given the offset
+    if (m_data.utcValid)
+    {
+        constexpr double SECONDS_PER_DAY = 86400.0;
+        double secondOfDay = std::fmod(m_data.gpsMilliseconds / 1000.0 + m_data.utcOffset, SECONDS_PER_DAY);
+        if (secondOfDay < 0) secondOfDay += SECONDS_PER_DAY;
+
+        const int wholeSeconds = static_cast<int>(secondOfDay);
+        ConvertSecondsToHMS(wholeSeconds, m_commonData.hour, m_commonData.min, m_commonData.sec);
+    }
+
+    m_commonData.latitude = m_data.latitude;
+    m_commonData.longitude = m_data.longitude;
+    m_commonData.altitude = m_data.heightMsl;
+
+    // INS_SOLUTION_FREE is the inertial solution coasting without GNSS
+    if (m_data.insSolution)
+    {
+        m_commonData.fixType = (m_data.solutionStatus == static_cast<int>(Novatel::INS_STATUS::INS_SOLUTION_FREE)) ? 1 : FixTypeFor(m_data.positionType);
+    }
+    else
+    {
+        m_commonData.fixType = (m_data.solutionStatus == static_cast<int>(Novatel::SOLUTION_STATUS::SOL_COMPUTED)) ? FixTypeFor(m_data.positionType) : 0;
+    }
+
+    m_commonData.horizontalAccuracy = m_data.horizontalStdDev;
+    m_commonData.verticalAccuracy = m_data.verticalStdDev;
+
+    // position standard deviations are per axis, the cross terms are not reported
+    m_commonData.positionCovariance[0] = m_data.latitudeStdDev * m_data.latitudeStdDev;
+    m_commonData.positionCovariance[3] = m_data.longitudeStdDev * m_data.longitudeStdDev;
+    m_commonData.positionCovariance[5] = m_data.verticalStdDev * m_data.verticalStdDev;
+    m_commonData.positionCovarianceValid = m_commonData.fixType > 0;
+
+    // the inertial solution carries its own velocity, otherwise resolve BESTVEL speed and track
+    if (m_data.insSolution)
+    {
+        m_commonData.velocityNorth = m_data.northVelocity;
+        m_commonData.velocityEast = m_data.eastVelocity;
+        m_commonData.velocityDown = -m_data.upVelocity;
+        m_commonData.velocityValid = true;
+        m_commonData.velocityCovariance[0] = m_data.northVelocityStdDev * m_data.northVelocityStdDev;
+        m_commonData.velocityCovariance[3] = m_data.eastVelocityStdDev * m_data.eastVelocityStdDev;
+        m_commonData.velocityCovariance[5] = m_data.upVelocityStdDev * m_data.upVelocityStdDev;
+        m_commonData.velocityCovarianceValid = true;
+    }
+    else
+    {
+        const double track = m_data.trackOverGround * std::numbers::pi / 180.0;
+        m_commonData.velocityNorth = m_data.horizontalSpeed * std::cos(track);
+        m_commonData.velocityEast = m_data.horizontalSpeed * std::sin(track);
+        m_commonData.velocityDown = -m_data.verticalSpeed;
+        m_commonData.velocityValid = m_data.velocityValid;
+        m_commonData.velocityCovarianceValid = false;
+    }
+    m_commonData.rxCount = m_data.bestPosRxCount + m_data.bestVelRxCount + m_data.timeRxCount + m_data.insPvaxRxCount + m_data.unhandledRxCount;
+    m_commonData.rxErrorCount = m_data.crcFailCount;
+    m_commonData.rxFirstByteNs = m_solutionRxStamp.firstByteNs;
+    m_commonData.rxLastByteNs = m_solutionRxStamp.lastByteNs;
+}
@@ -11,45 +11,126 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include <string>                           // strings
+#include <chrono>                           // solution rate window
 //
 #include "gps_type.h"                       // base class
-// 
+#include "novatel_info.h"                   // novatel info
+#include "../utilities/aligned_buffer.h"    // framer buffer
+//
 /////////////////////////////////////////////////////////////////////////////////
 
-/// @brief 
+/// @brief Holder of the decoded Novatel log data
 struct NovatelData
 {
-    double roll;
-    double pitch;
-    double yaw;
-    bool error;
+    unsigned long   bestPosRxCount      = 0;
+    unsigned long   bestVelRxCount      = 0;
+    unsigned long   timeRxCount         = 0;
+    unsigned long   insPvaxRxCount      = 0;
+    unsigned long   unhandledRxCount    = 0;        // valid logs this driver does not decode
+    unsigned long   crcFailCount        = 0;
+
+    int         positionType            = 0;        // POSITION_TYPE of the last position used
+    int         solutionStatus          = 0;        // SOLUTION_STATUS or INS_STATUS of the last position used
+    bool        insSolution             = false;    // the last position came from INSPVAX
+    int         numSolutionSvs          = 0;        // satellites used in the last BESTPOS
+
+    double      latitude                = 0.0;      // deg
+    double      longitude               = 0.0;      // deg
+    double      heightMsl               = 0.0;      // m
+    double      undulation              = 0.0;      // m
+    double      horizontalStdDev        = 0.0;      // m
+    double      verticalStdDev          = 0.0;      // m
+    double      latitudeStdDev          = 0.0;      // m
+    double      longitudeStdDev         = 0.0;      // m
+
+    double      horizontalSpeed         = 0.0;      // m/s, BESTVEL
+    double      trackOverGround         = 0.0;      // deg, BESTVEL
+    double      verticalSpeed           = 0.0;      // m/s, BESTVEL
+
+    double      northVelocity           = 0.0;      // m/s, INSPVAX
+    double      eastVelocity            = 0.0;      // m/s, INSPVAX
+    double      upVelocity              = 0.0;      // m/s, INSPVAX
+    double      northVelocityStdDev     = 0.0;      // m/s, INSPVAX
+    double      eastVelocityStdDev      = 0.0;      // m/s, INSPVAX
+    double      upVelocityStdDev        = 0.0;      // m/s, INSPVAX
+    bool        velocityValid           = false;    // BESTVEL solution is computed
+    double      roll                    = 0.0;      // deg, INSPVAX
+    double      pitch                   = 0.0;      // deg, INSPVAX
+    double      azimuth                 = 0.0;      // deg, INSPVAX
+
+    int         gpsWeek                 = 0;        // reference week of the last position
+    uint32_t    gpsMilliseconds         = 0;        // reference ms of week of the last position
+    double      utcOffset               = 0.0;      // s, added to gps time gives utc
+    bool        utcValid                = false;    // TIME utc status is valid
+
+    double      solutionRateHz          = 0.0;      // positions decoded per second
 };
 
-/// @brief 
-class Novatel : public GpsType
+/// @brief Driver for Novatel OEM6/OEM7 receivers using binary BESTPOS, BESTVEL, TIME and INSPVAX logs
+class NovatelGps : public GpsType
 {
 public:
 
-    /// @brief 
-    Novatel(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate) :
-        GpsType("UBLOX", logger, path, baudrate) {}
+    /// @brief
+    /// @param navigationRateHz - [in/opt] - INSPVAX rate, BESTPOS/BESTVEL log at up to 20Hz of it
+    /// @param bufferSize - [in/opt] - Size of the framer buffer
+    NovatelGps(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate,
+        const int navigationRateHz = 1, const size_t bufferSize = Novatel::FRAME_BUFFER_SIZE);
 
-    /// @brief 
-    ~Novatel() {}
+    /// @brief
+    ~NovatelGps() {}
 
-    /// @brief 
+    /// @brief Read what is on the port and decode every whole log in the buffer
+    /// @return 1 if a new solution was decoded, 0 if not, -1 on a read error
     int ProcessData() override;
 
-    /// @brief 
-    /// @return 
+    /// @brief
+    /// @return
     GpsData GetCommonData() override;
 
 protected:
 
 private:
 
-    /// @brief 
+    /// @brief Flush the port and request the logs
+    void Initialize();
+
+    /// @brief Stop every log on this port and request the binary logs at the configured rates
+    /// @return 0 if successful, -1 on error
+    int Configure();
+
+    /// @brief Send an abbreviated ascii command
+    /// @param command - [in] - command without the line ending
+    /// @return 0 if successful, -1 on error
+    int SendCommand(const std::string& command);
+
+    /// @brief Decode one whole, crc checked log
+    /// @param frame - [in] - start of the log, the header is at offset 0
+    /// @param stamp - [in] - receive stamp of the log
+    /// @return true if a new solution was decoded, else false
+    bool HandleLog(const uint8_t* frame, const RxStamp& stamp);
+
+    /// @brief Map a position type to the common fix type
+    /// @param positionType - [in] - POSITION_TYPE of the log
+    /// @return 0 no fix, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS + dead reckoning
+    static int FixTypeFor(const uint32_t positionType);
+
+    /// @brief Recalculate the solution rate once a second
+    void UpdateThroughput();
+
+    /// @brief
     void UpdateCommonData() override;
 
-    NovatelData m_data = {};              /// Data storage
-};
\ No newline at end of file
+    NovatelData         m_data              = {};       /// Data storage
+    int                 m_navigationRateHz  = 1;        /// INSPVAX rate requested
+    RxStamp             m_solutionRxStamp   = {};       /// Receive stamp of the last position
+
+    // Framer state, aligned so parallel parsers never share a cache line
+    alignas(CACHE_LINE_SIZE) AlignedBuffer m_inBuffer;  /// Bytes read and not yet framed
+    unsigned int        m_bytesInBuffer     = 0;        /// Bytes held in m_inBuffer
+    bool                m_firstRead         = true;     /// Flush what was queued before the first read
+
+    std::chrono::steady_clock::time_point m_rateWindowStart = {};   /// Start of the current rate window
+    unsigned long       m_rateWindowCount   = 0;        /// Positions decoded in the window
+    std::chrono::steady_clock::time_point m_lastInsSolution = {};   /// Time of the last usable INSPVAX
+};
@@ -0,0 +1,237 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            novatel_info.h
+// @brief           Definitions and structures for Novatel OEM6/OEM7 modules
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstdint>                          // std ints
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Novatel
+{
+    /// @brief Sync bytes of a long binary header
+    constexpr uint8_t SYNC_1 = 0xAA;
+    constexpr uint8_t SYNC_2 = 0x44;
+    constexpr uint8_t SYNC_3 = 0x12;
+
+    /// @brief Number of sync bytes in binary logs
+    constexpr int NUM_SYNC_BYTES = 3;
+
+    /// @brief Number of bytes in the trailing crc
+    constexpr int CRC_LENGTH = 4;
+
+    /// @brief Default size of the framer buffer, holds several 100Hz INSPVAX epochs
+    constexpr int FRAME_BUFFER_SIZE = 4096;
+
+    /// @brief Smallest framer buffer accepted, fits every log decoded here
+    constexpr int MIN_FRAME_BUFFER_SIZE = 512;
+
+    /// @brief Binary log message ids
+    enum class MSG_ID : uint16_t
+    {
+        BESTPOS     = 42,
+        BESTVEL     = 99,
+        TIME        = 101,
+        INSPVAX     = 1465,
+    };
+
+    /// @brief Solution status of a log
+    enum class SOLUTION_STATUS : uint32_t
+    {
+        SOL_COMPUTED        = 0,        // solution computed
+        INSUFFICIENT_OBS    = 1,        // insufficient observations
+        NO_CONVERGENCE      = 2,        // no convergence
+        SINGULARITY         = 3,        // singularity at parameters matrix
+        COV_TRACE           = 4,        // covariance trace exceeds maximum
+        TEST_DIST           = 5,        // test distance exceeded
+        COLD_START          = 6,        // not yet converged from cold start
+        V_H_LIMIT           = 7,        // height or velocity limits exceeded
+        VARIANCE            = 8,        // variance exceeds limits
+        RESIDUALS           = 9,        // residuals are too large
+        INTEGRITY_WARNING   = 13,       // large residuals make position unreliable
+        PENDING             = 18,       // fix position command not yet applied
+        INVALID_FIX         = 19,       // fixed position is not valid
+        UNAUTHORIZED        = 20,       // position type is unauthorized
+        INVALID_RATE        = 22,       // selected logging rate not supported
+    };
+
+    /// @brief Position or velocity type of a log
+    enum class POSITION_TYPE : uint32_t
+    {
+        NONE                        = 0,
+        FIXEDPOS                    = 1,
+        FIXEDHEIGHT                 = 2,
+        DOPPLER_VELOCITY            = 8,
+        SINGLE                      = 16,
+        PSRDIFF                     = 17,
+        WAAS                        = 18,
+        PROPAGATED                  = 19,
+        L1_FLOAT                    = 32,
+        NARROW_FLOAT                = 34,
+        L1_INT                      = 48,
+        WIDE_INT                    = 49,
+        NARROW_INT                  = 50,
+        RTK_DIRECT_INS              = 51,
+        INS_SBAS                    = 52,
+        INS_PSRSP                   = 53,
+        INS_PSRDIFF                 = 54,
+        INS_RTKFLOAT                = 55,
+        INS_RTKFIXED                = 56,
+        PPP_CONVERGING              = 68,
+        PPP                         = 69,
+        OPERATIONAL                 = 70,
+        WARNING                     = 71,
+        OUT_OF_BOUNDS               = 72,
+        INS_PPP_CONVERGING          = 73,
+        INS_PPP                     = 74,
+        PPP_BASIC_CONVERGING        = 77,
+        PPP_BASIC                   = 78,
+        INS_PPP_BASIC_CONVERGING    = 79,
+        INS_PPP_BASIC               = 80,
+    };
+
+    /// @brief Inertial solution status of INSPVAX
+    enum class INS_STATUS : uint32_t
+    {
+        INS_INACTIVE                = 0,
+        INS_ALIGNING                = 1,
+        INS_HIGH_VARIANCE           = 2,
+        INS_SOLUTION_GOOD           = 3,
+        INS_SOLUTION_FREE           = 6,
+        INS_ALIGNMENT_COMPLETE      = 7,
+        DETERMINING_ORIENTATION     = 8,
+        WAITING_INITIALPOS          = 9,
+        WAITING_AZIMUTH             = 10,
+        INITIALIZING_BIASES         = 11,
+        MOTION_DETECT               = 12,
+    };
+
+    /// @brief UTC status of the TIME log
+    enum class UTC_STATUS : uint32_t
+    {
+        INVALID     = 0,
+        VALID       = 1,
+        WARNING     = 2,
+    };
+
+#pragma pack(push, 1)
+
+    /// @brief Long binary header
+    struct Header                       //  offset      description
+    {                                   //  -------     ------------
+        uint8_t     sync1;              //  0           = 0xAA
+        uint8_t     sync2;              //  1           = 0x44
+        uint8_t     sync3;              //  2           = 0x12
+        uint8_t     headerLength;       //  3           length of the header in bytes
+        uint16_t    messageId;          //  4-5         message id of the log
+        uint8_t     messageType;        //  6           bits 5-6 format, bit 7 response
+        uint8_t     portAddress;        //  7           port the log was output on
+        uint16_t    messageLength;      //  8-9         length of the body, header and crc not included
+        uint16_t    sequence;           //  10-11       remaining logs with the same id and time
+        uint8_t     idleTime;           //  12          receiver idle time, 0.5 percent
+        uint8_t     timeStatus;         //  13          quality of the gps reference time
+        uint16_t    week;               //  14-15       gps reference week
+        uint32_t    milliseconds;       //  16-19       milliseconds from the start of the gps week
+        uint32_t    receiverStatus;     //  20-23       receiver status word
+        uint16_t    reserved;           //  24-25       reserved
+        uint16_t    swVersion;          //  26-27       receiver software build number
+    };
+
+    /// @brief BESTPOS, best available position
+    struct BestPos                      //  offset      units       description
+    {                                   //  -------     -------     ------------
+        uint32_t    solutionStatus;     //  0-3         n/a         SOLUTION_STATUS
+        uint32_t    positionType;       //  4-7         n/a         POSITION_TYPE
+        double      latitude;           //  8-15        deg         latitude
+        double      longitude;          //  16-23       deg         longitude
+        double      heightMsl;          //  24-31       m           height above mean sea level
+        float       undulation;         //  32-35       m           geoid minus ellipsoid
+        uint32_t    datumId;            //  36-39       n/a         datum id, 61 = WGS84
+        float       latitudeStdDev;     //  40-43       m           latitude standard deviation
+        float       longitudeStdDev;    //  44-47       m           longitude standard deviation
+        float       heightStdDev;       //  48-51       m           height standard deviation
+        char        stationId[4];       //  52-55       n/a         base station id
+        float       differentialAge;    //  56-59       s           differential age
+        float       solutionAge;        //  60-63       s           solution age
+        uint8_t     numSvs;             //  64          n/a         satellites tracked
+        uint8_t     numSolutionSvs;     //  65          n/a         satellites used in the solution
+        uint8_t     numL1Svs;           //  66          n/a         satellites with L1/E1/B1 used
+        uint8_t     numMultiSvs;        //  67          n/a         satellites with multi-frequency used
+        uint8_t     reserved;           //  68          n/a         reserved
+        uint8_t     extSolutionStatus;  //  69          n/a         extended solution status
+        uint8_t     galBdsSignalMask;   //  70          n/a         galileo and beidou signals used
+        uint8_t     gpsGloSignalMask;   //  71          n/a         gps and glonass signals used
+    };
+
+    /// @brief BESTVEL, best available velocity
+    struct BestVel                      //  offset      units       description
+    {                                   //  -------     -------     ------------
+        uint32_t    solutionStatus;     //  0-3         n/a         SOLUTION_STATUS
+        uint32_t    velocityType;       //  4-7         n/a         POSITION_TYPE
+        float       latency;            //  8-11        s           velocity latency
+        float       age;                //  12-15       s           differential age
+        double      horizontalSpeed;    //  16-23       m/s         speed over ground
+        double      trackOverGround;    //  24-31       deg         direction of travel from true north
+        double      verticalSpeed;      //  32-39       m/s         vertical speed, positive up
+        float       reserved;           //  40-43       n/a         reserved
+    };
+
+    /// @brief TIME, receiver time and utc offset
+    struct Time                         //  offset      units       description
+    {                                   //  -------     -------     ------------
+        uint32_t    clockStatus;        //  0-3         n/a         clock model status
+        double      offset;             //  4-11        s           receiver clock offset
+        double      offsetStdDev;       //  12-19       s           receiver clock offset standard deviation
+        double      utcOffset;          //  20-27       s           utc minus gps time as sent, negative (-18 since 2017), added to gps time
+        uint32_t    utcYear;            //  28-31       year        utc year
+        uint8_t     utcMonth;           //  32          month       utc month, 0-12
+        uint8_t     utcDay;             //  33          day         utc day, 0-31
+        uint8_t     utcHour;            //  34          hour        utc hour, 0-23
+        uint8_t     utcMin;             //  35          min         utc minute, 0-59
+        uint32_t    utcMilliseconds;    //  36-39       ms          utc milliseconds, 0-60999
+        uint32_t    utcStatus;          //  40-43       n/a         UTC_STATUS
+    };
+
+    /// @brief INSPVAX, inertial position, velocity and attitude with standard deviations
+    struct InsPvaX                      //  offset      units       description
+    {                                   //  -------     -------     ------------
+        uint32_t    insStatus;          //  0-3         n/a         INS_STATUS
+        uint32_t    positionType;       //  4-7         n/a         POSITION_TYPE
+        double      latitude;           //  8-15        deg         latitude
+        double      longitude;          //  16-23       deg         longitude
+        double      heightMsl;          //  24-31       m           height above mean sea level
+        float       undulation;         //  32-35       m           geoid minus ellipsoid
+        double      northVelocity;      //  36-43       m/s         north velocity
+        double      eastVelocity;       //  44-51       m/s         east velocity
+        double      upVelocity;         //  52-59       m/s         up velocity
+        double      roll;               //  60-67       deg         right handed rotation about y
+        double      pitch;              //  68-75       deg         right handed rotation about x
+        double      azimuth;            //  76-83       deg         left handed rotation about z
+        float       latitudeStdDev;     //  84-87       m           latitude standard deviation
+        float       longitudeStdDev;    //  88-91       m           longitude standard deviation
+        float       heightStdDev;       //  92-95       m           height standard deviation
+        float       northVelStdDev;     //  96-99       m/s         north velocity standard deviation
+        float       eastVelStdDev;      //  100-103     m/s         east velocity standard deviation
+        float       upVelStdDev;        //  104-107     m/s         up velocity standard deviation
+        float       rollStdDev;         //  108-111     deg         roll standard deviation
+        float       pitchStdDev;        //  112-115     deg         pitch standard deviation
+        float       azimuthStdDev;      //  116-119     deg         azimuth standard deviation
+        uint32_t    extSolutionStatus;  //  120-123     n/a         extended solution status
+        uint16_t    timeSinceUpdate;    //  124-125     s           time since the last zupt or position update
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(Header) == 28, "Novatel header must be 28 bytes");
+    static_assert(sizeof(BestPos) == 72, "BESTPOS body must be 72 bytes");
+    static_assert(sizeof(BestVel) == 44, "BESTVEL body must be 44 bytes");
+    static_assert(sizeof(Time) == 44, "TIME body must be 44 bytes");
+    static_assert(sizeof(InsPvaX) == 126, "INSPVAX body must be 126 bytes");
+}
@@ -11,13 +11,21 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include <array>							// array
+#include <algorithm>						// max
 //
 #include "ublox.h"							// Header
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
 UbloxGps::UbloxGps(LogClient & logger, const std::string path, const SerialClient::BaudRate baudrate) :
-    GpsType("UBLOX", logger, path, baudrate) 
+	UbloxGps(logger, path, baudrate, Ublox::NAV_PROFILE::STANDARD, false, false)
+{}
+
+UbloxGps::UbloxGps(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate,
+	const Ublox::NAV_PROFILE profile, const bool includeCovariance, const bool includeDop, const size_t bufferSize) :
+    GpsType("UBLOX", logger, path, baudrate), m_inBuffer(std::max<size_t>(bufferSize, Ublox::MIN_FRAME_BUFFER_SIZE)),
+	m_msgBuffer(std::max<size_t>(bufferSize, Ublox::MIN_FRAME_BUFFER_SIZE)),
+	m_navProfile(profile), m_navIncludeCovariance(includeCovariance), m_navIncludeDop(includeDop)
 {
 	m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Initializing.");
 
@@ -46,35 +54,37 @@ UbloxGps::UbloxGps(LogClient & logger, const std::string path, const SerialClien
 
 int UbloxGps::ProcessData()
 {
-	static unsigned int bytesInBuffer = 0;
-	static bool first = true;
 	int bytesRead = 0;
 	int bytesAvail = 0;
 	bool newData = false;
 
-	// Buffers 
-	static uint8_t inBuffer[BUFFER_SIZE] = {};
-	static uint8_t msgBuffer[BUFFER_SIZE] = {};
+	// Framer state lives in the instance so units and threads never share it
+	unsigned int& bytesInBuffer = m_bytesInBuffer;
+	uint8_t* inBuffer = m_inBuffer.Data();
+	uint8_t* msgBuffer = m_msgBuffer.Data();
+	const unsigned int bufferSize = static_cast<unsigned int>(m_inBuffer.Size());
 
 	// dump existing data
-	if (first)
+	if (m_firstRead)
 	{
-		first = false;
+		m_firstRead = false;
 		m_comms.Flush();
 		bytesInBuffer = 0;
+		m_rxTimeline.Reset();
 	}
 
 	// if here and buffer is full for some odd reason, as a precaution let's clear the buffer and stream before proceeding
-	if (bytesInBuffer >= BUFFER_SIZE)
+	if (bytesInBuffer >= bufferSize)
 	{
-		std::fill(std::begin(inBuffer), std::end(inBuffer), 0);
+		std::fill(inBuffer, inBuffer + bufferSize, 0);
 		m_comms.Flush();
 		bytesInBuffer = 0;
+		m_rxTimeline.Reset();
 	}
 
 	// check how many bytes are available - if none, or if no data available in buffer 
 	// then continue to the next iteration of the loop
-	bytesAvail = (BUFFER_SIZE - bytesInBuffer);
+	bytesAvail = (bufferSize - bytesInBuffer);
 
 	// read bytes from port into buffer - only read in the max amount
 	bytesRead = m_comms.Read(reinterpret_cast<std::byte*>(&inBuffer[bytesInBuffer]), bytesAvail);
@@ -83,8 +93,13 @@ int UbloxGps::ProcessData()
 	if (bytesRead > 0)
 	{
 		bytesInBuffer += bytesRead;
+		m_rxTimeline.Append(bytesRead, MonotonicNowNs());
+	}
+	else if (bytesRead <= 0)
+	{
+		UpdateThroughput();
+		return bytesRead;
 	}
-	else if (bytesRead <= 0) return bytesRead;
 
 	// do we have at least 2 bytes in buffer (size of sync bytes)
 	while (bytesInBuffer >= Ublox::NUM_SYNC_BYTES)
@@ -133,6 +148,7 @@ int UbloxGps::ProcessData()
 		{
 			std::memmove(&inBuffer[0], &inBuffer[index], (bytesInBuffer - index));
 			bytesInBuffer -= static_cast<unsigned int>(index);
+			m_rxTimeline.Consume(index);
 		}
 
 		// if we didn't find a start of message, try again next time
@@ -147,6 +163,16 @@ int UbloxGps::ProcessData()
 			// 8 bytes = (sync1, sync2, class id, msg id, length(2 bytes), checksum A, checksum B)
 			fullMsgLength = CalculatePayloadLength(inBuffer[4], inBuffer[5]) + 8;
 
+			// a length that can never fit the buffer is a false sync, dump the sync bytes and continue searching
+			if (fullMsgLength > bufferSize)
+			{
+				m_data.ChecksumFailCount++;
+				std::memmove(&inBuffer[0], &inBuffer[Ublox::NUM_SYNC_BYTES], (bytesInBuffer - Ublox::NUM_SYNC_BYTES));
+				bytesInBuffer -= Ublox::NUM_SYNC_BYTES;
+				m_rxTimeline.Consume(Ublox::NUM_SYNC_BYTES);
+				continue;
+			}
+
 			// do we have enough bytes for the message?
 			// if not, continue to the top of the loop and collect more data
 			if (bytesInBuffer < fullMsgLength)
@@ -161,48 +187,91 @@ int UbloxGps::ProcessData()
 				m_data.ChecksumFailCount++;
 				std::memmove(&inBuffer[0], &inBuffer[Ublox::NUM_SYNC_BYTES], (bytesInBuffer - Ublox::NUM_SYNC_BYTES));
 				bytesInBuffer -= Ublox::NUM_SYNC_BYTES;
+				m_rxTimeline.Consume(Ublox::NUM_SYNC_BYTES);
+				continue;
+			}
+
+			// stamp the message before its bytes leave the buffer
+			RxStamp stamp = m_rxTimeline.StampFor(0, fullMsgLength);
+
+			// raw measurements go straight from the framer to the recorder, no decode on this path
+			if (inBuffer[2] == Ublox::UBX::RXM::classId)
+			{
+				if (m_rawRecorder.IsOpen())
+				{
+					m_rawRecorder.Record(inBuffer, fullMsgLength, inBuffer[2], inBuffer[3], stamp.firstByteNs);
+				}
+
+				if (inBuffer[3] == Ublox::UBX::RXM::RAWX::messageId)		m_data.UbxRawxCount++;
+				else if (inBuffer[3] == Ublox::UBX::RXM::SFRBX::messageId)	m_data.UbxSfrbxCount++;
+
+				std::memmove(&inBuffer[0], &inBuffer[fullMsgLength], bytesInBuffer - fullMsgLength);
+				bytesInBuffer -= fullMsgLength;
+				m_rxTimeline.Consume(fullMsgLength);
+				m_data.UbxRxCount++;
+				m_rateWindowUbxCount++;
 				continue;
 			}
 
 			// consume the UBX message
 			if (bytesInBuffer >= fullMsgLength)
 			{
-				// clear the msg buffer 
-				std::fill(std::begin(msgBuffer), std::end(msgBuffer), 0);
+				// clear what the last message left in the msg buffer
+				std::fill(msgBuffer, msgBuffer + m_msgLength, 0);
 				// copy the memory to msg buffer
 				std::copy(&inBuffer[0], &inBuffer[fullMsgLength], &msgBuffer[0]);
+				m_msgLength = fullMsgLength;
 				// move the data in the buffer up.
 				std::memmove(&inBuffer[0], &inBuffer[fullMsgLength], bytesInBuffer - fullMsgLength);
 				// update Bytes in buffer
 				bytesInBuffer -= fullMsgLength;
+				m_rxTimeline.Consume(fullMsgLength);
 			}
 
 			// handle the UBX message 
 			HandleUbxMessage(msgBuffer);
+			RecordRxLatency(GpsMessageKey(GpsProtocol::Ubx, (msgBuffer[2] << 8) | msgBuffer[3]), stamp);
+			if (msgBuffer[2] == Ublox::UBX::NAV::classId && msgBuffer[3] == Ublox::UBX::NAV::PVT::messageId)
+			{
+				m_pvtRxStamp = stamp;
+			}
 			m_data.UbxRxCount++;
+			m_rateWindowUbxCount++;
 			newData = true;
 		}
 		// did we find an NMEA message ? 
 		else if (nmeaFound)
 		{
-			if (nmeaMsgLength > sizeof(msgBuffer))
+			if (nmeaMsgLength > bufferSize)
 			{
 				// Message is too large for msgBuffer; dump the sync byte and continue searching
 				m_data.ChecksumFailCount++;
 				std::memmove(&inBuffer[0], &inBuffer[1], (bytesInBuffer - 1));
 				bytesInBuffer -= 1;
+				m_rxTimeline.Consume(1);
 				continue;
 			}
 
-			// clear the msg buffer 
-			std::fill(std::begin(msgBuffer), std::end(msgBuffer), 0);
+			// stamp the sentence including its "\r\n" before the bytes leave the buffer
+			RxStamp stamp = m_rxTimeline.StampFor(0, nmeaMsgLength + 2);
+
+			// clear what the last message left in the msg buffer
+			std::fill(msgBuffer, msgBuffer + m_msgLength, 0);
 			// copy the memory to msg buffer
 			std::copy(&inBuffer[0], &inBuffer[nmeaMsgLength], &msgBuffer[0]);
+			m_msgLength = nmeaMsgLength;
 			// move the data in the buffer up.
 			// nmeaMsgLength does not include the ending "\n\r", so +2 for those characters that follow an NMEA message
 			std::memmove(&inBuffer[0], &inBuffer[nmeaMsgLength + 2], bytesInBuffer - (nmeaMsgLength + 2));
 			// update Bytes in buffer
 			bytesInBuffer -= (nmeaMsgLength + 2);
+			m_rxTimeline.Consume(nmeaMsgLength + 2);
+
+			// key NMEA sentences by their formatter, "$GNGGA" = "GGA"
+			if (nmeaMsgLength > 5)
+			{
+				RecordRxLatency(GpsMessageKey(GpsProtocol::Nmea, (msgBuffer[3] << 16) | (msgBuffer[4] << 8) | msgBuffer[5]), stamp);
+			}
 
 			// For NMEA we are only incrementing the counts for now. 
 			// @note - if desire to handle NMEA in future - use this "HandleNmeaMessage(msgBuffer);"
@@ -212,6 +281,8 @@ int UbloxGps::ProcessData()
 		}
 	}
 
+	UpdateThroughput();
+
 	if (newData)
 	{	
 		UpdateCommonData();
@@ -520,7 +591,7 @@ int UbloxGps::SetUbxMessageRate(uint8_t satelliteSource, uint8_t measurmentRate,
 	msg.syncChar1			= Ublox::UBX::Header::SyncChar1;
 	msg.syncChar2			= Ublox::UBX::Header::SyncChar2;
 	msg.classId				= Ublox::UBX::CFG::classId;
-	msg.messageId			= Ublox::UBX::CFG::MSG::messageId;
+	msg.messageId			= Ublox::UBX::CFG::RATE::messageId;
 	msg.messageLength		= 0x06;
 	msg.reserved1			= 0x00;
 	msg.measRate			= measurmentRate;
@@ -553,6 +624,271 @@ int UbloxGps::SetUbxMessageRate(uint8_t satelliteSource, uint8_t measurmentRate,
 	return 0;
 }
 
+int UbloxGps::SetNavigationProfile(Ublox::NAV_PROFILE profile, bool includeCovariance, bool includeDop)
+{
+	uint8_t measureRate = 0;
+
+	switch (profile)
+	{
+	case Ublox::NAV_PROFILE::HZ10: measureRate = Ublox::UBX::CFG::RATE::MEASURE_HZ10; break;
+	case Ublox::NAV_PROFILE::HZ20: measureRate = Ublox::UBX::CFG::RATE::MEASURE_HZ20; break;
+	case Ublox::NAV_PROFILE::HZ25: measureRate = Ublox::UBX::CFG::RATE::MEASURE_HZ25; break;
+	case Ublox::NAV_PROFILE::STANDARD:
+		// Intentional fall through
+	default:
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Unsupported navigation profile requested.");
+		return -1;
+	}
+
+	const uint32_t rateHz = static_cast<uint32_t>(profile);
+
+	// link budget - bytes per epoch at 10 bits per byte (8N1), doubled for acks, polls and bursts
+	uint32_t bytesPerEpoch = Ublox::UBX::NAV::PVT::fullMessageLength;
+	if (includeCovariance)	bytesPerEpoch += Ublox::UBX::NAV::COV::fullMessageLength;
+	if (includeDop)			bytesPerEpoch += Ublox::UBX::NAV::DOP::fullMessageLength;
+	const uint32_t requiredBitsPerSecond = bytesPerEpoch * rateHz * 10 * 2;
+
+	if (RaiseBaudRateForBudget(requiredBitsPerSecond) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Link cannot carry " + std::to_string(rateHz) + "Hz navigation profile");
+		return -1;
+	}
+
+	// trim the output set - anything outside of PVT, COV and DOP is turned off to fit the budget
+	const std::array<uint8_t, 8> trimmedMessages = {
+		Ublox::UBX::NAV::POSECEF::messageId,
+		Ublox::UBX::NAV::POSLLH::messageId,
+		Ublox::UBX::NAV::VELECEF::messageId,
+		Ublox::UBX::NAV::VELNED::messageId,
+		Ublox::UBX::NAV::TIMEUTC::messageId,
+		Ublox::UBX::NAV::SAT::messageId,
+		Ublox::UBX::NAV::STATUS::messageId,
+		Ublox::UBX::NAV::TIMEGPS::messageId,
+	};
+
+	for (const uint8_t messageId : trimmedMessages)
+	{
+		if (ConfigureMessageRate(Ublox::UBX::NAV::classId, messageId, 0) < 0)
+		{
+			m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Trimming navigation output set failed");
+			return -1;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// optional COV and DOP follow every navigation solution, or are turned off
+	if (ConfigureMessageRate(Ublox::UBX::NAV::classId, Ublox::UBX::NAV::COV::messageId, includeCovariance ? 1 : 0) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Setting UBX-NAV-COV failed");
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	if (ConfigureMessageRate(Ublox::UBX::NAV::classId, Ublox::UBX::NAV::DOP::messageId, includeDop ? 1 : 0) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Setting UBX-NAV-DOP failed");
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	// turn on UBX NAV PVT for every navigation solution
+	if (ConfigureMessageDataStream(Ublox::UBX::NAV::classId, Ublox::UBX::NAV::PVT::messageId, m_commsOnUart, m_commsOnUsb) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Turning on UBX-NAV-PVT failed");
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	if (ConfigureMessageRate(Ublox::UBX::NAV::classId, Ublox::UBX::NAV::PVT::messageId, 1) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Setting UBX-NAV-PVT failed");
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	// finally the measurement rate, one navigation solution per measurement
+	if (SetUbxMessageRate(Ublox::UBX::CFG::RATE::GPS_SOURCE, measureRate, Ublox::UBX::CFG::RATE::NAV_CYCLES1) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Setting measurement rate failed");
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	// restart the throughput statistics for the new rate
+	m_navProfile				= profile;
+	m_navIncludeCovariance		= includeCovariance;
+	m_navIncludeDop				= includeDop;
+	m_navRateDegraded			= false;
+	m_havePvtTow				= false;
+	m_rateWindowPvtCount		= 0;
+	m_rateWindowUbxCount		= 0;
+	m_rateWindowStart			= std::chrono::steady_clock::now();
+	m_data.PvtDroppedCount		= 0;
+
+	m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Navigation profile set to " + std::to_string(rateHz) + "Hz");
+	return 0;
+}
+
+int UbloxGps::EnableRawMeasurements(const std::string& path)
+{
+	// a framer buffer smaller than a full sky RAWX frame would reject it
+	if (m_inBuffer.Size() < static_cast<size_t>(Ublox::MAX_RAWX_FRAME_SIZE))
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Framer buffer of " + std::to_string(m_inBuffer.Size()) +
+			" bytes is too small for raw measurements, needs " + std::to_string(Ublox::MAX_RAWX_FRAME_SIZE));
+		return -1;
+	}
+
+	if (!m_rawRecorder.Open(path))
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Failed to open raw measurement recording at " + path);
+		return -1;
+	}
+
+	// RAWX alone runs past 1KB per epoch with a full sky, take the whole link
+	if (RaiseBaudRateForBudget(static_cast<uint32_t>(Ublox::BAUDRATE::RATE_921600)) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Failed to raise baudrate for raw measurements");
+		m_rawRecorder.Close();
+		return -1;
+	}
+
+	// turn on UBX RXM RAWX - return -1 on error
+	if (ConfigureMessageDataStream(Ublox::UBX::RXM::classId, Ublox::UBX::RXM::RAWX::messageId, m_commsOnUart, m_commsOnUsb) < 0 ||
+		ConfigureMessageRate(Ublox::UBX::RXM::classId, Ublox::UBX::RXM::RAWX::messageId, 1) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Turning on UBX-RXM-RAWX failed");
+		m_rawRecorder.Close();
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	// turn on UBX RXM SFRBX - return -1 on error
+	if (ConfigureMessageDataStream(Ublox::UBX::RXM::classId, Ublox::UBX::RXM::SFRBX::messageId, m_commsOnUart, m_commsOnUsb) < 0 ||
+		ConfigureMessageRate(Ublox::UBX::RXM::classId, Ublox::UBX::RXM::SFRBX::messageId, 1) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Turning on UBX-RXM-SFRBX failed");
+		m_rawRecorder.Close();
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Recording raw measurements to " + path);
+	return 0;
+}
+
+int UbloxGps::DisableRawMeasurements()
+{
+	int rtn = 0;
+
+	if (ConfigureMessageRate(Ublox::UBX::RXM::classId, Ublox::UBX::RXM::RAWX::messageId, 0) < 0 ||
+		ConfigureMessageRate(Ublox::UBX::RXM::classId, Ublox::UBX::RXM::SFRBX::messageId, 0) < 0)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Turning off raw measurements failed");
+		rtn = -1;
+	}
+
+	m_rawRecorder.Close();
+
+	FrameRecorder::Stats stats = m_rawRecorder.GetStats();
+	m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Raw recording closed: " + std::to_string(stats.framesRecorded) + 
+		" frames, " + std::to_string(stats.framesDropped) + " dropped");
+	return rtn;
+}
+
+int UbloxGps::RaiseBaudRateForBudget(uint32_t requiredBitsPerSecond)
+{
+	// supported rates in ascending order, device value and matching serial port value
+	static const std::array<std::pair<Ublox::BAUDRATE, SerialClient::BaudRate>, 5> rates = { {
+		{ Ublox::BAUDRATE::RATE_9600,	SerialClient::BaudRate::BAUDRATE_9600	},
+		{ Ublox::BAUDRATE::RATE_38400,	SerialClient::BaudRate::BAUDRATE_38400	},
+		{ Ublox::BAUDRATE::RATE_115200,	SerialClient::BaudRate::BAUDRATE_115200	},
+		{ Ublox::BAUDRATE::RATE_460800,	SerialClient::BaudRate::BAUDRATE_460800	},
+		{ Ublox::BAUDRATE::RATE_921600,	SerialClient::BaudRate::BAUDRATE_921600	},
+	} };
+
+	// is the current port rate already enough
+	for (const auto& [deviceBaud, portBaud] : rates)
+	{
+		if (portBaud == m_baudrate && static_cast<uint32_t>(deviceBaud) >= requiredBitsPerSecond)
+		{
+			return 0;
+		}
+	}
+
+	for (const auto& [deviceBaud, portBaud] : rates)
+	{
+		if (static_cast<uint32_t>(deviceBaud) < requiredBitsPerSecond) continue;
+
+		m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Raising baudrate to " + std::to_string(static_cast<uint32_t>(deviceBaud)));
+
+		if (ConfigureDevicePort(Ublox::UBX::CFG::PRT::UART1::portId, deviceBaud) < 0)
+		{
+			m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Configuring device port failed");
+			return -1;
+		}
+
+		// the device switches after the current transmission, give it time before following
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		if (!m_comms.Reconfigure(m_path, portBaud, SerialClient::ByteSize::EIGHT, SerialClient::Parity::NONE, SerialClient::StopBits::ONE))
+		{
+			m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Reconfiguring serial port failed");
+			return -1;
+		}
+
+		m_comms.Flush();
+		m_baudrate = portBaud;
+		return 0;
+	}
+
+	return -1;
+}
+
+void UbloxGps::UpdateThroughput()
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	if (m_rateWindowStart == std::chrono::steady_clock::time_point{})
+	{
+		m_rateWindowStart = now;
+		return;
+	}
+
+	const double elapsedSecs = std::chrono::duration<double>(now - m_rateWindowStart).count();
+	if (elapsedSecs < 1.0) return;
+
+	{
+		std::scoped_lock lock(m_commonDataMutex);
+		m_data.PvtRateHz = m_rateWindowPvtCount / elapsedSecs;
+		m_data.UbxRateHz = m_rateWindowUbxCount / elapsedSecs;
+		m_commonData.navRateHz = m_data.PvtRateHz;
+		m_commonData.droppedCount = m_data.PvtDroppedCount;
+	}
+
+	m_rateWindowPvtCount = 0;
+	m_rateWindowUbxCount = 0;
+	m_rateWindowStart = now;
+
+	// only a high rate profile has an expected rate to compare against
+	if (m_navProfile == Ublox::NAV_PROFILE::STANDARD) return;
+
+	const double expectedHz = static_cast<double>(m_navProfile);
+	const bool degraded = m_data.PvtRateHz < (expectedHz * 0.9);
+
+	if (degraded && !m_navRateDegraded)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "PVT rate " + std::to_string(m_data.PvtRateHz) + 
+			"Hz below profile " + std::to_string(static_cast<int>(expectedHz)) + "Hz, dropped " + std::to_string(m_data.PvtDroppedCount));
+	}
+	else if (!degraded && m_navRateDegraded)
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Info, "PVT rate recovered to " + std::to_string(m_data.PvtRateHz) + "Hz");
+	}
+
+	m_navRateDegraded = degraded;
+}
+
 int UbloxGps::RequestUbxData(uint8_t classId, uint8_t messageId)
 {
 	// create a msg for sending. 
@@ -688,6 +1024,20 @@ int UbloxGps::Configure()
 	}
 	std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
+	// set dynamic model
+	if (ConfigureDynamics(Ublox::DYNAMICS::AIRBORNE_LESS_THAN_1G))
+	{
+		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Set Dynamics Model failed");
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	// high rate profiles trim the output set themselves, skip the standard message set
+	if (m_navProfile != Ublox::NAV_PROFILE::STANDARD)
+	{
+		return SetNavigationProfile(m_navProfile, m_navIncludeCovariance, m_navIncludeDop);
+	}
+
 	// turn on UBX NAV DOP - return -1 on error
 	if (ConfigureMessageDataStream(Ublox::UBX::NAV::classId, Ublox::UBX::NAV::DOP::messageId, m_commsOnUart, m_commsOnUsb) < 0)
 	{
@@ -848,14 +1198,6 @@ int UbloxGps::Configure()
 	}
 	std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-	// set dynamic model
-	if (ConfigureDynamics(Ublox::DYNAMICS::AIRBORNE_LESS_THAN_1G))
-	{
-		m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Set Dynamics Model failed");
-		return -1;
-	}
-	std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
 	// return success
 	return 0;
 }
@@ -1571,6 +1913,24 @@ void UbloxGps::ParseNavPositionVelocityTimeData(uint8_t* buffer)
 
 	// Increment message count
 	m_data.UbxPvtCount++;
+	m_rateWindowPvtCount++;
+
+	// with a known navigation rate, gaps in iTOW larger than one epoch are dropped solutions
+	if (m_navProfile != Ublox::NAV_PROFILE::STANDARD && m_havePvtTow)
+	{
+		const uint32_t periodInMs = 1000 / static_cast<uint32_t>(m_navProfile);
+		const uint32_t gapInMs = m_data.pvtData.gpsTowInMs - m_lastPvtTowInMs;
+
+		// ignore the week rollover and outages longer than a minute
+		if (m_data.pvtData.gpsTowInMs > m_lastPvtTowInMs && gapInMs < 1000 * 60)
+		{
+			const uint32_t epochs = (gapInMs + periodInMs / 2) / periodInMs;
+			if (epochs > 1) m_data.PvtDroppedCount += epochs - 1;
+		}
+	}
+
+	m_lastPvtTowInMs = m_data.pvtData.gpsTowInMs;
+	m_havePvtTow = true;
 }
 
 void UbloxGps::ParseNavStatusData(uint8_t* buffer)
@@ -1773,8 +2133,31 @@ void UbloxGps::UpdateCommonData()
 	m_commonData.latitude = m_data.pvtData.latitudeInDeg * 1e-7;
 	m_commonData.longitude = m_data.pvtData.longitudeInDeg * 1e-7;
 	m_commonData.altitude = m_data.pvtData.heightMslInMm * MM_TO_M;
+	m_commonData.fixType = m_data.pvtData.flags.bits.gnssFixOk ? m_data.pvtData.fixType : 0;
+	m_commonData.horizontalAccuracy = m_data.pvtData.horizontalAccuracyEstInMm / static_cast<double>(MM_TO_M);
+	m_commonData.verticalAccuracy = m_data.pvtData.verticalAccuracyEstInMm / static_cast<double>(MM_TO_M);
+	m_commonData.velocityNorth = m_data.pvtData.velocityNorthInMms / static_cast<double>(MM_TO_M);
+	m_commonData.velocityEast = m_data.pvtData.velocityEastInMms / static_cast<double>(MM_TO_M);
+	m_commonData.velocityDown = m_data.pvtData.velocityDownInMms / static_cast<double>(MM_TO_M);
+	m_commonData.velocityValid = m_commonData.fixType >= 3;
+	m_commonData.speedAccuracy = m_data.pvtData.speedAccuracyEstInMms / static_cast<double>(MM_TO_M);
+
+	// NAV-COV follows the PVT of the same epoch, only use it once it has arrived for this one
+	const Ublox::UBX::NAV::COV::Message& cov = m_data.navCovarianceData;
+	const bool covarianceCurrent = m_navIncludeCovariance && cov.gpsTowInMs == m_data.pvtData.gpsTowInMs;
+	m_commonData.positionCovarianceValid = covarianceCurrent && cov.posCovValid;
+	m_commonData.velocityCovarianceValid = covarianceCurrent && cov.velCovValid;
+	if (covarianceCurrent)
+	{
+		const float position[6] = { cov.positionCovNN, cov.positionCovNE, cov.positionCovND, cov.positionCovEE, cov.positionCovED, cov.positionCovDD };
+		const float velocity[6] = { cov.velocityCovNN, cov.velocityCovNE, cov.velocityCovND, cov.velocityCovEE, cov.velocityCovED, cov.velocityCovDD };
+		std::copy(position, position + 6, m_commonData.positionCovariance);
+		std::copy(velocity, velocity + 6, m_commonData.velocityCovariance);
+	}
 	m_commonData.rxCount = m_data.UbxRxCount + m_data.NmeaRxCount;
 	m_commonData.rxErrorCount = m_data.ChecksumFailCount;
+	m_commonData.rxFirstByteNs = m_pvtRxStamp.firstByteNs;
+	m_commonData.rxLastByteNs = m_pvtRxStamp.lastByteNs;
 }
 
 // Decoders
@@ -12,10 +12,13 @@
 //          ------------------              ------------------------
 #include <string>                           // strings
 #include <cstdint>							// standard ints
+#include <chrono>							// message rate windows
 //
 #include "gps_type.h"                       // base class
 #include "ublox_info.h"                     // gps info
 #include "../utilities/constants.h"			// conversions
+#include "../utilities/frame_recorder.h"	// raw measurement recording
+#include "../utilities/aligned_buffer.h"	// framer buffers
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -122,8 +125,13 @@ struct UbloxData
 	unsigned long UbxTimeUtcCount		= 0;
 	unsigned long UbxPvtCount			= 0;
 	unsigned long UbxGpsTimeCount		= 0;
+	unsigned long UbxRawxCount			= 0;
+	unsigned long UbxSfrbxCount			= 0;
 	unsigned long NmeaRxCount			= 0;
 	unsigned long ChecksumFailCount		= 0;
+	unsigned long PvtDroppedCount		= 0;
+	double		  PvtRateHz				= 0;
+	double		  UbxRateHz				= 0;
 };
 
 /// @brief 
@@ -134,6 +142,15 @@ public:
     /// @brief Default Constructor
     UbloxGps(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate);
 
+	/// @brief Full Constructor
+	/// @param profile - [in] - Navigation profile to configure the receiver for
+	/// @param includeCovariance - [in] - Keep UBX-NAV-COV in the output set when running a high rate profile
+	/// @param includeDop - [in] - Keep UBX-NAV-DOP in the output set when running a high rate profile
+	/// @param bufferSize - [in/opt] - Size of the framer buffers, raised to Ublox::MIN_FRAME_BUFFER_SIZE if smaller
+	UbloxGps(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate, 
+		const Ublox::NAV_PROFILE profile, const bool includeCovariance, const bool includeDop,
+		const size_t bufferSize = Ublox::FRAME_BUFFER_SIZE);
+
     /// @brief Default Deconstructor
     ~UbloxGps() {}
 
@@ -146,6 +163,28 @@ public:
 	/// @return -1 on error, 0+ on success
 	int	RestartDevice(Ublox::START_TYPE start, Ublox::RESET_TYPE reset);
 
+	/// @brief Sets a high rate navigation profile. Trims the output set to UBX-NAV-PVT plus the optional
+	/// COV/DOP messages and raises the port baudrate when the selected rate does not fit the link.
+	/// @param profile - [in] - Desired navigation profile, STANDARD is not accepted here
+	/// @param includeCovariance - [in] - Keep UBX-NAV-COV in the output set
+	/// @param includeDop - [in] - Keep UBX-NAV-DOP in the output set
+	/// @return -1 on error, else 0
+	int SetNavigationProfile(Ublox::NAV_PROFILE profile, bool includeCovariance, bool includeDop);
+
+	/// @brief Enables UBX-RXM-RAWX and UBX-RXM-SFRBX and records the frames untouched to disk.
+	/// The port is raised to 921600 baud to carry the raw measurements next to the navigation output.
+	/// @param path - [in] - recording path without extension, "<path>.bin" and "<path>.idx" are written
+	/// @return -1 on error, else 0
+	int EnableRawMeasurements(const std::string& path);
+
+	/// @brief Disables the raw measurement messages and closes the recording
+	/// @return -1 on error, else 0
+	int DisableRawMeasurements();
+
+	/// @brief Get the raw measurement recorder statistics
+	/// @return copy of the recorder statistics
+	FrameRecorder::Stats GetRawRecordingStats() const { return m_rawRecorder.GetStats(); }
+
 	GpsData GetCommonData();
 
 protected:
@@ -184,6 +223,14 @@ private:
 	/// @return -1 on error, else 0
 	int ConfigureDevicePort(uint8_t portId, Ublox::BAUDRATE baud);
 
+	/// @brief Raises the device port and our serial port to the first baudrate that fits the requested link budget
+	/// @param requiredBitsPerSecond - [in] - bits per second the output set needs, including headroom
+	/// @return -1 on error or if no supported baudrate fits, else 0
+	int RaiseBaudRateForBudget(uint32_t requiredBitsPerSecond);
+
+	/// @brief Closes the message rate window once a second and updates the achieved rates
+	void UpdateThroughput();
+
 	/// @brief  Allows us to change the configured messaging data rates as desired. 
 	/// GPS Ex. (Ublox::UBX::CFG::RATE::GPS_SOURCE, Ublox::UBX::CFG::RATE::MEASURE_HZ10, Ublox::UBX::CFG::RATE::NAV_CYCLES2).
 	///	This would set GPS satellite measurement data rate at 10hz and satellite data rate at 2 cycles within this 10hz = 5hz.
@@ -427,6 +474,28 @@ private:
 
     UbloxData m_data = {};              /// Data storage
 
+	// Framer state, aligned so parallel parsers never share a cache line
+	alignas(CACHE_LINE_SIZE) AlignedBuffer m_inBuffer;		/// Bytes read and not yet framed
+	AlignedBuffer		m_msgBuffer;						/// Framed message handed to the decoders
+	unsigned int		m_bytesInBuffer			= 0;		/// Bytes held in m_inBuffer
+	unsigned int		m_msgLength				= 0;		/// Length of the message left in m_msgBuffer
+	bool				m_firstRead				= true;		/// Flush stale port data on the first read
+
 	const int m_commsOnUsb = 0;
 	const int m_commsOnUart = 1;
+
+	Ublox::NAV_PROFILE	m_navProfile			= Ublox::NAV_PROFILE::STANDARD;		/// Requested navigation profile
+	bool				m_navIncludeCovariance	= false;							/// Keep NAV-COV in a high rate output set
+	bool				m_navIncludeDop			= false;							/// Keep NAV-DOP in a high rate output set
+	bool				m_navRateDegraded		= false;							/// Achieved rate is below the profile rate
+
+	std::chrono::steady_clock::time_point m_rateWindowStart = {};					/// Start of the current rate window
+	unsigned long		m_rateWindowPvtCount	= 0;								/// PVT messages received in the window
+	unsigned long		m_rateWindowUbxCount	= 0;								/// UBX messages received in the window
+	uint32_t			m_lastPvtTowInMs		= 0;								/// iTOW of the last PVT message
+	bool				m_havePvtTow			= false;							/// Flag for if m_lastPvtTowInMs is valid
+
+	RxStamp				m_pvtRxStamp			= {};								/// Receive stamp of the last PVT message
+
+	FrameRecorder		m_rawRecorder;												/// Raw measurement recording
 };
\ No newline at end of file
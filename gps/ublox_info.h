@@ -24,6 +24,18 @@ namespace Ublox
     /// @brief Number of sync bytes in ubx messages
     constexpr int NUM_SYNC_BYTES = 2;
 
+    /// @brief Default size of the framer buffers, large enough for a full RXM-RAWX / RXM-SFRBX burst
+    constexpr int FRAME_BUFFER_SIZE = 8192;
+
+    /// @brief Smallest framer buffer accepted, fits every NAV message and an NMEA sentence. Raw
+    /// measurement recording needs room for MAX_RAWX_FRAME_SIZE.
+    constexpr int MIN_FRAME_BUFFER_SIZE = 1024;
+
+    /// @brief Largest UBX-RXM-RAWX frame, 16 byte payload head and 32 bytes for each of up to 255
+    /// measurements, plus the 6 byte header and 2 byte checksum
+    constexpr int MAX_RAWX_FRAME_SIZE = 16 + 32 * 255 + 8;
+    static_assert(FRAME_BUFFER_SIZE >= MAX_RAWX_FRAME_SIZE, "default framer buffer must hold a full RAWX frame");
+
     /// @brief enum for GNSS fix values. 
     enum class GNSS_FIX_TYPE
     {
@@ -71,12 +83,24 @@ namespace Ublox
         TEN = 0x0A,
     };
 
+    /// @brief enum for the navigation profiles, value is the navigation solution rate in Hz. 
+    /// STANDARD leaves the rates selected in Configure() by software version.
+    enum class NAV_PROFILE : uint8_t
+    {
+        STANDARD = 0,
+        HZ10 = 10,
+        HZ20 = 20,
+        HZ25 = 25,
+    };
+
     /// @brief Ublox acceptable baudrates
     enum class BAUDRATE : uint32_t
     {
         RATE_9600 = 0x2580,
         RATE_38400 = 0x9600,
         RATE_115200 = 0x1C200,
+        RATE_460800 = 0x70800,
+        RATE_921600 = 0xE1000,
     };
 
     /// @brief Map for string to UBLOX_SW_VERSION enum value
@@ -162,6 +186,8 @@ namespace Ublox
                 constexpr uint8_t MEASURE_HZ1 = 0xE8;
                 constexpr uint8_t MEASURE_HZ5 = 0xC8;
                 constexpr uint8_t MEASURE_HZ10 = 0x64;
+                constexpr uint8_t MEASURE_HZ20 = 0x32;
+                constexpr uint8_t MEASURE_HZ25 = 0x28;
 
                 constexpr uint8_t NAV_CYCLES1 = 0x01;
                 constexpr uint8_t NAV_CYCLES2 = 0x02;
@@ -294,6 +320,23 @@ namespace Ublox
             }
         }
 
+        namespace RXM
+        {
+            constexpr uint8_t classId = 0x02;
+
+            //! @brief Multi-GNSS raw measurements, recorded whole and not decoded
+            namespace RAWX
+            {
+                constexpr uint8_t messageId = 0x15;
+            }
+
+            //! @brief Broadcast navigation data subframes, recorded whole and not decoded
+            namespace SFRBX
+            {
+                constexpr uint8_t messageId = 0x13;
+            }
+        }
+
         namespace NAV
         {
             constexpr uint8_t classId = 0x01;
@@ -11,13 +11,22 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include <string>                           // strings
+#include <algorithm>                        // min
+#include <cstring>                          // strerror
+#ifdef __linux__
+#include <poll.h>                           // poll
+#include <pthread.h>                        // affinity, scheduling
+#include <sched.h>                          // SCHED_FIFO
+#include <sys/mman.h>                       // mlockall
+#endif
 //
 #include "imu_manager.h"                    // header
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
 ImuManager::ImuManager(LogClient& logger) : m_currentImuType(ImuOptions::Unknown), m_name("IMU MGR"),
-    m_configured(false), m_logger(logger), m_port(""), m_baudrate(SerialClient::BaudRate::BAUDRATE_INVALID), m_run(false)
+    m_configured(false), m_logger(logger), m_port(""), m_baudrate(SerialClient::BaudRate::BAUDRATE_INVALID), m_run(false),
+    m_cpuCore(-1), m_rtPriority(0), m_topic(nullptr), m_lastPublishedNs(0)
 {
     m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Initialized.");
 }
@@ -56,7 +65,7 @@ bool ImuManager::Configure(const ImuOptions option, const std::string port, cons
     {
     case ImuOptions::IL_Kernel210:
     case ImuOptions::IL_Kernel110:
-        m_imu = std::make_unique<InertialLabs>(m_logger, portUpdate, baudrate);
+        m_imu = std::make_unique<InertialLabsImu>(m_logger, portUpdate, baudrate);
         break;
     case ImuOptions::Unknown:
         // Intentionally do nothing... 
@@ -70,22 +79,198 @@ bool ImuManager::Configure(const ImuOptions option, const std::string port, cons
     return true;
 }
 
-void ImuManager::Start()
+void ImuManager::Start(const int cpuCore, const int rtPriority, const bool lockMemory)
 {
-    // Start the IMU in a blocking function
+    if (m_run) return;
+
+    if (m_imu == nullptr)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "No IMU configured, acquisition not started.");
+        return;
+    }
+
+    m_cpuCore = cpuCore;
+    m_rtPriority = rtPriority;
+
+    // process wide, done before the thread starts so its stack is locked too
+    if (lockMemory)
+    {
+#ifdef __linux__
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Failed to lock memory: " + std::string(std::strerror(errno)));
+        }
+#else
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Memory locking is not supported on this platform.");
+#endif
+    }
+
+    m_run = true;
+    m_thread = std::thread(&ImuManager::AcquisitionLoop, this);
 }
 
 void ImuManager::Stop()
 {
-    // Stop the IMU
+    m_run = false;
+    if (m_thread.joinable()) m_thread.join();
 }
 
 int ImuManager::CheckForData()
 {
-    return m_imu->ProcessData();
+    if (m_imu == nullptr) return -1;
+
+    // the acquisition thread owns the port while it runs
+    if (m_run) return 0;
+
+    int rtn = m_imu->ProcessData();
+    if (rtn > 0) PublishLatest();
+    return rtn;
+}
+
+void ImuManager::SetTopic(ImuTopic* topic)
+{
+    if (m_run)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Topic must be set before the acquisition thread starts.");
+        return;
+    }
+
+    m_topic = topic;
+}
+
+ImuData ImuManager::GetCommonData()
+{
+    if (m_imu == nullptr) return {};
+    return m_imu->GetCommonData();
+}
+
+ImuAcquisitionStats ImuManager::GetAcquisitionStats()
+{
+    if (m_imu == nullptr) return {};
+    return m_imu->GetAcquisitionStats();
+}
+
+bool ImuManager::PopSample(ImuSample& sample)
+{
+    if (m_imu == nullptr) return false;
+    return m_imu->PopSample(sample);
 }
 
 int ImuManager::Send(const std::byte* data, const size_t length)
 {
     return m_commPort.Write(data, length);
-}
\ No newline at end of file
+}
+
+ImuIncrement ImuManager::Integrate(const int64_t untilNs)
+{
+    if (m_imu == nullptr) return {};
+
+    while (const ImuSample* sample = m_imu->PeekSample())
+    {
+        if (sample->timestampNs > untilNs) break;
+
+        m_preIntegrator.Add(*sample);
+        m_imu->ConsumeSample();
+    }
+
+    return m_preIntegrator.Take();
+}
+
+void ImuManager::AcquisitionLoop()
+{
+    ApplyThreadOptions();
+
+#ifdef __linux__
+    pollfd descriptor = {};
+    descriptor.fd = m_imu->GetHandle();
+    descriptor.events = POLLIN;
+
+    if (descriptor.fd == INVALID_HANDLE_VALUE)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "IMU port is not open, acquisition stopped.");
+        return;
+    }
+
+    while (m_run)
+    {
+        // Sleep until the unit sends something, wake periodically to check for a stop
+        int ready = poll(&descriptor, 1, ACQUISITION_POLL_TIMEOUT_MS);
+        if (ready < 0)
+        {
+            if (errno == EINTR) continue;
+
+            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Polling the IMU port failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+
+        if (ready == 0) continue;
+
+        if (descriptor.revents & (POLLERR | POLLHUP | POLLNVAL))
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "IMU port closed, acquisition stopped.");
+            break;
+        }
+
+        if (m_imu->ProcessData() > 0) PublishLatest();
+    }
+#else
+    while (m_run)
+    {
+        // Look for new data, keep reading while the unit has more buffered
+        if (m_imu->ProcessData() > 0)
+        {
+            PublishLatest();
+            continue;
+        }
+
+        // Rest
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#endif
+}
+
+void ImuManager::ApplyThreadOptions()
+{
+#ifdef __linux__
+    if (m_cpuCore >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(m_cpuCore, &cpus);
+
+        int rtn = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (rtn != 0)
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Failed to pin acquisition to core " + std::to_string(m_cpuCore) + ": " + std::strerror(rtn));
+        }
+    }
+
+    if (m_rtPriority > 0)
+    {
+        sched_param param = {};
+        param.sched_priority = std::min(m_rtPriority, sched_get_priority_max(SCHED_FIFO));
+
+        int rtn = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rtn != 0)
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Failed to set SCHED_FIFO priority " + std::to_string(param.sched_priority) + ": " + std::strerror(rtn));
+        }
+    }
+#else
+    if (m_cpuCore >= 0 || m_rtPriority > 0)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Core pinning and real time priority are not supported on this platform.");
+    }
+#endif
+}
+
+void ImuManager::PublishLatest()
+{
+    if (m_topic == nullptr) return;
+
+    ImuData data = m_imu->GetCommonData();
+    if (data.timestampNs == m_lastPublishedNs) return;
+
+    m_lastPublishedNs = data.timestampNs;
+    m_topic->Publish(data);
+}
@@ -12,9 +12,12 @@
 //          ------------------              ------------------------
 #include <string>                           // strings
 #include <unordered_map>                    // unordered map
+#include <thread>                           // acquisition thread
+#include <atomic>                           // atomics
 //
 #include "../utilities/log_client.h"        // logger
 #include "inertial_labs.h"                  // inertial labs 
+#include "imu_preintegrator.h"              // pre-integration
 #include "../utilities/constants.h"         // constants
 // 
 /////////////////////////////////////////////////////////////////////////////////
@@ -46,26 +49,63 @@ public:
     /// @return - true if successful, false if already configured and connection is opened. 
     bool Configure(const ImuOptions option, const std::string port, const SerialClient::BaudRate baudrate);
 
-    /// @brief Start the connection to the IMU
-    void Start();
+    /// @brief Publish every new sample's ImuData on a topic, set before Start()
+    /// @param topic - in - topic to publish on, nullptr to stop publishing
+    void SetTopic(ImuTopic* topic);
 
-    /// @brief Stop the connection to the IMU
+    /// @brief Start the acquisition thread. It blocks on the IMU port and queues every sample as it is read.
+    /// @param cpuCore - in - opt - core to pin the thread to, -1 leaves it to the scheduler
+    /// @param rtPriority - in - opt - SCHED_FIFO priority 1-99, 0 keeps normal scheduling
+    /// @param lockMemory - in - opt - lock the process memory so a page fault cannot stall a read
+    void Start(const int cpuCore = -1, const int rtPriority = 0, const bool lockMemory = false);
+
+    /// @brief Stop and join the acquisition thread if it was started
     void Stop();
 
-    /// @brief Read and Process data from the configured IMU
-    /// @return -1 on error, else number of bytes read
+    /// @brief Read and Process data from the configured IMU, only needed when Start() has not been called
+    /// @return -1 on error, 0 when the acquisition thread is reading, else number of bytes read
     int CheckForData();
 
+    /// @brief Get the latest common data, safe while the acquisition thread runs
+    /// @return copy of the latest ImuData, defaults if no IMU is configured
+    ImuData GetCommonData();
+
+    /// @brief Get the sample read latency and gap statistics
+    /// @return copy of the stats, defaults if no IMU is configured
+    ImuAcquisitionStats GetAcquisitionStats();
+
+    /// @brief Take the oldest queued sample. Only one consumer thread may take samples.
+    /// @param sample - out - oldest sample
+    /// @return true if a sample was taken, false if none are queued
+    bool PopSample(ImuSample& sample);
+
     /// @brief Send data for the configured IMU
     /// @param data - in - reference to the data to be sent
     /// @param length - in - number of bytes to send
     /// @return -1 on error, else number of bytes sent
     int Send(const std::byte* data, const size_t length);
 
+    /// @brief Pre-integrate every queued sample up to a time, for a consumer running slower than the IMU
+    /// @param untilNs - [in] - monotonic time, samples after it stay queued for the next call
+    /// @return coning and sculling compensated increments since the last call
+    ImuIncrement Integrate(const int64_t untilNs);
+
 protected:
 
 private:
 
+    /// @brief Longest the acquisition thread waits on the port before checking for a stop
+    static constexpr int ACQUISITION_POLL_TIMEOUT_MS = 100;
+
+    /// @brief Acquisition thread body, waits on the port and processes whatever arrives
+    void AcquisitionLoop();
+
+    /// @brief Apply the core pinning and priority to the calling thread
+    void ApplyThreadOptions();
+
+    /// @brief Publish the common data if a sample arrived since the last publish
+    void PublishLatest();
+
     // enum to string conversion for convenience mapping
     std::unordered_map<ImuOptions, std::string> ImuOptionsMap
     {
@@ -83,5 +123,11 @@ private:
     std::unique_ptr<ImuType>    m_imu;              /// Holds a pointer to the utilized IMU type. 
     SerialClient                m_commPort;         /// Holds connection to serial port
     std::atomic_bool            m_run;              /// Holds an bool to kill the main loop
+    ImuPreIntegrator            m_preIntegrator;    /// Increments between Integrate() calls
+    std::thread                 m_thread;           /// Acquisition thread when started
+    int                         m_cpuCore;          /// Core the acquisition thread is pinned to, -1 for none
+    int                         m_rtPriority;       /// SCHED_FIFO priority of the acquisition thread, 0 for none
+    ImuTopic*                   m_topic;            /// Topic samples are published on, nullptr for none
+    int64_t                     m_lastPublishedNs;  /// Time of the last sample published
 
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            imu_preintegrator.cpp
+// @brief           Implementation for the IMU pre-integrator
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include "imu_preintegrator.h"              // header
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /// @brief out = a x b
+    inline void Cross(const double a[3], const double b[3], double out[3])
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+}
+
+void ImuPreIntegrator::Add(const ImuSample& sample)
+{
+    double deltaAngle[3];
+    double deltaVelocity[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        deltaAngle[axis] = sample.gyro[axis] * sample.intervalSec;
+        deltaVelocity[axis] = sample.accel[axis] * sample.intervalSec;
+    }
+
+    // rotation so far plus a sixth of the previous increment, shared by both corrections
+    double angleLead[3];
+    double velocityLead[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        angleLead[axis] = m_alpha[axis] + m_lastDeltaAngle[axis] / 6.0;
+        velocityLead[axis] = m_nu[axis] + m_lastDeltaVelocity[axis] / 6.0;
+    }
+
+    // coning  += 1/2 (alpha + dTheta' / 6) x dTheta
+    // sculling += 1/2 ((alpha + dTheta' / 6) x dV + (nu + dV' / 6) x dTheta)
+    double coning[3];
+    double scullingA[3];
+    double scullingB[3];
+    Cross(angleLead, deltaAngle, coning);
+    Cross(angleLead, deltaVelocity, scullingA);
+    Cross(velocityLead, deltaAngle, scullingB);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        m_coning[axis] += 0.5 * coning[axis];
+        m_sculling[axis] += 0.5 * (scullingA[axis] + scullingB[axis]);
+        m_alpha[axis] += deltaAngle[axis];
+        m_nu[axis] += deltaVelocity[axis];
+        m_lastDeltaAngle[axis] = deltaAngle[axis];
+        m_lastDeltaVelocity[axis] = deltaVelocity[axis];
+    }
+
+    if (m_sampleCount == 0)
+    {
+        m_startNs = sample.timestampNs - static_cast<int64_t>(sample.intervalSec * 1.0e9);
+    }
+
+    m_intervalSec += sample.intervalSec;
+    m_endNs = sample.timestampNs;
+    m_sampleCount++;
+}
+
+ImuIncrement ImuPreIntegrator::Take()
+{
+    ImuIncrement increment = {};
+    increment.intervalSec = m_intervalSec;
+    increment.startNs = m_startNs;
+    increment.endNs = m_endNs;
+    increment.sampleCount = m_sampleCount;
+
+    // velocity rotation compensation 1/2 alpha x nu, the rest of the sculling is already summed
+    double rotation[3];
+    Cross(m_alpha, m_nu, rotation);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        increment.deltaAngle[axis] = m_alpha[axis] + m_coning[axis];
+        increment.deltaVelocity[axis] = m_nu[axis] + 0.5 * rotation[axis] + m_sculling[axis];
+
+        m_alpha[axis] = 0.0;
+        m_nu[axis] = 0.0;
+        m_coning[axis] = 0.0;
+        m_sculling[axis] = 0.0;
+    }
+
+    m_intervalSec = 0.0;
+    m_startNs = m_endNs;
+    m_sampleCount = 0;
+
+    return increment;
+}
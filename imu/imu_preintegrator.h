@@ -0,0 +1,61 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            imu_preintegrator.h
+// @brief           Coning and sculling compensated IMU pre-integration
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstdint>                          // standard ints
+//
+#include "imu_type.h"                       // imu sample
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Attitude and velocity increments over an interval of samples
+struct ImuIncrement
+{
+    double  deltaAngle[3]       = {};       // rad, rotation vector from the body frame at the start to the body frame at the end
+    double  deltaVelocity[3]    = {};       // m/s, specific force velocity change resolved in the body frame at the start
+    double  intervalSec         = 0.0;      // time covered by the samples
+    int64_t startNs             = 0;        // monotonic time the interval starts
+    int64_t endNs               = 0;        // monotonic time of the last sample
+    long    sampleCount         = 0;        // samples integrated
+};
+
+/// @brief Integrates high rate samples into increments for a slower consumer. Uses the recursive
+/// two sample coning and sculling terms, so the increments hold up under vibration the way
+/// summing the samples does not.
+class ImuPreIntegrator
+{
+public:
+
+    /// @brief Add the next sample to the current interval
+    /// @param sample - [in] - sample, samples must be added in time order
+    void Add(const ImuSample& sample);
+
+    /// @brief Finish the current interval and start the next one
+    /// @return increments over every sample added since the last call
+    ImuIncrement Take();
+
+    /// @brief Number of samples in the current interval
+    /// @return sample count
+    long SampleCount() const { return m_sampleCount; }
+
+private:
+
+    double      m_alpha[3]              = {};       /// Summed delta angles
+    double      m_nu[3]                 = {};       /// Summed delta velocities
+    double      m_coning[3]             = {};       /// Coning correction
+    double      m_sculling[3]           = {};       /// Sculling correction
+    double      m_lastDeltaAngle[3]     = {};       /// Delta angle of the previous sample, carried between intervals
+    double      m_lastDeltaVelocity[3]  = {};       /// Delta velocity of the previous sample, carried between intervals
+    double      m_intervalSec           = 0.0;      /// Time covered in the current interval
+    int64_t     m_startNs               = 0;        /// Start of the current interval
+    int64_t     m_endNs                 = 0;        /// Time of the last sample added
+    long        m_sampleCount           = 0;        /// Samples in the current interval
+};
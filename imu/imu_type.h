@@ -11,27 +11,74 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include <string>                           // strings
+#include <cstdint>                          // standard ints
+#include <atomic>                           // dropped sample count
+#include <mutex>                            // common data safety
 //
 #include "../utilities/serial_client.h"     // serial client
 #include "../utilities/log_client.h"        // logger
+#include "../utilities/rx_timing.h"         // receive stamps
+#include "../utilities/spsc_ring.h"         // sample ring
+#include "../utilities/seqlock_ring.h"      // stats snapshots
+#include "../utilities/topic.h"             // imu topic
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
 /// @brief The template of common IMU data
 struct ImuData
 {
-    double roll             = 0.0;
-    double pitch            = 0.0;
-    double yaw              = 0.0;
-    double rollDelta        = 0.0;
-    double pitchDelta       = 0.0;
-    double yawDelta         = 0.0;
+    double roll             = 0.0;          // rad
+    double pitch            = 0.0;          // rad
+    double yaw              = 0.0;          // rad
+    double rollDelta        = 0.0;          // rad, x body rate over the last sample interval
+    double pitchDelta       = 0.0;          // rad, y body rate over the last sample interval
+    double yawDelta         = 0.0;          // rad, z body rate over the last sample interval
+
+    double gyroX            = 0.0;          // rad/s
+    double gyroY            = 0.0;          // rad/s
+    double gyroZ            = 0.0;          // rad/s
+    double accelX           = 0.0;          // m/s^2
+    double accelY           = 0.0;          // m/s^2
+    double accelZ           = 0.0;          // m/s^2
+    double temperature      = 0.0;          // C
+
+    int64_t timestampNs         = 0;        // monotonic time the last byte of the sample was read
+    double  sampleIntervalSec   = 0.0;      // measured time between samples, 0 until the first second is seen
+    long    sampleCount         = 0;        // samples decoded
+    long    droppedSampleCount  = 0;        // samples lost to a full sample ring
+
+    long    rxCount         = 0;            // receive count
+    long    rxErrorCount    = 0;            // receive error count
 
     bool hardwareError      = false;        // @todo fix these with some proper error types ??? 
     bool softwareError      = false;        // @todo fix these with some proper error types ??? 
 
 };
 
+/// @brief One timestamped IMU sample as queued for consumers
+struct ImuSample
+{
+    int64_t timestampNs     = 0;            // monotonic time of the sample
+    double  intervalSec     = 0.0;          // time the sample covers
+    double  gyro[3]         = {};           // rad/s, body x y z
+    double  accel[3]        = {};           // m/s^2, body x y z
+};
+
+/// @brief Timing of the samples as they were queued
+struct ImuAcquisitionStats
+{
+    LatencyHistogram    readLatency     = {};       // sample time to queued, includes waiting on a burst read
+    LatencyHistogram    sampleGap       = {};       // time between consecutive samples
+    int64_t             maxGapNs        = 0;        // longest time between consecutive samples
+    uint64_t            longGapCount    = 0;        // gaps over twice the mean gap, usually lost samples
+};
+
+/// @brief Samples the ring holds, half a second at 2kHz
+constexpr size_t IMU_SAMPLE_RING_SIZE = 1024;
+
+/// @brief Bus topic for ImuData, a quarter second at 1kHz for queued subscribers
+using ImuTopic = Topic<ImuData, 256>;
+
 /// @brief The base class for an IMU unit for WASP
 class ImuType
 {
@@ -50,7 +97,7 @@ public:
     }
 
     /// @brief 
-    ~ImuType() 
+    virtual ~ImuType() 
     {
         m_comms.Close();
         m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Uninitialized.");
@@ -60,20 +107,77 @@ public:
     /// @return -1 on error, else number of bytes read and processed
     virtual int ProcessData() = 0;
 
-    /// @brief 
-    /// @return 
-    ImuData GetCommonData() const { return m_commonData; }
+    /// @brief Get a copy of the common IMU data, safe to call while another thread processes data
+    /// @return ImuData copy
+    ImuData GetCommonData()
+    {
+        std::scoped_lock lock(m_commonDataMutex);
+        return m_commonData;
+    }
+
+    /// @brief Get a copy of the sample timing statistics, never holds up the acquisition thread
+    /// @return stats since the unit was created
+    ImuAcquisitionStats GetAcquisitionStats()
+    {
+        // A copy the acquisition thread laps is read again, only this reader waits
+        ImuAcquisitionStats stats = {};
+        while (m_statsSnapshots.Count() > 0 && !m_statsSnapshots.Latest(stats)) {}
+        return stats;
+    }
+
+    /// @brief Get the serial handle so a reader can block until the unit sends data
+    /// @return handle of the serial port, INVALID_HANDLE_VALUE if not open
+    HANDLE GetHandle() const { return m_comms.GetHandle(); }
+
+    /// @brief Take the oldest queued sample. Only one consumer thread may call this.
+    /// @param sample - [out] - oldest sample
+    /// @return true if a sample was taken, false if none are queued
+    bool PopSample(ImuSample& sample) { return m_samples.TryPop(sample); }
+
+    /// @brief Look at the oldest queued sample without taking it. Only one consumer thread may call this.
+    /// @return pointer to the oldest sample, valid until it is popped, or nullptr if none are queued
+    const ImuSample* PeekSample() { return m_samples.Front(); }
+
+    /// @brief Drop the sample returned by PeekSample()
+    void ConsumeSample() { m_samples.Pop(); }
 
 protected:
     /// @brief 
     virtual void UpdateCommonData() = 0;
 
+    /// @brief Queue a sample for consumers, called once per decoded sample
+    /// @param sample - [in] - sample to queue
+    void PublishSample(const ImuSample& sample)
+    {
+        if (!m_samples.TryPush(sample)) m_samplesDropped++;
+
+        // The stats belong to this thread, readers are handed a snapshot so it never waits on them
+        m_stats.readLatency.Record(MonotonicNowNs() - sample.timestampNs);
+
+        if (m_lastPublishedNs > 0)
+        {
+            const int64_t gap = sample.timestampNs - m_lastPublishedNs;
+            if (m_stats.sampleGap.Count() > 0 && gap > 2.0 * m_stats.sampleGap.MeanNs()) m_stats.longGapCount++;
+            if (gap > m_stats.maxGapNs) m_stats.maxGapNs = gap;
+            m_stats.sampleGap.Record(gap);
+        }
+        m_lastPublishedNs = sample.timestampNs;
+        m_statsSnapshots.Write(m_stats);
+    }
+
     std::string             m_name              = "";           /// name of the unit
     ImuData                 m_commonData        = {};           /// Holds common data 
+    std::mutex              m_commonDataMutex   = {};           /// Safety for common data
     LogClient&              m_logger;
     std::string             m_path              = "";           /// Holds the path to desired serial port
     SerialClient::BaudRate  m_baudrate          = SerialClient::BaudRate::BAUDRATE_INVALID;     /// Holds the baudrate
     SerialClient            m_comms;                            /// Holds the serial client
+    RxTimeline              m_rxTimeline        = {};           /// Read times of the bytes in the parse buffer
+    SpscRing<ImuSample, IMU_SAMPLE_RING_SIZE> m_samples;        /// Every decoded sample, oldest first
+    std::atomic<long>       m_samplesDropped    = 0;            /// Samples lost to a full ring
+    ImuAcquisitionStats     m_stats             = {};           /// Sample timing, acquisition thread owned
+    int64_t                 m_lastPublishedNs   = 0;            /// Time of the last queued sample
+    SeqlockRing<ImuAcquisitionStats, 4> m_statsSnapshots;       /// Copies of m_stats for readers
 
     long                    m_txCount           = 0;            /// transmit count
     long                    m_txErrorCount      = 0;            /// transmit error count
@@ -1,4 +1,3 @@
-
 /////////////////////////////////////////////////////////////////////////////////
 // @file            inertial_labs.cpp
 // @brief           Implementation for the inertial labs Imu class
@@ -10,18 +9,333 @@
 // Includes:
 //          name                            reason included
 //          ------------------              ------------------------
-#include    "inertial_labs.h"                 // Header
-// 
+#include    <algorithm>                     // max
+#include    <cstring>                       // memchr, memmove
+#include    <numbers>                       // pi
+//
+#include    "inertial_labs.h"               // Header
+#include    "../utilities/checksum.h"       // byte sum
+//
 /////////////////////////////////////////////////////////////////////////////////
 
-int InertialLabs::ProcessData()
+namespace
+{
+    constexpr double DEG_TO_RAD = std::numbers::pi / 180.0;
+}
+
+InertialLabsImu::InertialLabsImu(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate,
+    const InertialLabs::MSG_ID outputFormat, const size_t bufferSize) :
+    ImuType("ILABS", logger, path, baudrate), m_outputFormat(outputFormat),
+    m_inBuffer(std::max<size_t>(bufferSize, InertialLabs::MIN_FRAME_BUFFER_SIZE))
+{
+    // Start the continuous output, the unit may already be streaming from its saved settings
+    if (SendCommand(m_outputFormat) < 0)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Failed to start continuous output.");
+    }
+}
+
+InertialLabsImu::~InertialLabsImu()
+{
+    SendCommand(InertialLabs::MSG_ID::STOP);
+}
+
+int InertialLabsImu::ProcessData()
+{
+    bool newSample = false;
+
+    // Framer state lives in the instance so units and threads never share it
+    unsigned int& bytesInBuffer = m_bytesInBuffer;
+    uint8_t* inBuffer = m_inBuffer.Data();
+    const unsigned int bufferSize = static_cast<unsigned int>(m_inBuffer.Size());
+
+    // dump existing data
+    if (m_firstRead)
+    {
+        m_firstRead = false;
+        m_comms.Flush();
+        bytesInBuffer = 0;
+        m_rxTimeline.Reset();
+    }
+
+    // read bytes from port into buffer - only read in the max amount
+    int bytesRead = m_comms.Read(reinterpret_cast<std::byte*>(&inBuffer[bytesInBuffer]), bufferSize - bytesInBuffer);
+
+    if (bytesRead <= 0) return bytesRead;
+
+    bytesInBuffer += bytesRead;
+    m_rxTimeline.Append(bytesRead, MonotonicNowNs());
+
+    // Frame every whole packet in place, the leftovers are moved down once at the end
+    unsigned int position = 0;
+    while (bytesInBuffer - position >= InertialLabs::NUM_HEADER_BYTES)
+    {
+        const uint8_t* frame = &inBuffer[position];
+
+        // look for the header bytes, skip straight to the next candidate on a miss
+        if (frame[0] != InertialLabs::HEADER_1 || frame[1] != InertialLabs::HEADER_2)
+        {
+            const void* next = std::memchr(frame + 1, InertialLabs::HEADER_1, bytesInBuffer - position - 1);
+            position = (next != nullptr) ? static_cast<unsigned int>(static_cast<const uint8_t*>(next) - inBuffer) : bytesInBuffer;
+            continue;
+        }
+
+        // do we have the whole header?
+        if (bytesInBuffer - position < sizeof(InertialLabs::Header))
+        {
+            break;
+        }
+
+        // length counts everything after the header bytes, checksum included
+        const InertialLabs::Header* header = reinterpret_cast<const InertialLabs::Header*>(frame);
+        const unsigned int frameLength = InertialLabs::NUM_HEADER_BYTES + header->length;
+
+        // a length that can never fit the buffer is a false header, step past it and keep searching
+        if (frameLength < sizeof(InertialLabs::Header) + InertialLabs::CHECKSUM_LENGTH || frameLength > bufferSize)
+        {
+            m_data.checksumFailCount++;
+            position += 1;
+            continue;
+        }
+
+        // do we have the whole packet? if not, collect more data
+        if (bytesInBuffer - position < frameLength)
+        {
+            break;
+        }
+
+        // checksum is the 16-bit sum of every byte between the header and the checksum
+        uint16_t expectedChecksum = 0;
+        std::memcpy(&expectedChecksum, frame + frameLength - InertialLabs::CHECKSUM_LENGTH, sizeof(expectedChecksum));
+        if (ByteSum16(frame + InertialLabs::NUM_HEADER_BYTES, frameLength - InertialLabs::NUM_HEADER_BYTES - InertialLabs::CHECKSUM_LENGTH) != expectedChecksum)
+        {
+            m_data.checksumFailCount++;
+            position += 1;
+            continue;
+        }
+
+        if (HandlePacket(frame, m_rxTimeline.StampFor(position, frameLength)))
+        {
+            newSample = true;
+        }
+
+        position += frameLength;
+    }
+
+    // Move any partial packet to the front of the buffer
+    if (position > 0)
+    {
+        std::memmove(&inBuffer[0], &inBuffer[position], bytesInBuffer - position);
+        bytesInBuffer -= position;
+        m_rxTimeline.Consume(position);
+    }
+
+    // Consumers see the newest sample, the whole batch is decoded before publishing
+    if (newSample)
+    {
+        UpdateCommonData();
+    }
+
+    return bytesRead;
+}
+
+int InertialLabsImu::SendCommand(const InertialLabs::MSG_ID command)
+{
+    InertialLabs::Command msg = {};
+    msg.header.header1 = InertialLabs::HEADER_1;
+    msg.header.header2 = InertialLabs::HEADER_2;
+    msg.header.messageType = static_cast<uint8_t>(InertialLabs::MSG_TYPE::COMMAND);
+    msg.header.messageId = 0;
+    msg.header.length = sizeof(msg) - InertialLabs::NUM_HEADER_BYTES;
+    msg.command = static_cast<uint8_t>(command);
+    msg.checksum = ByteSum16(reinterpret_cast<const uint8_t*>(&msg) + InertialLabs::NUM_HEADER_BYTES,
+        sizeof(msg) - InertialLabs::NUM_HEADER_BYTES - InertialLabs::CHECKSUM_LENGTH);
+
+    if (m_comms.Write(reinterpret_cast<const std::byte*>(&msg), sizeof(msg)) < 0)
+    {
+        m_txErrorCount++;
+        return -1;
+    }
+
+    m_txCount++;
+    return 0;
+}
+
+bool InertialLabsImu::HandlePacket(const uint8_t* frame, const RxStamp& stamp)
+{
+    const InertialLabs::Header* header = reinterpret_cast<const InertialLabs::Header*>(frame);
+    const uint8_t* payload = frame + sizeof(InertialLabs::Header);
+    const size_t payloadLength = header->length - (sizeof(InertialLabs::Header) - InertialLabs::NUM_HEADER_BYTES) - InertialLabs::CHECKSUM_LENGTH;
+
+    if (header->messageType != static_cast<uint8_t>(InertialLabs::MSG_TYPE::DATA))
+    {
+        m_data.unhandledRxCount++;
+        return false;
+    }
+
+    // Fixed point to SI once per packet, the scale products fold to constants
+    InertialLabsSample& sample = m_data.sample;
+
+    switch (static_cast<InertialLabs::MSG_ID>(header->messageId))
+    {
+    case InertialLabs::MSG_ID::OPVT:
+    {
+        if (payloadLength < sizeof(InertialLabs::Opvt))
+        {
+            m_data.unhandledRxCount++;
+            return false;
+        }
+
+        const InertialLabs::Opvt* packet = reinterpret_cast<const InertialLabs::Opvt*>(payload);
+        m_data.opvtRxCount++;
+
+        constexpr double ANGLE = DEG_TO_RAD / InertialLabs::ANGLE_SCALE;
+        constexpr double GYRO = DEG_TO_RAD / InertialLabs::OPVT_GYRO_SCALE;
+        constexpr double ACCEL = InertialLabs::GRAVITY / InertialLabs::OPVT_ACCEL_SCALE;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            sample.gyro[axis] = packet->gyro[axis] * GYRO;
+            sample.accel[axis] = packet->accel[axis] * ACCEL;
+            sample.mag[axis] = packet->mag[axis] / InertialLabs::MAG_SCALE;
+        }
+        sample.unitStatus = packet->unitStatus;
+        sample.inputVoltage = packet->inputVoltage / InertialLabs::VOLTAGE_SCALE;
+        sample.temperature = packet->temperature / InertialLabs::TEMPERATURE_SCALE;
+
+        m_data.roll = packet->roll * ANGLE;
+        m_data.pitch = packet->pitch * ANGLE;
+        m_data.yaw = packet->heading * ANGLE;
+        m_data.latitude = packet->latitude / InertialLabs::POSITION_SCALE;
+        m_data.longitude = packet->longitude / InertialLabs::POSITION_SCALE;
+        m_data.altitude = packet->altitude / InertialLabs::ALTITUDE_SCALE;
+        m_data.orientationValid = true;
+        break;
+    }
+    case InertialLabs::MSG_ID::SENSORS_DATA:
+    {
+        if (payloadLength < sizeof(InertialLabs::SensorsData))
+        {
+            m_data.unhandledRxCount++;
+            return false;
+        }
+
+        const InertialLabs::SensorsData* packet = reinterpret_cast<const InertialLabs::SensorsData*>(payload);
+        m_data.sensorsRxCount++;
+
+        constexpr double GYRO = DEG_TO_RAD / InertialLabs::SENSORS_GYRO_SCALE;
+        constexpr double ACCEL = InertialLabs::GRAVITY / InertialLabs::SENSORS_ACCEL_SCALE;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            sample.gyro[axis] = packet->gyro[axis] * GYRO;
+            sample.accel[axis] = packet->accel[axis] * ACCEL;
+            sample.mag[axis] = packet->mag[axis] / InertialLabs::MAG_SCALE;
+        }
+        sample.unitStatus = packet->unitStatus;
+        sample.inputVoltage = packet->inputVoltage / InertialLabs::VOLTAGE_SCALE;
+        sample.temperature = packet->temperature / InertialLabs::TEMPERATURE_SCALE;
+        break;
+    }
+    default:
+        m_data.unhandledRxCount++;
+        return false;
+    }
+
+    sample.rxTimeNs = stamp.lastByteNs;
+    m_data.error = sample.unitStatus != 0;
+    m_sampleCount++;
+    UpdateSampleInterval(stamp.lastByteNs);
+
+    // every sample is queued, consumers slower than the unit integrate them later
+    ImuSample queued = {};
+    queued.timestampNs = SampleTime(stamp.lastByteNs);
+    queued.intervalSec = (m_lastSampleNs != 0) ? (queued.timestampNs - m_lastSampleNs) / 1.0e9 :
+        1.0 / InertialLabs::NOMINAL_OUTPUT_RATE_HZ;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        queued.gyro[axis] = sample.gyro[axis];
+        queued.accel[axis] = sample.accel[axis];
+    }
+    m_lastSampleNs = queued.timestampNs;
+    PublishSample(queued);
+
+    return true;
+}
+
+int64_t InertialLabsImu::SampleTime(const int64_t rxTimeNs) const
 {
-    return -1;
+    // a read returns a burst of samples with one time, space them at the measured interval, or
+    // the nominal output period until one is measured, so no two samples share a time
+    constexpr int64_t NOMINAL_INTERVAL_NS = 1000000000LL / InertialLabs::NOMINAL_OUTPUT_RATE_HZ;
+    const int64_t intervalNs = m_sampleIntervalSec > 0 ? static_cast<int64_t>(m_sampleIntervalSec * 1.0e9) : NOMINAL_INTERVAL_NS;
+    if (m_lastSampleNs == 0) return rxTimeNs;
+
+    // well behind the read, samples were lost, start over from the read time
+    constexpr int MAX_SAMPLES_BEHIND = 4;
+    const int64_t spaced = m_lastSampleNs + intervalNs;
+    if (rxTimeNs - spaced > MAX_SAMPLES_BEHIND * intervalNs) return rxTimeNs;
+
+    // a burst runs ahead of its read time, past a few samples close back in at a shorter spacing
+    // rather than step back in time
+    constexpr int MAX_SAMPLES_AHEAD = 8;
+    if (spaced - rxTimeNs > MAX_SAMPLES_AHEAD * intervalNs) return m_lastSampleNs + intervalNs / 4;
+
+    return spaced;
 }
 
-void InertialLabs::UpdateCommonData()
+void InertialLabsImu::UpdateSampleInterval(const int64_t nowNs)
 {
-    m_commonData.pitch = m_data.pitch;
-    m_commonData.yaw = m_data.yaw;
+    if (m_intervalWindowStartNs == 0)
+    {
+        m_intervalWindowStartNs = nowNs;
+        m_intervalWindowCount = 0;
+        return;
+    }
+
+    m_intervalWindowCount++;
+
+    // reads arrive in bursts, only a long window gives a steady interval
+    constexpr int64_t WINDOW_NS = 1000000000;
+    const int64_t elapsedNs = nowNs - m_intervalWindowStartNs;
+    if (elapsedNs < WINDOW_NS) return;
+
+    m_sampleIntervalSec = (elapsedNs / 1.0e9) / m_intervalWindowCount;
+    m_intervalWindowStartNs = nowNs;
+    m_intervalWindowCount = 0;
+}
+
+void InertialLabsImu::UpdateCommonData()
+{
+    const InertialLabsSample& sample = m_data.sample;
+
+    std::scoped_lock lock(m_commonDataMutex);
+
+    if (m_data.orientationValid)
+    {
+        m_commonData.roll = m_data.roll;
+        m_commonData.pitch = m_data.pitch;
+        m_commonData.yaw = m_data.yaw;
+    }
+
+    m_commonData.gyroX = sample.gyro[0];
+    m_commonData.gyroY = sample.gyro[1];
+    m_commonData.gyroZ = sample.gyro[2];
+    m_commonData.accelX = sample.accel[0];
+    m_commonData.accelY = sample.accel[1];
+    m_commonData.accelZ = sample.accel[2];
+    m_commonData.temperature = sample.temperature;
+
+    // rotation over one sample about each body axis
+    m_commonData.rollDelta = sample.gyro[0] * m_sampleIntervalSec;
+    m_commonData.pitchDelta = sample.gyro[1] * m_sampleIntervalSec;
+    m_commonData.yawDelta = sample.gyro[2] * m_sampleIntervalSec;
+
+    m_commonData.timestampNs = sample.rxTimeNs;
+    m_commonData.sampleIntervalSec = m_sampleIntervalSec;
+    m_commonData.sampleCount = m_sampleCount;
+    m_commonData.droppedSampleCount = m_samplesDropped;
     m_commonData.hardwareError = m_data.error;
-}
\ No newline at end of file
+    m_commonData.rxCount = m_data.opvtRxCount + m_data.sensorsRxCount + m_data.unhandledRxCount;
+    m_commonData.rxErrorCount = m_data.checksumFailCount;
+}
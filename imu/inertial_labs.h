@@ -13,31 +13,57 @@
 #include <string>                           // strings
 //
 #include "imu_type.h"                       // base class
-// 
+#include "inertial_labs_info.h"             // inertial labs info
+#include "../utilities/aligned_buffer.h"    // framer buffer
+//
 /////////////////////////////////////////////////////////////////////////////////
 
-/// @brief 
+/// @brief One decoded sample, already in SI units
+struct InertialLabsSample
+{
+    double      gyro[3]             = {};       // rad/s
+    double      accel[3]            = {};       // m/s^2
+    double      mag[3]              = {};       // nT
+    double      temperature         = 0.0;      // C
+    double      inputVoltage        = 0.0;      // V
+    uint16_t    unitStatus          = 0;        // unit status word
+    int64_t     rxTimeNs            = 0;        // monotonic time the last byte was read
+};
+
+/// @brief
 struct InertialLabsData
 {
-    double roll; 
-    double pitch;
-    double yaw;
-    bool error;
+    InertialLabsSample  sample              = {};       // most recent sample
+    double              roll                = 0.0;      // rad, OPVT only
+    double              pitch               = 0.0;      // rad, OPVT only
+    double              yaw                 = 0.0;      // rad, OPVT only
+    double              latitude            = 0.0;      // deg, OPVT only
+    double              longitude           = 0.0;      // deg, OPVT only
+    double              altitude            = 0.0;      // m, OPVT only
+    bool                orientationValid    = false;    // an OPVT packet has been decoded
+    bool                error               = false;    // unit status word reports a fault
+
+    unsigned long       opvtRxCount         = 0;
+    unsigned long       sensorsRxCount      = 0;
+    unsigned long       unhandledRxCount    = 0;        // valid packets this driver does not decode
+    unsigned long       checksumFailCount   = 0;
 };
 
-/// @brief 
-class InertialLabs : public ImuType
+/// @brief Driver for Inertial Labs Kernel units using the binary OPVT or sensors data output
+class InertialLabsImu : public ImuType
 {
 public:
 
-    /// @brief 
-    InertialLabs(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate) : 
-        ImuType("ILABS", logger, path, baudrate) {}
+    /// @brief
+    /// @param outputFormat - [in/opt] - continuous output started on the unit
+    /// @param bufferSize - [in/opt] - Size of the framer buffer
+    InertialLabsImu(LogClient& logger, const std::string path, const SerialClient::BaudRate baudrate,
+        const InertialLabs::MSG_ID outputFormat = InertialLabs::MSG_ID::OPVT, const size_t bufferSize = InertialLabs::FRAME_BUFFER_SIZE);
+
+    /// @brief Stops the continuous output
+    ~InertialLabsImu();
 
-    /// @brief 
-    ~InertialLabs() {}
-    
-    /// @brief 
+    /// @brief Read what is on the port and decode every whole packet in the buffer
     /// @return -1 on error, else number of bytes read and processed
     int ProcessData() override;
 
@@ -45,8 +71,40 @@ protected:
 
 private:
 
-    /// @brief 
+    /// @brief Send a start or stop output command
+    /// @param command - [in] - MSG_ID to start, or STOP
+    /// @return 0 if successful, -1 on error
+    int SendCommand(const InertialLabs::MSG_ID command);
+
+    /// @brief Decode one whole, checksum checked packet
+    /// @param frame - [in] - start of the packet, the header is at offset 0
+    /// @param stamp - [in] - receive stamp of the packet
+    /// @return true if a sample was decoded, else false
+    bool HandlePacket(const uint8_t* frame, const RxStamp& stamp);
+
+    /// @brief Time of a sample read in a burst
+    /// @param rxTimeNs - [in] - monotonic time the sample's last byte was read
+    /// @return monotonic time assigned to the sample
+    int64_t SampleTime(const int64_t rxTimeNs) const;
+
+    /// @brief Measure the sample interval once a second
+    /// @param nowNs - [in] - monotonic time of the latest sample
+    void UpdateSampleInterval(const int64_t nowNs);
+
+    /// @brief
     void UpdateCommonData() override;
 
-    InertialLabsData m_data = {};       /// Data storage
-};
\ No newline at end of file
+    InertialLabsData    m_data              = {};       /// Data storage
+    InertialLabs::MSG_ID m_outputFormat     = InertialLabs::MSG_ID::OPVT;   /// Output started on the unit
+    double              m_sampleIntervalSec = 0.0;      /// Measured time between samples
+    long                m_sampleCount       = 0;        /// Samples decoded
+    int64_t             m_lastSampleNs      = 0;        /// Time assigned to the last queued sample
+
+    // Framer state, aligned so parallel parsers never share a cache line
+    alignas(CACHE_LINE_SIZE) AlignedBuffer m_inBuffer;  /// Bytes read and not yet framed
+    unsigned int        m_bytesInBuffer     = 0;        /// Bytes held in m_inBuffer
+    bool                m_firstRead         = true;     /// Flush what was queued before the first read
+
+    int64_t             m_intervalWindowStartNs = 0;    /// Start of the sample interval window
+    long                m_intervalWindowCount   = 0;    /// Samples in the window
+};
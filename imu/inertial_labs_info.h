@@ -0,0 +1,123 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            inertial_labs_info.h
+// @brief           Definitions and structures for Inertial Labs modules
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstdint>                          // std ints
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace InertialLabs
+{
+    /// @brief Header bytes of every binary packet
+    constexpr uint8_t HEADER_1 = 0xAA;
+    constexpr uint8_t HEADER_2 = 0x55;
+
+    /// @brief Number of header bytes
+    constexpr int NUM_HEADER_BYTES = 2;
+
+    /// @brief Number of checksum bytes
+    constexpr int CHECKSUM_LENGTH = 2;
+
+    /// @brief Default size of the framer buffer, a few ms of packets at 2kHz
+    constexpr int FRAME_BUFFER_SIZE = 4096;
+
+    /// @brief Smallest framer buffer accepted
+    constexpr int MIN_FRAME_BUFFER_SIZE = 512;
+
+    /// @brief Continuous output rate of a unit at its factory settings, spaces samples until the
+    /// rate has been measured
+    constexpr int NOMINAL_OUTPUT_RATE_HZ = 200;
+
+    /// @brief Packet types
+    enum class MSG_TYPE : uint8_t
+    {
+        COMMAND     = 0x00,
+        DATA        = 0x01,
+    };
+
+    /// @brief Output data formats, a command with the same id starts continuous output
+    enum class MSG_ID : uint8_t
+    {
+        SENSORS_DATA    = 0x50,     // calibrated sensors, high resolution
+        OPVT            = 0x52,     // orientation, position, velocity and time
+        STOP            = 0xFE,     // stop continuous output
+    };
+
+    /// @brief Scale factors of the fixed point fields
+    constexpr double ANGLE_SCALE            = 100.0;        // deg * 100
+    constexpr double OPVT_GYRO_SCALE        = 50.0;         // KG, deg/s * 50
+    constexpr double OPVT_ACCEL_SCALE       = 4000.0;       // KA, g * 4000
+    constexpr double SENSORS_GYRO_SCALE     = 1.0e5;        // deg/s * 1e5
+    constexpr double SENSORS_ACCEL_SCALE    = 1.0e6;        // g * 1e6
+    constexpr double MAG_SCALE              = 0.1;          // nT / 10
+    constexpr double VOLTAGE_SCALE          = 100.0;        // V * 100
+    constexpr double TEMPERATURE_SCALE      = 10.0;         // C * 10
+    constexpr double POSITION_SCALE         = 1.0e7;        // deg * 1e7
+    constexpr double ALTITUDE_SCALE         = 100.0;        // m * 100
+    constexpr double VELOCITY_SCALE         = 100.0;        // m/s * 100
+    constexpr double GRAVITY                = 9.80665;      // m/s^2 per g
+
+#pragma pack(push, 1)
+
+    /// @brief Packet header
+    struct Header                       //  offset      description
+    {                                   //  -------     ------------
+        uint8_t     header1;            //  0           = 0xAA
+        uint8_t     header2;            //  1           = 0x55
+        uint8_t     messageType;        //  2           MSG_TYPE
+        uint8_t     messageId;          //  3           MSG_ID
+        uint16_t    length;             //  4-5         bytes after the header, checksum included
+    };
+
+    /// @brief Command to start or stop continuous output
+    struct Command                      //  offset      description
+    {                                   //  -------     ------------
+        Header      header;             //  0-5         type COMMAND, id 0, length 7
+        uint8_t     command;            //  6           MSG_ID to start, or STOP
+        uint16_t    checksum;           //  7-8         16-bit sum of bytes 2-6
+    };
+
+    /// @brief OPVT payload, only the leading fields are decoded
+    struct Opvt                         //  offset      units       scale       description
+    {                                   //  -------     -------     -------     ------------
+        uint16_t    heading;            //  0-1         deg         100         heading, 0-360
+        int16_t     pitch;              //  2-3         deg         100         pitch
+        int16_t     roll;               //  4-5         deg         100         roll
+        int16_t     gyro[3];            //  6-11        deg/s       KG          body rates x, y, z
+        int16_t     accel[3];           //  12-17       g           KA          accelerations x, y, z
+        int16_t     mag[3];             //  18-23       nT          0.1         magnetic field x, y, z
+        uint16_t    unitStatus;         //  24-25       n/a         n/a         unit status word
+        uint16_t    inputVoltage;       //  26-27       V           100         supply voltage
+        int16_t     temperature;        //  28-29       C           10          internal temperature
+        int32_t     latitude;           //  30-33       deg         1e7         latitude
+        int32_t     longitude;          //  34-37       deg         1e7         longitude
+        int32_t     altitude;           //  38-41       m           100         altitude
+        int32_t     eastVelocity;       //  42-45       m/s         100         east velocity
+        int32_t     northVelocity;      //  46-49       m/s         100         north velocity
+        int32_t     upVelocity;         //  50-53       m/s         100         vertical velocity
+    };
+
+    /// @brief Sensors data payload
+    struct SensorsData                  //  offset      units       scale       description
+    {                                   //  -------     -------     -------     ------------
+        int32_t     gyro[3];            //  0-11        deg/s       1e5         body rates x, y, z
+        int32_t     accel[3];           //  12-23       g           1e6         accelerations x, y, z
+        int16_t     mag[3];             //  24-29       nT          0.1         magnetic field x, y, z
+        uint16_t    unitStatus;         //  30-31       n/a         n/a         unit status word
+        uint16_t    inputVoltage;       //  32-33       V           100         supply voltage
+        int16_t     temperature;        //  34-35       C           10          internal temperature
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(Header) == 6, "Inertial Labs header must be 6 bytes");
+    static_assert(sizeof(Command) == 9, "Inertial Labs command must be 9 bytes");
+}
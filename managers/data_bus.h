@@ -0,0 +1,34 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            data_bus.h
+// @brief           Topics the managers publish and consumers subscribe to
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include "../utilities/topic.h"             // topics
+#include "../gps/gps_type.h"                // gps topic
+#include "../imu/imu_type.h"                // imu topic
+#include "../navigation/nav_filter.h"       // navigation topic
+#include "../utilities/gpio_interface.h"    // discrete topic
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Every topic in the program. Each topic has one publisher:
+///     gps         - GpsManager::Read(), the selected solution on each new epoch
+///     imu         - the IMU acquisition thread, or CheckForData() without one, every new sample
+///     navigation  - the main loop, every filter propagation or update
+///     discretes   - the actuator loop, every edge on a discrete input line
+/// A consumer adds a Subscriber to the topics it needs, with latest value or queued delivery,
+/// and the publishers are unchanged. Too large for the stack.
+struct DataBus
+{
+    GpsTopic            gps;
+    ImuTopic            imu;
+    NavigationTopic     navigation;
+    DiscreteTopic       discretes;
+};
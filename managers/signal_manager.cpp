@@ -1,4 +1,3 @@
-
 /////////////////////////////////////////////////////////////////////////////////
 // @file            signal_manager.cpp
 // @brief           Implementation for signal manager
@@ -11,12 +10,17 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include <string>                           // strings
+#include <thread>                           // sleep until
+#include <chrono>                           // tick schedule
+#include <cstdio>                           // snprintf
+#include <cmath>                            // fabs
+#include <algorithm>                        // clamp, max
 //
 #include "signal_manager.h"                 // header
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
-SignalManager::SignalManager(LogClient& logger) : mFin1(""), mFin2(""), mFin3(""), mFin4(""), m_logger(logger)
+SignalManager::SignalManager(LogClient& logger) : m_logger(logger)
 {}
 
 SignalManager::SignalManager(const std::string fin1Path, const int fin1Channel,
@@ -36,20 +40,111 @@ SignalManager::SignalManager(const std::string fin1Path, const int fin1Channel,
 SignalManager::~SignalManager()
 {
     // Unexport the PWMs
-    if (mFin1.UnExportPWM() == PWM::PWMStatus::Error) m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin1 failed to Unexport.");
-    if (mFin2.UnExportPWM() == PWM::PWMStatus::Error) m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin2 failed to Unexport.");
-    if (mFin3.UnExportPWM() == PWM::PWMStatus::Error) m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin3 failed to Unexport.");
-    if (mFin4.UnExportPWM() == PWM::PWMStatus::Error) m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin4 failed to Unexport.");
+    for (size_t i = 0; i < NUM_FINS; i++)
+    {
+        if (mFins[i].UnExportPWM() == PWM::PWMStatus::Error)
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin" + std::to_string(i + 1) + " failed to Unexport.");
+        }
+    }
 }
 
 void SignalManager::Start()
 {
+    using Clock = std::chrono::steady_clock;
+
     mRun = true;
 
+    const Clock::duration period = std::chrono::nanoseconds(1000000000LL / m_rateHz);
+    const double periodSec = 1.0 / m_rateHz;
+
+    Clock::time_point nextTick = Clock::now() + period;
     while (mRun)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        const Clock::time_point scheduled = nextTick;
+        std::this_thread::sleep_until(scheduled);
+        const int64_t lateNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - scheduled).count();
+
+        Tick(periodSec);
+
+        // Keep the schedule, ticks the loop overran are dropped rather than run back to back
+        uint64_t missed = 0;
+        nextTick += period;
+        while (nextTick <= Clock::now())
+        {
+            nextTick += period;
+            missed++;
+        }
+
+        std::scoped_lock lock(m_statsMutex);
+        m_stats.tickLateness.Record(lateNs);
+        m_stats.missedTicks += missed;
     }
+
+    ActuatorStats stats = GetActuatorStats();
+    char summary[256];
+    std::snprintf(summary, sizeof(summary), "Actuator loop wrote %llu frames, max skew %.1f us, mean skew %.1f us, %llu writes, %llu skipped, %llu commands coalesced, %llu missed ticks, %llu write errors.",
+        static_cast<unsigned long long>(stats.frames), stats.frameSkew.MaxNs() / 1.0e3, stats.frameSkew.MeanNs() / 1.0e3,
+        static_cast<unsigned long long>(stats.writes), static_cast<unsigned long long>(stats.writesSkipped),
+        static_cast<unsigned long long>(stats.commandsCoalesced), static_cast<unsigned long long>(stats.missedTicks),
+        static_cast<unsigned long long>(stats.writeErrors));
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, summary);
+
+    SaveTrace();
+}
+
+bool SignalManager::Replay(const std::string& referencePath)
+{
+    if (mRun || m_trace == nullptr)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin replay needs the simulated backend and a stopped actuator loop.");
+        return false;
+    }
+
+    PwmTrace reference(0, 0);
+    if (!reference.Load(referencePath))
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin reference trace failed to load from " + referencePath + ".");
+        return false;
+    }
+
+    const std::vector<PwmTrace::Command> commands = reference.GetCommands();
+    if (commands.empty())
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin reference trace " + referencePath + " has no command frames.");
+        return false;
+    }
+
+    // Ticks run back to back instead of on the clock. Each frame is latched for the tick the
+    // recorded loop took it on, so slew and deadband step the fins exactly as they did.
+    const double periodSec = 1.0 / m_rateHz;
+    const uint64_t firstTick = m_ticks;
+    for (const PwmTrace::Command& command : commands)
+    {
+        while (m_ticks - firstTick < command.tick) Tick(periodSec);
+
+        CommandFins(command.values);
+        Tick(periodSec);
+    }
+
+    // The recorded loop kept running while its fins settled, so does the replay
+    const uint64_t maxSettleTicks = static_cast<uint64_t>(m_rateHz) * MAX_SETTLE_SEC;
+    for (uint64_t i = 0; i < maxSettleTicks && !Settled(); i++) Tick(periodSec);
+
+    SaveTrace();
+
+    // Times differ run to run, only the order and values of the writes are compared
+    const long index = m_trace->Compare(reference);
+    if (index < 0)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Replayed " + std::to_string(commands.size()) +
+            " fin commands, the writes match the reference trace " + referencePath + ".");
+        return true;
+    }
+
+    m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Replayed " + std::to_string(commands.size()) +
+        " fin commands, the writes differ from the reference trace " + referencePath + " at write " + std::to_string(index) + ".");
+    return false;
 }
 
 void SignalManager::Stop()
@@ -62,104 +157,317 @@ void SignalManager::Stop()
     m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Closing.");
 }
 
+bool SignalManager::SetRate(const int rateHz)
+{
+    if (mRun || rateHz <= 0 || rateHz > 10000) return false;
+
+    m_rateHz = rateHz;
+    return true;
+}
+
+void SignalManager::SetLimits(const double slewRateDegPerSec, const double deadbandDegrees)
+{
+    if (mRun)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Limits must be set before the actuator loop starts.");
+        return;
+    }
+
+    m_slewRate = std::max(slewRateDegPerSec, 0.0);
+    m_deadband = std::max(deadbandDegrees, 0.0);
+}
+
+bool SignalManager::SetBackend(const PwmBackendType type, const std::string& tracePath)
+{
+    if (mRun) return false;
+
+    m_backend = type;
+    m_trace = type == PwmBackendType::Simulated ? std::make_shared<PwmTrace>() : nullptr;
+    m_tracePath = type == PwmBackendType::Simulated ? tracePath : "";
+
+    if (type == PwmBackendType::Simulated)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Fins are simulated, no PWM output.");
+    }
+    return true;
+}
+
+bool SignalManager::SetCalibration(const FIN fin, const PwmCalibration::Curve& curve, const double trimDegrees)
+{
+    const size_t index = static_cast<size_t>(fin);
+    if (mRun || index >= NUM_FINS) return false;
+
+    const std::string name = "Fin" + std::to_string(index + 1);
+    if (!mFins[index].SetCalibration(curve.empty() ? PwmCalibration::LinearCurve() : curve, trimDegrees))
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, name + " calibration is invalid, keeping the previous one.");
+        return false;
+    }
+
+    const PwmCalibration& calibration = mFins[index].GetCalibration();
+    char range[128];
+    std::snprintf(range, sizeof(range), " calibrated, %.0f to %.0f us over %.1f to %.1f deg, trim %.2f deg.",
+        calibration.PulseUs(calibration.GetMinDegrees() - trimDegrees), calibration.PulseUs(calibration.GetMaxDegrees() - trimDegrees),
+        calibration.GetMinDegrees(), calibration.GetMaxDegrees(), trimDegrees);
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, name + range);
+    return true;
+}
+
+bool SignalManager::ReadyDiscretes(const std::string& chipPath, const std::vector<GPIO::LineConfig>& lines)
+{
+    if (mRun) return false;
+
+    GPIO::GPIOStatus status = m_discretes.RequestLines(chipPath, lines);
+    if (status == GPIO::GPIOStatus::InvalidInput)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Discrete lines cannot be requested together.");
+        return false;
+    }
+    else if (status != GPIO::GPIOStatus::Success)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Discrete lines failed to request on " + chipPath + ".");
+        return false;
+    }
+
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, std::to_string(lines.size()) + " discrete lines ready on " + chipPath + ".");
+    return true;
+}
+
+void SignalManager::CommandDiscretes(const uint64_t values, const uint64_t mask)
+{
+    std::scoped_lock lock(m_discreteMutex);
+    m_discreteValues = (m_discreteValues & ~mask) | (values & mask);
+    m_discretePending |= mask;
+}
+
+bool SignalManager::ReadDiscretes(uint64_t& values)
+{
+    return m_discretes.GetValues(values) == GPIO::GPIOStatus::Success;
+}
+
 bool SignalManager::ReadyFin(const FIN fin, const std::string finPath, const int finChannel,
     const double finMinDegrees, const double finMaxDegrees)
 {
-    // Holder for status return
-    PWM::PWMStatus status = PWM::PWMStatus::InvalidInput;
+    const size_t index = static_cast<size_t>(fin);
+    if (index >= NUM_FINS) return false;
+
+    const std::string name = "Fin" + std::to_string(index + 1);
+    PWM& pwm = mFins[index];
+
+    if (m_backend == PwmBackendType::Simulated) pwm.SetBackend(std::make_unique<SimulatedPwmBackend>(m_trace, static_cast<int>(index)));
+    else pwm.SetBackend(std::make_unique<SysfsPwmBackend>());
 
-    switch (fin)
+    pwm.SetPath(finPath);
+    pwm.SetChannel(finChannel);
+    pwm.UpdateDegreeClamp(finMinDegrees, finMaxDegrees);
+
+    if (pwm.ExportPWM() == PWM::PWMStatus::Error)
     {
-    case FIN::ONE:
-        mFin1.SetPath(finPath);
-        mFin1.SetChannel(finChannel);
-        mFin1.UpdateDegreeClamp(finMinDegrees, finMaxDegrees);
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, name + " failed to export.");
+        return false;
+    }
 
-        if (mFin1.ExportPWM() == PWM::PWMStatus::Error)
-        {
-            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin1 failed to export.");
-            return false;
-        }
+    // Servos expect a 50Hz frame, the duty cycle cannot be set beyond the period
+    if (pwm.SetPeriod(SERVO_PERIOD_NS) != PWM::PWMStatus::Success)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, name + " failed to set the period.");
+        return false;
+    }
 
-        status = mFin1.EnablePWM();
-        if (status == PWM::PWMStatus::Error)            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin1 failed to enable.");
-        else if (status == PWM::PWMStatus::NotExported) m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin1 not exported.");
-        else mFin1Ready = true;
-        
-        return mFin1Ready;
+    PWM::PWMStatus status = pwm.EnablePWM();
+    if (status == PWM::PWMStatus::Error)            m_logger.AddLog(m_name, LogClient::LogLevel::Error, name + " failed to enable.");
+    else if (status == PWM::PWMStatus::NotExported) m_logger.AddLog(m_name, LogClient::LogLevel::Error, name + " not exported.");
+    else mFinReady[index] = true;
 
-    case FIN::TWO:
-        mFin2.SetPath(finPath);
-        mFin2.SetChannel(finChannel);
-        mFin2.UpdateDegreeClamp(finMinDegrees, finMaxDegrees);
+    return mFinReady[index];
+}
 
-        if (mFin2.ExportPWM() == PWM::PWMStatus::Error) 
-        {
-            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin2 failed to export.");
-            return false;
-        }
+void SignalManager::CommandFins(const std::array<double, NUM_FINS>& degrees)
+{
+    m_lastCommand.degrees = degrees;
+    m_lastCommand.timeNs = MonotonicNowNs();
+    m_commands.Publish(m_lastCommand);
+}
+
+void SignalManager::CommandSurfaces(const double roll, const double pitch, const double yaw)
+{
+    std::array<double, NUM_FINS> degrees;
+    for (size_t i = 0; i < NUM_FINS; i++)
+    {
+        degrees[i] = roll * m_mixer[i][0] + pitch * m_mixer[i][1] + yaw * m_mixer[i][2];
+    }
 
-        status = mFin2.EnablePWM();
-        if (status == PWM::PWMStatus::Error)            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin2 failed to enable.");
-        else if (status == PWM::PWMStatus::NotExported) m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin2 not exported.");
-        else mFin2Ready = true;
+    CommandFins(degrees);
+}
 
-        return mFin2Ready;
+bool SignalManager::UpdateFin_Degrees(const FIN fin, const double degrees)
+{
+    const size_t index = static_cast<size_t>(fin);
+    if (index >= NUM_FINS) return false;
 
-    case FIN::THREE:
-        mFin3.SetPath(finPath);
-        mFin3.SetChannel(finChannel);
-        mFin3.UpdateDegreeClamp(finMinDegrees, finMaxDegrees);
+    std::array<double, NUM_FINS> command = m_lastCommand.degrees;
+    command[index] = degrees;
+    CommandFins(command);
 
-        if (mFin3.ExportPWM() == PWM::PWMStatus::Error) 
+    return true;
+}
+
+SignalManager::ActuatorStats SignalManager::GetActuatorStats()
+{
+    std::scoped_lock lock(m_statsMutex);
+    ActuatorStats stats = m_stats;
+    stats.commandsCoalesced = m_commands.Count() - stats.commandsTaken;
+    return stats;
+}
+
+void SignalManager::Tick(const double periodSec)
+{
+    // Only the newest frame matters, any latched before it this tick are coalesced
+    FinCommand command;
+    if (m_latestCommand.Poll(command))
+    {
+        for (size_t i = 0; i < NUM_FINS; i++)
         {
-            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin3 failed to export.");
-            return false;
+            m_targets[i] = mFins[i].ClampDegrees(command.degrees[i]);
         }
 
-        status = mFin3.EnablePWM();
-        if (status == PWM::PWMStatus::Error)            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin3 failed to enable.");
-        else if (status == PWM::PWMStatus::NotExported) m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin3 not exported.");
-        else mFin3Ready = true;
+        // Kept with the tick it was taken on so a replay latches it at the same point
+        if (m_trace != nullptr) m_trace->RecordCommand({ command.timeNs, m_ticks, command.degrees });
 
-        return mFin3Ready;
+        std::scoped_lock lock(m_statsMutex);
+        m_stats.commandLatency.Record(MonotonicNowNs() - command.timeNs);
+        m_stats.commandsTaken++;
+    }
 
-    case FIN::FOUR:
-        mFin4.SetPath(finPath);
-        mFin4.SetChannel(finChannel);
-        mFin4.UpdateDegreeClamp(finMinDegrees, finMaxDegrees);
+    UpdateOutputs(periodSec);
+    UpdateDiscretes();
+    m_ticks++;
+}
 
-        if (mFin4.ExportPWM() == PWM::PWMStatus::Error)
+bool SignalManager::Settled() const
+{
+    for (size_t i = 0; i < NUM_FINS; i++)
+    {
+        if (!mFinReady[i]) continue;
+        if (std::fabs(m_targets[i] - m_outputs[i]) > m_deadband || m_writeFailed[i]) return false;
+    }
+    return true;
+}
+
+void SignalManager::SaveTrace()
+{
+    if (m_trace == nullptr || m_tracePath.empty()) return;
+
+    if (m_trace->Save(m_tracePath)) m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Fin trace saved to " + m_tracePath + ", "
+        + std::to_string(m_trace->GetDropped()) + " entries dropped when full.");
+    else m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin trace failed to save to " + m_tracePath + ".");
+}
+
+void SignalManager::UpdateOutputs(const double periodSec)
+{
+    const double maxStep = m_slewRate > 0 ? m_slewRate * periodSec : 0;
+
+    // Work out every fin first so the writes below go back to back
+    std::array<double, NUM_FINS> outputs = m_outputs;
+    std::array<size_t, NUM_FINS> pulses = m_pulses;
+    for (size_t i = 0; i < NUM_FINS; i++)
+    {
+        if (!mFinReady[i]) continue;
+
+        const double error = m_targets[i] - m_outputs[i];
+        if (std::fabs(error) > m_deadband)
         {
-            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin4 failed to export.");
-            return false;
+            outputs[i] += maxStep > 0 ? std::clamp(error, -maxStep, maxStep) : error;
         }
+        pulses[i] = mFins[i].DegreesToPWM(outputs[i]);
+    }
 
-        status = mFin4.EnablePWM();
-        if (status == PWM::PWMStatus::Error)            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin4 failed to enable.");
-        else if (status == PWM::PWMStatus::NotExported) m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Fin4 not exported.");
-        else mFin4Ready = true;
+    uint64_t writes = 0;
+    uint64_t skipped = 0;
+    uint64_t errors = 0;
+    int64_t start = 0;
+    int64_t end = 0;
+    for (size_t i = 0; i < NUM_FINS; i++)
+    {
+        if (!mFinReady[i]) continue;
 
-        return mFin4Ready;
+        // Same pulse as the hardware already has, the write would change nothing. A fin never
+        // written, or whose last write failed, is written regardless
+        if (pulses[i] == m_pulses[i] && m_pulses[i] != 0 && !m_writeFailed[i])
+        {
+            m_outputs[i] = outputs[i];
+            skipped++;
+            continue;
+        }
 
-    default:
-        return false;
+        if (writes == 0) start = MonotonicNowNs();
+        if (mFins[i].SetDutyCycle(static_cast<int>(pulses[i]) * 1000) == PWM::PWMStatus::Success)
+        {
+            m_outputs[i] = outputs[i];
+            m_pulses[i] = pulses[i];
+            m_writeFailed[i] = false;
+        }
+        else
+        {
+            // Held at the last good output so the next tick tries again
+            m_writeFailed[i] = true;
+            errors++;
+        }
+        writes++;
+        end = MonotonicNowNs();
+    }
+
+    std::scoped_lock lock(m_statsMutex);
+    m_stats.writes += writes;
+    m_stats.writesSkipped += skipped;
+    m_stats.writeErrors += errors;
+    if (writes > 0)
+    {
+        m_stats.frameSkew.Record(end - start);
+        m_stats.frames++;
     }
 }
 
-bool SignalManager::UpdateFin_Degrees(const FIN fin, const double degrees)
+void SignalManager::UpdateDiscretes()
 {
-    switch (fin)
+    if (!m_discretes.IsRequested()) return;
+
+    uint64_t values = 0;
+    uint64_t mask = 0;
     {
-    case FIN::ONE:
-        break;
-    case FIN::TWO:
-        break;
-    case FIN::THREE:
-        break;
-    case FIN::FOUR:
-        break;
+        std::scoped_lock lock(m_discreteMutex);
+        values = m_discreteValues;
+        mask = m_discretePending;
+        m_discretePending = 0;
     }
 
-    return true;
-}
\ No newline at end of file
+    uint64_t writes = 0;
+    uint64_t errors = 0;
+    if (mask != 0)
+    {
+        if (m_discretes.SetValues(values, mask) == GPIO::GPIOStatus::Success) writes++;
+        else errors++;
+    }
+
+    // Edges carry the kernel's timestamp, taking them on the tick does not blur their timing
+    std::array<GPIO::Event, 16> events;
+    uint64_t taken = 0;
+    int count = 0;
+    while ((count = m_discretes.ReadEvents(events.data(), events.size())) > 0)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (m_discreteTopic != nullptr) m_discreteTopic->Publish(events[i]);
+        }
+        taken += count;
+        if (count < static_cast<int>(events.size())) break;
+    }
+    if (count < 0) errors++;
+
+    if (writes == 0 && taken == 0 && errors == 0) return;
+
+    std::scoped_lock lock(m_statsMutex);
+    m_stats.discreteWrites += writes;
+    m_stats.discreteEvents += taken;
+    m_stats.discreteErrors += errors;
+}
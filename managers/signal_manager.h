@@ -11,9 +11,17 @@
 //          name                            reason included
 //          ------------------              ------------------------
 #include <string>                           // strings
+#include <array>                            // fins
+#include <atomic>                           // run flag
+#include <mutex>                            // stats safety
+#include <memory>                           // trace
+#include <cstdint>                          // standard ints
 //
 #include "../utilities/pwm_interface.h"        // pwms
+#include "../utilities/gpio_interface.h"       // discretes
 #include "../utilities/log_client.h"           // logger
+#include "../utilities/topic.h"                // command latch
+#include "../utilities/rx_timing.h"            // skew histograms
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -29,6 +37,38 @@ public:
         FOUR
     };
 
+    /// @brief Number of fins
+    static constexpr size_t NUM_FINS = 4;
+    static_assert(NUM_FINS == PwmTrace::COMMAND_CHANNELS, "a traced command frame holds every fin");
+
+    /// @brief A deflection for every fin, written to the PWMs as one frame
+    struct FinCommand
+    {
+        std::array<double, NUM_FINS>    degrees     = {};       // deflection per fin, FIN order
+        int64_t                         timeNs      = 0;        // monotonic time the command was latched
+    };
+
+    /// @brief Mixer gains, fin deflection = roll * gain[0] + pitch * gain[1] + yaw * gain[2]
+    using MixerMatrix = std::array<std::array<double, 3>, NUM_FINS>;
+
+    /// @brief Timing of the actuator loop
+    struct ActuatorStats
+    {
+        LatencyHistogram    frameSkew       = {};       // first fin write starting to the last one finishing
+        LatencyHistogram    commandLatency  = {};       // command latched to the actuator loop picking it up
+        LatencyHistogram    tickLateness    = {};       // wake up past the scheduled tick
+        uint64_t            frames          = 0;        // ticks that wrote at least one fin
+        uint64_t            writes          = 0;        // fin writes issued
+        uint64_t            writesSkipped   = 0;        // fin writes saved, the pulse width had not changed
+        uint64_t            commandsTaken   = 0;        // command frames the loop picked up
+        uint64_t            commandsCoalesced = 0;      // command frames replaced by a newer one before a tick
+        uint64_t            writeErrors     = 0;        // fin writes that failed
+        uint64_t            missedTicks     = 0;        // ticks skipped because the loop overran
+        uint64_t            discreteWrites  = 0;        // discrete output updates, every line in one ioctl
+        uint64_t            discreteEvents  = 0;        // discrete input edges taken
+        uint64_t            discreteErrors  = 0;        // discrete writes or event reads that failed
+    };
+
     /// @brief Default constructor
     SignalManager(LogClient& logger);
 
@@ -53,12 +93,51 @@ public:
     /// @brief Default deconstructor
     ~SignalManager();
 
-    /// @brief BLOCKING - Start an endless main working loop 
+    /// @brief BLOCKING - Start the actuator loop. Every tick the latest command frame is written
+    /// to all four fins back to back, a frame is never split across ticks.
     void Start();
 
-    /// @brief Stop the main working loop
+    /// @brief Stop the actuator loop
     void Stop();
 
+    /// @brief Set the actuator loop rate, before Start()
+    /// @param rateHz - in - frames per second
+    /// @return true if set, false if out of range or running
+    bool SetRate(const int rateHz);
+
+    /// @brief Set the motion limits applied each tick, before Start()
+    /// @param slewRateDegPerSec - in - fastest a fin is driven, 0 for no limit
+    /// @param deadbandDegrees - in - a fin holds while its command is within this of its position
+    void SetLimits(const double slewRateDegPerSec, const double deadbandDegrees);
+
+    /// @brief Set the mixer from roll, pitch and yaw to fin deflections
+    /// @param mixer - in - gains per fin
+    void SetMixer(const MixerMatrix& mixer) { m_mixer = mixer; }
+
+    /// @brief Select the hardware access every fin is readied with, before ReadyFin()
+    /// @param type - in - sysfs for the airframe, simulated to run the actuator loop on any host
+    /// @param tracePath - opt - simulated only, the fin commands and writes are saved here when the actuator loop ends
+    /// @return true if set, false if running
+    bool SetBackend(const PwmBackendType type, const std::string& tracePath = "");
+
+    /// @brief Get the fin writes recorded by the simulated backend, fin index as the id
+    /// @return trace, nullptr unless the backend is simulated
+    std::shared_ptr<PwmTrace> GetTrace() const { return m_trace; }
+
+    /// @brief Replay the command frames of a saved trace through CommandFins, each on the tick it
+    /// was taken, then compare the fin writes to the trace's. Simulated backend only, in place of
+    /// Start() once the fins are readied.
+    /// @param referencePath - in - trace saved by an earlier run
+    /// @return true if the writes match, false if they differ or the replay could not run
+    bool Replay(const std::string& referencePath);
+
+    /// @brief Set a fin's degree to pulse width calibration, before Start()
+    /// @param fin - in - fin to calibrate
+    /// @param curve - in - calibration points as { degrees, pulse width us }, empty for the linear mapping
+    /// @param trimDegrees - in - added to every deflection before the lookup
+    /// @return true if set, false if the curve is invalid or running
+    bool SetCalibration(const FIN fin, const PwmCalibration::Curve& curve, const double trimDegrees);
+
     /// @brief Ready a fin for use
     /// @param fin - The fin number to be readied
     /// @param finPath - The path to the PWM
@@ -69,25 +148,115 @@ public:
     bool ReadyFin(const FIN fin, const std::string finPath, const int finChannel,
         const double finMinDegrees = 0, const double finMaxDegrees = 0);
 
-    /// @brief Update a fins location to a specific degrees
+    /// @brief Request the discrete lines, before Start(). Outputs are written and input edges
+    /// taken each tick of the actuator loop.
+    /// @param chipPath - The path to the gpio chip, typically "/dev/gpiochipX"
+    /// @param lines - Lines to request, bit n of a discrete value is line n
+    /// @return true if every line was requested, otherwise false
+    bool ReadyDiscretes(const std::string& chipPath, const std::vector<GPIO::LineConfig>& lines);
+
+    /// @brief Publish the discrete input edges on a topic, before Start()
+    /// @param topic - in - topic to publish on, nullptr to stop publishing
+    void SetDiscreteTopic(DiscreteTopic* topic) { m_discreteTopic = topic; }
+
+    /// @brief Latch discrete output values, written together on the next tick
+    /// @param values - in - bit per line
+    /// @param mask - in - bit per line to change
+    void CommandDiscretes(const uint64_t values, const uint64_t mask);
+
+    /// @brief Read every discrete line in one ioctl
+    /// @param values - out - bit per line
+    /// @return true if read, otherwise false
+    bool ReadDiscretes(uint64_t& values);
+
+    /// @brief Latch a deflection for every fin, written together on the next tick. One thread
+    /// issues commands.
+    /// @param degrees - in - deflection per fin, FIN order
+    void CommandFins(const std::array<double, NUM_FINS>& degrees);
+
+    /// @brief Mix roll, pitch and yaw into fin deflections and latch them
+    /// @param roll - in - degrees
+    /// @param pitch - in - degrees
+    /// @param yaw - in - degrees
+    void CommandSurfaces(const double roll, const double pitch, const double yaw);
+
+    /// @brief Update a fins location to a specific degrees, the other fins keep their last command
     /// @param fin - The desired fin to be updated
     /// @param degrees - degrees value to sent to the fin
     bool UpdateFin_Degrees(const FIN fin, const double degrees);
 
+    /// @brief Get the last command frame, from the thread that issues commands
+    /// @return last command, zero deflections before the first
+    FinCommand GetLastCommand() const { return m_lastCommand; }
+
+    /// @brief Get the actuator loop timing
+    /// @return copy of the stats
+    ActuatorStats GetActuatorStats();
+
 protected:
 
 private:
+    /// @brief Servo frame period written when a fin is readied, 50Hz
+    static constexpr size_t SERVO_PERIOD_NS = 20000000;
+
+    /// @brief Longest a replay runs on after its last command waiting for the fins to settle
+    static constexpr uint64_t MAX_SETTLE_SEC = 60;
+
+    /// @brief One pass of the actuator loop, take the newest command and write the fins and discretes
+    /// @param periodSec - in - time since the last tick
+    void Tick(const double periodSec);
+
+    /// @brief Check whether every ready fin is within the deadband of its target with a good write
+    /// @return true if settled
+    bool Settled() const;
+
+    /// @brief Save the trace to the trace path, if both are set
+    void SaveTrace();
+
+    /// @brief Step every ready fin toward its target and write the ones whose pulse changed
+    /// @param periodSec - in - time since the last tick
+    void UpdateOutputs(const double periodSec);
+
+    /// @brief Write the latched discrete outputs and publish the queued input edges
+    void UpdateDiscretes();
+
     std::atomic_bool mRun   = false;        /// Flag for running loop.           
 
-    PWM mFin1;                              /// PWM connected to Fin 1
-    PWM mFin2;                              /// PWM connected to Fin 2
-    PWM mFin3;                              /// PWM connected to Fin 3
-    PWM mFin4;                              /// PWM connected to Fin 4
+    std::array<PWM, NUM_FINS> mFins = { PWM(""), PWM(""), PWM(""), PWM("") };  /// PWM per fin, FIN order
+    std::array<bool, NUM_FINS> mFinReady = {};                                  /// Indicator flag per fin
+
+    MixerMatrix m_mixer =                    /// X configuration, opposite fins deflect together in roll
+    {{
+        {  1.0,  1.0,  1.0 },
+        {  1.0, -1.0,  1.0 },
+        {  1.0, -1.0, -1.0 },
+        {  1.0,  1.0, -1.0 },
+    }};
+
+    Topic<FinCommand, 4>    m_commands;      /// Latest command frame, latched whole
+    Subscriber<FinCommand, 4> m_latestCommand{ m_commands, Delivery::Latest };  /// Actuator loop's reader, made with the topic so no frame is missed
+    FinCommand              m_lastCommand;   /// Last command issued, the base for single fin updates
+    int                     m_rateHz = 200;  /// Actuator loop rate
+    double                  m_slewRate = 0;  /// deg/s, 0 for no limit
+    double                  m_deadband = 0;  /// deg a fin holds within
+    PwmBackendType          m_backend = PwmBackendType::Sysfs;  /// Hardware access for readied fins
+    std::shared_ptr<PwmTrace> m_trace;       /// Fin writes, simulated backend only
+    std::string             m_tracePath;     /// Where the trace is saved, empty for not saved
+
+    // Actuator loop owned
+    std::array<double, NUM_FINS> m_targets = {};    /// Commanded deflection per fin, clamped
+    std::array<double, NUM_FINS> m_outputs = {};    /// Deflection last stepped to per fin
+    std::array<size_t, NUM_FINS> m_pulses = {};    /// Pulse width last written per fin, us, 0 before the first
+    std::array<bool, NUM_FINS> m_writeFailed = {}; /// Last write per fin failed and is retried
+    uint64_t                m_ticks = 0;     /// Actuator loop passes run
+    ActuatorStats           m_stats;         /// Actuator loop timing
 
-    bool mFin1Ready         = false;        /// Indicator flag for Fin 1
-    bool mFin2Ready         = false;        /// Indicator flag for Fin 2
-    bool mFin3Ready         = false;        /// Indicator flag for Fin 3
-    bool mFin4Ready         = false;        /// Indicator flag for Fin 4
+    GPIO                    m_discretes;     /// Discrete lines
+    DiscreteTopic*          m_discreteTopic = nullptr;  /// Where input edges are published
+    std::mutex              m_discreteMutex; /// Protects the latched discrete outputs
+    uint64_t                m_discreteValues = 0;       /// Latched output values
+    uint64_t                m_discretePending = 0;      /// Lines changed since the last write
+    std::mutex              m_statsMutex;    /// Protects m_stats
 
     std::string m_name       = "SIG MGR";    /// Name for logging
     LogClient& m_logger;                     /// Logger
@@ -0,0 +1,190 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            geodesy.cpp
+// @brief           Implementation for the geodesy functions
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cmath>                            // trig
+//
+#include "geodesy.h"                        // header
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Geodesy
+{
+    namespace
+    {
+        constexpr int       VINCENTY_MAX_ITERATIONS = 20;       // converges in 3-4 outside nearly antipodal points
+        constexpr double    VINCENTY_TOLERANCE      = 1.0e-12;  // rad of longitude on the auxiliary sphere, ~0.006 mm
+
+        /// @brief Wrap an angle to 0 to 2 pi
+        inline double WrapTwoPi(double angle)
+        {
+            angle = std::fmod(angle, 2.0 * std::numbers::pi);
+            return angle < 0.0 ? angle + 2.0 * std::numbers::pi : angle;
+        }
+    }
+
+    Geodetic FromEcef(const Vector3& ecef)
+    {
+        // Zhu / Heikkinen
+        const double x = ecef[0];
+        const double y = ecef[1];
+        const double z = ecef[2];
+
+        const double p2 = x * x + y * y;
+        const double p = std::sqrt(p2);
+        const double z2 = z * z;
+
+        const double f = 54.0 * B * B * z2;
+        const double g = p2 + (1.0 - E2) * z2 - E2 * (A * A - B * B);
+        const double c = E2 * E2 * f * p2 / (g * g * g);
+        const double s = std::cbrt(1.0 + c + std::sqrt(c * c + 2.0 * c));
+        const double k = s + 1.0 + 1.0 / s;
+        const double pp = f / (3.0 * k * k * g * g);
+        const double q = std::sqrt(1.0 + 2.0 * E2 * E2 * pp);
+        const double r0 = -(pp * E2 * p) / (1.0 + q) +
+            std::sqrt(0.5 * A * A * (1.0 + 1.0 / q) - pp * (1.0 - E2) * z2 / (q * (1.0 + q)) - 0.5 * pp * p2);
+        const double t = p - E2 * r0;
+        const double u = std::sqrt(t * t + z2);
+        const double v = std::sqrt(t * t + (1.0 - E2) * z2);
+        const double z0 = B * B * z / (A * v);
+
+        Geodetic position;
+        position.latitude = std::atan2(z + EP2 * z0, p);
+        position.longitude = std::atan2(y, x);
+        position.altitude = u * (1.0 - B * B / (A * v));
+        return position;
+    }
+
+    Geodesic Inverse(const Geodetic& from, const Geodetic& to)
+    {
+        Geodesic result;
+
+        // reduced latitudes, tan(U) = (1 - f) tan(latitude)
+        const double tanU1 = (1.0 - F) * std::tan(from.latitude);
+        const double tanU2 = (1.0 - F) * std::tan(to.latitude);
+        const double cosU1 = 1.0 / std::sqrt(1.0 + tanU1 * tanU1);
+        const double cosU2 = 1.0 / std::sqrt(1.0 + tanU2 * tanU2);
+        const double sinU1 = tanU1 * cosU1;
+        const double sinU2 = tanU2 * cosU2;
+
+        const double longitudeDelta = to.longitude - from.longitude;
+        double lambda = longitudeDelta;
+
+        double sinLambda = 0.0, cosLambda = 0.0;
+        double sinSigma = 0.0, cosSigma = 0.0, sigma = 0.0;
+        double cosSqAlpha = 0.0, cos2SigmaM = 0.0;
+
+        result.converged = false;
+        for (int iteration = 0; iteration < VINCENTY_MAX_ITERATIONS; iteration++)
+        {
+            sinLambda = std::sin(lambda);
+            cosLambda = std::cos(lambda);
+
+            const double crossTerm = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+            sinSigma = std::sqrt((cosU2 * sinLambda) * (cosU2 * sinLambda) + crossTerm * crossTerm);
+
+            // coincident points
+            if (sinSigma == 0.0)
+            {
+                result.converged = true;
+                return result;
+            }
+
+            cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+            sigma = std::atan2(sinSigma, cosSigma);
+
+            const double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+            cosSqAlpha = 1.0 - sinAlpha * sinAlpha;
+
+            // both points on the equator
+            cos2SigmaM = cosSqAlpha != 0.0 ? cosSigma - 2.0 * sinU1 * sinU2 / cosSqAlpha : 0.0;
+
+            const double c = F / 16.0 * cosSqAlpha * (4.0 + F * (4.0 - 3.0 * cosSqAlpha));
+            const double previous = lambda;
+            lambda = longitudeDelta + (1.0 - c) * F * sinAlpha *
+                (sigma + c * sinSigma * (cos2SigmaM + c * cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM)));
+
+            if (std::fabs(lambda - previous) < VINCENTY_TOLERANCE)
+            {
+                result.converged = true;
+                break;
+            }
+        }
+
+        const double uSq = cosSqAlpha * EP2;
+        const double a = 1.0 + uSq / 16384.0 * (4096.0 + uSq * (-768.0 + uSq * (320.0 - 175.0 * uSq)));
+        const double b = uSq / 1024.0 * (256.0 + uSq * (-128.0 + uSq * (74.0 - 47.0 * uSq)));
+        const double cos2SigmaMSq = cos2SigmaM * cos2SigmaM;
+        const double deltaSigma = b * sinSigma * (cos2SigmaM + b / 4.0 * (cosSigma * (-1.0 + 2.0 * cos2SigmaMSq) -
+            b / 6.0 * cos2SigmaM * (-3.0 + 4.0 * sinSigma * sinSigma) * (-3.0 + 4.0 * cos2SigmaMSq)));
+
+        result.distance = B * a * (sigma - deltaSigma);
+        result.initialAzimuth = WrapTwoPi(std::atan2(cosU2 * sinLambda, cosU1 * sinU2 - sinU1 * cosU2 * cosLambda));
+        result.finalAzimuth = WrapTwoPi(std::atan2(cosU1 * sinLambda, -sinU1 * cosU2 + cosU1 * sinU2 * cosLambda));
+        return result;
+    }
+
+    LocalFrame::LocalFrame(const Geodetic& origin) : m_origin(origin), m_originEcef(ToEcef(origin))
+    {
+        const double sinLat = std::sin(origin.latitude);
+        const double cosLat = std::cos(origin.latitude);
+        const double sinLon = std::sin(origin.longitude);
+        const double cosLon = std::cos(origin.longitude);
+
+        m_ecefToNed = Matrix3({ -sinLat * cosLon,  -sinLat * sinLon,   cosLat,
+                                -sinLon,            cosLon,            0.0,
+                                -cosLat * cosLon,  -cosLat * sinLon,  -sinLat });
+    }
+
+    Vector3 LocalFrame::ToNed(const Geodetic& position) const
+    {
+        return m_ecefToNed * (ToEcef(position) - m_originEcef);
+    }
+
+    Geodetic LocalFrame::FromNed(const Vector3& ned) const
+    {
+        return FromEcef(m_ecefToNed.Transpose() * ned + m_originEcef);
+    }
+
+    void LocalFrame::ToNed(const double* latitude, const double* longitude, const double* altitude, const size_t count,
+        double* north, double* east, double* down) const
+    {
+        // the rotation and origin are hoisted to scalars so every element runs the same straight line code
+        const double r00 = m_ecefToNed(0, 0), r01 = m_ecefToNed(0, 1), r02 = m_ecefToNed(0, 2);
+        const double r10 = m_ecefToNed(1, 0), r11 = m_ecefToNed(1, 1);
+        const double r20 = m_ecefToNed(2, 0), r21 = m_ecefToNed(2, 1), r22 = m_ecefToNed(2, 2);
+        const double ox = m_originEcef[0], oy = m_originEcef[1], oz = m_originEcef[2];
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const double sinLat = std::sin(latitude[i]);
+            const double cosLat = std::cos(latitude[i]);
+            const double transverse = A / std::sqrt(1.0 - E2 * sinLat * sinLat);
+            const double horizontal = (transverse + altitude[i]) * cosLat;
+
+            const double dx = horizontal * std::cos(longitude[i]) - ox;
+            const double dy = horizontal * std::sin(longitude[i]) - oy;
+            const double dz = (transverse * (1.0 - E2) + altitude[i]) * sinLat - oz;
+
+            north[i] = r00 * dx + r01 * dy + r02 * dz;
+            east[i] = r10 * dx + r11 * dy;
+            down[i] = r20 * dx + r21 * dy + r22 * dz;
+        }
+    }
+
+    void LocalFrame::RangeBearing(const double* north, const double* east, const size_t count, double* range, double* bearing)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            range[i] = std::sqrt(north[i] * north[i] + east[i] * east[i]);
+            bearing[i] = std::atan2(east[i], north[i]);
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            geodesy.h
+// @brief           WGS84 position conversions, geodesics and local frames
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cmath>                            // trig
+#include <cstddef>                          // size_t
+#include <numbers>                          // pi
+//
+#include "matrix.h"                         // vectors
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Geodesy
+{
+    // WGS84 ellipsoid
+    constexpr double A              = 6378137.0;                    // m, semi-major axis
+    constexpr double F              = 1.0 / 298.257223563;          // flattening
+    constexpr double B              = A * (1.0 - F);                // m, semi-minor axis
+    constexpr double E2             = F * (2.0 - F);                // first eccentricity squared
+    constexpr double EP2            = E2 / (1.0 - E2);              // second eccentricity squared
+    constexpr double EARTH_RATE     = 7.292115e-5;                  // rad/s
+
+    constexpr double DEG_TO_RAD     = std::numbers::pi / 180.0;
+    constexpr double RAD_TO_DEG     = 180.0 / std::numbers::pi;
+
+    /// @brief Geodetic position, angles in rad and height above the ellipsoid
+    struct Geodetic
+    {
+        double  latitude    = 0.0;      // rad
+        double  longitude   = 0.0;      // rad
+        double  altitude    = 0.0;      // m
+    };
+
+    /// @brief Result of a geodesic between two points on the ellipsoid
+    struct Geodesic
+    {
+        double  distance        = 0.0;      // m, along the ellipsoid surface
+        double  initialAzimuth  = 0.0;      // rad from north at the start, 0 to 2 pi
+        double  finalAzimuth    = 0.0;      // rad from north at the end, 0 to 2 pi
+        bool    converged       = true;     // false for nearly antipodal points, the result is approximate
+    };
+
+    /// @brief Meridian and prime vertical radii of curvature
+    /// @param latitude - [in] - rad
+    /// @param meridian - [out] - m, north south radius
+    /// @param transverse - [out] - m, east west radius
+    inline void EarthRadii(const double latitude, double& meridian, double& transverse)
+    {
+        const double s = std::sin(latitude);
+        const double w = 1.0 - E2 * s * s;
+        const double sqrtW = std::sqrt(w);
+        meridian = A * (1.0 - E2) / (w * sqrtW);
+        transverse = A / sqrtW;
+    }
+
+    /// @brief Normal gravity, Somigliana with a free air height correction
+    /// @param latitude - [in] - rad
+    /// @param altitude - [in] - m
+    /// @return m/s^2
+    inline double NormalGravity(const double latitude, const double altitude)
+    {
+        const double s2 = std::sin(latitude) * std::sin(latitude);
+        return 9.7803253359 * (1.0 + 0.00193185265241 * s2) / std::sqrt(1.0 - E2 * s2) - 3.086e-6 * altitude;
+    }
+
+    /// @brief Earth centred earth fixed position of a geodetic position
+    /// @param position - [in] - geodetic position
+    /// @return m, ECEF x y z
+    inline Vector3 ToEcef(const Geodetic& position)
+    {
+        const double sinLat = std::sin(position.latitude);
+        const double cosLat = std::cos(position.latitude);
+        const double transverse = A / std::sqrt(1.0 - E2 * sinLat * sinLat);
+        const double horizontal = (transverse + position.altitude) * cosLat;
+
+        return Vector3({ horizontal * std::cos(position.longitude),
+                         horizontal * std::sin(position.longitude),
+                         (transverse * (1.0 - E2) + position.altitude) * sinLat });
+    }
+
+    /// @brief Geodetic position of an ECEF position, closed form with no iteration
+    /// @param ecef - [in] - m, ECEF x y z
+    /// @return geodetic position
+    Geodetic FromEcef(const Vector3& ecef);
+
+    /// @brief Shortest path between two points on the ellipsoid. Vincenty's inverse method, the
+    /// iteration count is bounded so the cost is bounded for every input.
+    /// @param from - [in] - start, altitude is ignored
+    /// @param to - [in] - end, altitude is ignored
+    /// @return distance and azimuths
+    Geodesic Inverse(const Geodetic& from, const Geodetic& to);
+
+    /// @brief North east down frame at a fixed origin, such as a target. The origin's ECEF position
+    /// and rotation are computed once so each conversion is a few multiplies and one ToEcef().
+    class LocalFrame
+    {
+    public:
+
+        /// @brief Frame at the equator and prime meridian
+        LocalFrame() : LocalFrame(Geodetic{}) {}
+
+        /// @brief Frame at an origin
+        /// @param origin - [in] - origin of the frame
+        explicit LocalFrame(const Geodetic& origin);
+
+        /// @brief Get the origin
+        /// @return origin of the frame
+        const Geodetic& Origin() const { return m_origin; }
+
+        /// @brief Position in the frame
+        /// @param position - [in] - geodetic position
+        /// @return m, north east down from the origin
+        Vector3 ToNed(const Geodetic& position) const;
+
+        /// @brief Geodetic position of a point in the frame
+        /// @param ned - [in] - m, north east down from the origin
+        /// @return geodetic position
+        Geodetic FromNed(const Vector3& ned) const;
+
+        /// @brief Positions in the frame, structure of arrays so the loop vectorizes
+        /// @param latitude - [in] - rad, count values
+        /// @param longitude - [in] - rad, count values
+        /// @param altitude - [in] - m, count values
+        /// @param count - [in] - number of positions
+        /// @param north - [out] - m, count values
+        /// @param east - [out] - m, count values
+        /// @param down - [out] - m, count values
+        void ToNed(const double* latitude, const double* longitude, const double* altitude, const size_t count,
+            double* north, double* east, double* down) const;
+
+        /// @brief Horizontal range and bearing from the origin, structure of arrays
+        /// @param north - [in] - m, count values
+        /// @param east - [in] - m, count values
+        /// @param count - [in] - number of positions
+        /// @param range - [out] - m, count values
+        /// @param bearing - [out] - rad from north, -pi to pi, count values
+        static void RangeBearing(const double* north, const double* east, const size_t count, double* range, double* bearing);
+
+    private:
+
+        Geodetic    m_origin;           /// Origin
+        Vector3     m_originEcef;       /// Origin in ECEF
+        Matrix3     m_ecefToNed;        /// Rotation from ECEF to the frame
+    };
+}
@@ -0,0 +1,246 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            matrix.h
+// @brief           Fixed size matrix math for the navigation filter
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <array>                            // storage
+#include <cmath>                            // sqrt
+#include <cstddef>                          // size_t
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Row major matrix with dimensions fixed at compile time. Lives on the stack, never
+/// allocates, and every loop has constant bounds so the compiler can unroll and vectorize it.
+/// @tparam Rows - number of rows
+/// @tparam Cols - number of columns
+/// @tparam T - element type
+template <size_t Rows, size_t Cols, typename T = double>
+class Matrix
+{
+public:
+
+    static constexpr size_t ROWS = Rows;
+    static constexpr size_t COLS = Cols;
+
+    /// @brief Zero matrix
+    constexpr Matrix() = default;
+
+    /// @brief Matrix from elements in row major order
+    /// @param values - [in] - Rows * Cols elements
+    constexpr Matrix(const std::array<T, Rows * Cols>& values) : m_data(values) {}
+
+    /// @brief Zero matrix
+    static constexpr Matrix Zero() { return Matrix(); }
+
+    /// @brief Identity matrix, square only
+    static constexpr Matrix Identity()
+    {
+        static_assert(Rows == Cols, "Identity needs a square matrix");
+        Matrix result;
+        for (size_t i = 0; i < Rows; i++) result(i, i) = T(1);
+        return result;
+    }
+
+    constexpr T& operator()(size_t row, size_t col)                 { return m_data[row * Cols + col]; }
+    constexpr const T& operator()(size_t row, size_t col) const     { return m_data[row * Cols + col]; }
+
+    /// @brief Element access for vectors
+    constexpr T& operator[](size_t index)                           { return m_data[index]; }
+    constexpr const T& operator[](size_t index) const               { return m_data[index]; }
+
+    T* Data()                                                       { return m_data.data(); }
+    const T* Data() const                                           { return m_data.data(); }
+
+    constexpr Matrix& operator+=(const Matrix& other)
+    {
+        for (size_t i = 0; i < Rows * Cols; i++) m_data[i] += other.m_data[i];
+        return *this;
+    }
+
+    constexpr Matrix& operator-=(const Matrix& other)
+    {
+        for (size_t i = 0; i < Rows * Cols; i++) m_data[i] -= other.m_data[i];
+        return *this;
+    }
+
+    constexpr Matrix& operator*=(const T scale)
+    {
+        for (size_t i = 0; i < Rows * Cols; i++) m_data[i] *= scale;
+        return *this;
+    }
+
+    constexpr Matrix operator+(const Matrix& other) const   { Matrix result = *this; return result += other; }
+    constexpr Matrix operator-(const Matrix& other) const   { Matrix result = *this; return result -= other; }
+    constexpr Matrix operator*(const T scale) const         { Matrix result = *this; return result *= scale; }
+    constexpr Matrix operator-() const                      { return *this * T(-1); }
+
+    /// @brief Matrix product. The inner loop runs along a row of both the
+    /// right hand side and the result so it streams contiguous memory.
+    template <size_t Inner>
+    constexpr Matrix<Rows, Inner, T> operator*(const Matrix<Cols, Inner, T>& other) const
+    {
+        Matrix<Rows, Inner, T> result;
+        for (size_t i = 0; i < Rows; i++)
+        {
+            for (size_t k = 0; k < Cols; k++)
+            {
+                const T a = (*this)(i, k);
+                for (size_t j = 0; j < Inner; j++) result(i, j) += a * other(k, j);
+            }
+        }
+        return result;
+    }
+
+    /// @brief Transpose
+    constexpr Matrix<Cols, Rows, T> Transpose() const
+    {
+        Matrix<Cols, Rows, T> result;
+        for (size_t i = 0; i < Rows; i++)
+        {
+            for (size_t j = 0; j < Cols; j++) result(j, i) = (*this)(i, j);
+        }
+        return result;
+    }
+
+    /// @brief Copy out a block
+    /// @tparam BlockRows - rows in the block
+    /// @tparam BlockCols - columns in the block
+    /// @param row - [in] - first row of the block
+    /// @param col - [in] - first column of the block
+    template <size_t BlockRows, size_t BlockCols>
+    constexpr Matrix<BlockRows, BlockCols, T> Block(size_t row, size_t col) const
+    {
+        Matrix<BlockRows, BlockCols, T> result;
+        for (size_t i = 0; i < BlockRows; i++)
+        {
+            for (size_t j = 0; j < BlockCols; j++) result(i, j) = (*this)(row + i, col + j);
+        }
+        return result;
+    }
+
+    /// @brief Overwrite a block
+    /// @param row - [in] - first row of the block
+    /// @param col - [in] - first column of the block
+    /// @param block - [in] - values to write
+    template <size_t BlockRows, size_t BlockCols>
+    constexpr void SetBlock(size_t row, size_t col, const Matrix<BlockRows, BlockCols, T>& block)
+    {
+        for (size_t i = 0; i < BlockRows; i++)
+        {
+            for (size_t j = 0; j < BlockCols; j++) (*this)(row + i, col + j) = block(i, j);
+        }
+    }
+
+    /// @brief Average a square matrix with its transpose, keeps a covariance symmetric
+    constexpr void Symmetrize()
+    {
+        static_assert(Rows == Cols, "Symmetrize needs a square matrix");
+        for (size_t i = 0; i < Rows; i++)
+        {
+            for (size_t j = i + 1; j < Cols; j++)
+            {
+                const T mean = ((*this)(i, j) + (*this)(j, i)) * T(0.5);
+                (*this)(i, j) = mean;
+                (*this)(j, i) = mean;
+            }
+        }
+    }
+
+    /// @brief Dot product, vectors only
+    constexpr T Dot(const Matrix& other) const
+    {
+        static_assert(Cols == 1, "Dot needs a column vector");
+        T sum = T(0);
+        for (size_t i = 0; i < Rows; i++) sum += m_data[i] * other.m_data[i];
+        return sum;
+    }
+
+    /// @brief Euclidean length, vectors only
+    T Norm() const { return std::sqrt(Dot(*this)); }
+
+private:
+    std::array<T, Rows * Cols>  m_data  = {};   /// Elements, row major
+};
+
+template <size_t Rows, typename T = double>
+using Vector = Matrix<Rows, 1, T>;
+
+using Vector3 = Vector<3>;
+using Matrix3 = Matrix<3, 3>;
+
+/// @brief Scalar times matrix
+template <size_t Rows, size_t Cols, typename T>
+constexpr Matrix<Rows, Cols, T> operator*(const T scale, const Matrix<Rows, Cols, T>& matrix)
+{
+    return matrix * scale;
+}
+
+/// @brief Cross product a x b
+constexpr Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+    return Vector3({ a[1] * b[2] - a[2] * b[1],
+                     a[2] * b[0] - a[0] * b[2],
+                     a[0] * b[1] - a[1] * b[0] });
+}
+
+/// @brief Skew symmetric matrix of v, Skew(a) * b == Cross(a, b)
+constexpr Matrix3 Skew(const Vector3& v)
+{
+    return Matrix3({ 0.0,   -v[2],  v[1],
+                     v[2],   0.0,  -v[0],
+                    -v[1],   v[0],  0.0 });
+}
+
+/// @brief Solve A X = B for a symmetric positive definite A with a Cholesky factorization
+/// @param a - [in] - symmetric positive definite matrix
+/// @param b - [in] - right hand side
+/// @param x - [out] - solution
+/// @return true if solved, false if A is not positive definite
+template <size_t N, size_t M, typename T>
+bool CholeskySolve(const Matrix<N, N, T>& a, const Matrix<N, M, T>& b, Matrix<N, M, T>& x)
+{
+    // A = L L^T, L lower triangular
+    Matrix<N, N, T> l;
+    for (size_t j = 0; j < N; j++)
+    {
+        T diagonal = a(j, j);
+        for (size_t k = 0; k < j; k++) diagonal -= l(j, k) * l(j, k);
+        if (!(diagonal > T(0))) return false;
+
+        l(j, j) = std::sqrt(diagonal);
+        const T inverse = T(1) / l(j, j);
+
+        for (size_t i = j + 1; i < N; i++)
+        {
+            T sum = a(i, j);
+            for (size_t k = 0; k < j; k++) sum -= l(i, k) * l(j, k);
+            l(i, j) = sum * inverse;
+        }
+    }
+
+    // forward substitution L Y = B, then back substitution L^T X = Y
+    for (size_t c = 0; c < M; c++)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            T sum = b(i, c);
+            for (size_t k = 0; k < i; k++) sum -= l(i, k) * x(k, c);
+            x(i, c) = sum / l(i, i);
+        }
+        for (size_t i = N; i-- > 0;)
+        {
+            T sum = x(i, c);
+            for (size_t k = i + 1; k < N; k++) sum -= l(k, i) * x(k, c);
+            x(i, c) = sum / l(i, i);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,338 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            nav_filter.cpp
+// @brief           Implementation for the navigation filter
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <algorithm>                        // max
+#include <cmath>                            // trig
+#include <numbers>                          // pi
+//
+#include "nav_filter.h"                     // header
+#include "geodesy.h"                        // wgs84
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using Geodesy::DEG_TO_RAD;
+    using Geodesy::RAD_TO_DEG;
+    using Geodesy::EARTH_RATE;
+    using Geodesy::EarthRadii;
+
+    // measurement noise floors, a receiver reporting less than this is trusted no further
+    constexpr double MIN_POSITION_SIGMA = 0.3;                  // m
+    constexpr double MIN_VELOCITY_SIGMA = 0.05;                 // m/s
+    constexpr double DEFAULT_POSITION_SIGMA = 5.0;              // m, receiver gave no accuracy
+    constexpr double DEFAULT_VELOCITY_SIGMA = 0.5;              // m/s, receiver gave no accuracy
+
+    /// @brief out rows [row, row + 3) += block * in rows [source, source + 3)
+    template <size_t N>
+    inline void AddRowBlock(Matrix<N, N>& out, const size_t row, const Matrix3& block, const Matrix<N, N>& in, const size_t source)
+    {
+        for (size_t i = 0; i < 3; i++)
+        {
+            for (size_t k = 0; k < 3; k++)
+            {
+                const double b = block(i, k);
+                for (size_t j = 0; j < N; j++) out(row + i, j) += b * in(source + k, j);
+            }
+        }
+    }
+
+    /// @brief out columns [col, col + 3) += in columns [source, source + 3) * block'
+    template <size_t N>
+    inline void AddColumnBlock(Matrix<N, N>& out, const size_t col, const Matrix3& block, const Matrix<N, N>& in, const size_t source)
+    {
+        for (size_t r = 0; r < N; r++)
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                double sum = 0.0;
+                for (size_t k = 0; k < 3; k++) sum += in(r, source + k) * block(i, k);
+                out(r, col + i) += sum;
+            }
+        }
+    }
+
+    /// @brief Symmetric 3x3 from an upper triangle NN NE ND EE ED DD
+    inline Matrix3 FromUpperTriangle(const double upper[6])
+    {
+        return Matrix3({ upper[0], upper[1], upper[2],
+                         upper[1], upper[3], upper[4],
+                         upper[2], upper[4], upper[5] });
+    }
+}
+
+NavigationFilter::NavigationFilter(const NavigationNoise& noise) : m_noise(noise)
+{
+}
+
+bool NavigationFilter::Initialize(const GpsData& gps, const double roll, const double pitch, const double yaw)
+{
+    if (gps.fixType < 3 || gps.fixType > 4) return false;
+
+    m_latitude = gps.latitude * DEG_TO_RAD;
+    m_longitude = gps.longitude * DEG_TO_RAD;
+    m_altitude = gps.altitude;
+    m_velocity = gps.velocityValid ? Vector3({ gps.velocityNorth, gps.velocityEast, gps.velocityDown }) : Vector3();
+    m_attitude = Quaternion::FromEuler(roll, pitch, yaw);
+    m_gyroBias = {};
+    m_accelBias = {};
+
+    const double position = std::max(m_noise.initialPosition, gps.horizontalAccuracy);
+    const double velocity = m_noise.initialVelocity;
+
+    m_covariance = Covariance::Zero();
+    for (size_t i = 0; i < 3; i++)
+    {
+        m_covariance(POS + i, POS + i) = position * position;
+        m_covariance(VEL + i, VEL + i) = velocity * velocity;
+        m_covariance(GYRO_BIAS + i, GYRO_BIAS + i) = m_noise.initialGyroBias * m_noise.initialGyroBias;
+        m_covariance(ACCEL_BIAS + i, ACCEL_BIAS + i) = m_noise.initialAccelBias * m_noise.initialAccelBias;
+    }
+    m_covariance(ATT + 0, ATT + 0) = m_noise.initialTilt * m_noise.initialTilt;
+    m_covariance(ATT + 1, ATT + 1) = m_noise.initialTilt * m_noise.initialTilt;
+    m_covariance(ATT + 2, ATT + 2) = m_noise.initialHeading * m_noise.initialHeading;
+
+    m_timestampNs = gps.rxFirstByteNs;
+    m_updateCount = 0;
+    m_rejectedCount = 0;
+    m_initialized = true;
+    return true;
+}
+
+void NavigationFilter::Propagate(const ImuIncrement& increment)
+{
+    if (!m_initialized || increment.sampleCount == 0 || increment.intervalSec <= 0.0) return;
+
+    const double dt = increment.intervalSec;
+
+    const Vector3 deltaAngle = Vector3({ increment.deltaAngle[0], increment.deltaAngle[1], increment.deltaAngle[2] }) - m_gyroBias * dt;
+    const Vector3 deltaVelocity = Vector3({ increment.deltaVelocity[0], increment.deltaVelocity[1], increment.deltaVelocity[2] }) - m_accelBias * dt;
+
+    double meridian = 0.0;
+    double transverse = 0.0;
+    EarthRadii(m_latitude, meridian, transverse);
+
+    const double sinLat = std::sin(m_latitude);
+    const double cosLat = std::cos(m_latitude);
+    const double northRadius = meridian + m_altitude;
+    const double eastRadius = transverse + m_altitude;
+
+    // earth rate and the rotation of the local level frame as it moves over the earth
+    const Vector3 earthRate({ EARTH_RATE * cosLat, 0.0, -EARTH_RATE * sinLat });
+    const Vector3 transportRate({ m_velocity[1] / eastRadius, -m_velocity[0] / northRadius, -m_velocity[1] * sinLat / (cosLat * eastRadius) });
+    const Vector3 navRate = earthRate + transportRate;
+
+    // the increment is resolved in the body frame at its start, rotate it with the attitude before this step
+    const Matrix3 bodyToNav = m_attitude.ToDcm();
+    const Vector3 specificForce = bodyToNav * deltaVelocity;
+    const Vector3 gravity({ 0.0, 0.0, Geodesy::NormalGravity(m_latitude, m_altitude) });
+    const Vector3 coriolis = Cross(earthRate * 2.0 + transportRate, m_velocity);
+
+    const Vector3 previousVelocity = m_velocity;
+    m_velocity += specificForce + (gravity - coriolis) * dt;
+
+    m_attitude = Quaternion::FromRotationVector(navRate * -dt) * m_attitude * Quaternion::FromRotationVector(deltaAngle);
+    m_attitude.Normalize();
+
+    // trapezoidal position
+    const Vector3 meanVelocity = (previousVelocity + m_velocity) * 0.5;
+    m_latitude += meanVelocity[0] * dt / northRadius;
+    m_longitude += meanVelocity[1] * dt / (eastRadius * cosLat);
+    m_altitude -= meanVelocity[2] * dt;
+
+    // error state transition F = I + A, first order. A has five 3x3 blocks, so F P F' is
+    // built from them directly instead of two dense 15x15 products.
+    const Matrix3 positionVelocity = Matrix3::Identity() * dt;
+    const Matrix3 velocityAttitude = -Skew(specificForce);
+    const Matrix3 biasCoupling = bodyToNav * -dt;
+    const Matrix3 attitudeAttitude = -Skew(navRate) * dt;
+
+    Covariance fp = m_covariance;
+    AddRowBlock(fp, POS, positionVelocity, m_covariance, VEL);
+    AddRowBlock(fp, VEL, velocityAttitude, m_covariance, ATT);
+    AddRowBlock(fp, VEL, biasCoupling, m_covariance, ACCEL_BIAS);
+    AddRowBlock(fp, ATT, attitudeAttitude, m_covariance, ATT);
+    AddRowBlock(fp, ATT, biasCoupling, m_covariance, GYRO_BIAS);
+
+    m_covariance = fp;
+    AddColumnBlock(m_covariance, POS, positionVelocity, fp, VEL);
+    AddColumnBlock(m_covariance, VEL, velocityAttitude, fp, ATT);
+    AddColumnBlock(m_covariance, VEL, biasCoupling, fp, ACCEL_BIAS);
+    AddColumnBlock(m_covariance, ATT, attitudeAttitude, fp, ATT);
+    AddColumnBlock(m_covariance, ATT, biasCoupling, fp, GYRO_BIAS);
+
+    const double attitudeNoise = m_noise.gyroNoise * m_noise.gyroNoise * dt;
+    const double velocityNoise = m_noise.accelNoise * m_noise.accelNoise * dt;
+    const double gyroBiasNoise = m_noise.gyroBiasWalk * m_noise.gyroBiasWalk * dt;
+    const double accelBiasNoise = m_noise.accelBiasWalk * m_noise.accelBiasWalk * dt;
+    for (size_t i = 0; i < 3; i++)
+    {
+        m_covariance(VEL + i, VEL + i) += velocityNoise;
+        m_covariance(ATT + i, ATT + i) += attitudeNoise;
+        m_covariance(GYRO_BIAS + i, GYRO_BIAS + i) += gyroBiasNoise;
+        m_covariance(ACCEL_BIAS + i, ACCEL_BIAS + i) += accelBiasNoise;
+    }
+    m_covariance.Symmetrize();
+
+    m_timestampNs = increment.endNs;
+}
+
+bool NavigationFilter::Update(const GpsData& gps)
+{
+    if (!m_initialized || gps.fixType < 3 || gps.fixType > 4) return false;
+
+    double meridian = 0.0;
+    double transverse = 0.0;
+    EarthRadii(m_latitude, meridian, transverse);
+
+    // position residual in metres north east down, longitude wrapped across the date line
+    double longitudeDelta = gps.longitude * DEG_TO_RAD - m_longitude;
+    if (longitudeDelta > std::numbers::pi) longitudeDelta -= 2.0 * std::numbers::pi;
+    else if (longitudeDelta < -std::numbers::pi) longitudeDelta += 2.0 * std::numbers::pi;
+
+    const Vector3 positionResidual({ (gps.latitude * DEG_TO_RAD - m_latitude) * (meridian + m_altitude),
+                                     longitudeDelta * (transverse + m_altitude) * std::cos(m_latitude),
+                                     -(gps.altitude - m_altitude) });
+
+    Matrix3 positionNoise;
+    if (gps.positionCovarianceValid)
+    {
+        positionNoise = FromUpperTriangle(gps.positionCovariance);
+    }
+    else
+    {
+        const double horizontal = gps.horizontalAccuracy > 0.0 ? gps.horizontalAccuracy : DEFAULT_POSITION_SIGMA;
+        const double vertical = gps.verticalAccuracy > 0.0 ? gps.verticalAccuracy : DEFAULT_POSITION_SIGMA;
+        positionNoise(0, 0) = horizontal * horizontal;
+        positionNoise(1, 1) = horizontal * horizontal;
+        positionNoise(2, 2) = vertical * vertical;
+    }
+    for (size_t i = 0; i < 3; i++) positionNoise(i, i) = std::max(positionNoise(i, i), MIN_POSITION_SIGMA * MIN_POSITION_SIGMA);
+
+    bool applied = false;
+    if (gps.velocityValid)
+    {
+        Matrix3 velocityNoise;
+        if (gps.velocityCovarianceValid)
+        {
+            velocityNoise = FromUpperTriangle(gps.velocityCovariance);
+        }
+        else
+        {
+            const double speed = gps.speedAccuracy > 0.0 ? gps.speedAccuracy : DEFAULT_VELOCITY_SIGMA;
+            velocityNoise = Matrix3::Identity() * (speed * speed);
+        }
+        for (size_t i = 0; i < 3; i++) velocityNoise(i, i) = std::max(velocityNoise(i, i), MIN_VELOCITY_SIGMA * MIN_VELOCITY_SIGMA);
+
+        Vector<6> residual;
+        residual.SetBlock(0, 0, positionResidual);
+        residual.SetBlock(3, 0, Vector3({ gps.velocityNorth, gps.velocityEast, gps.velocityDown }) - m_velocity);
+
+        Matrix<6, NUM_STATES> h;
+        h.SetBlock(0, POS, Matrix3::Identity());
+        h.SetBlock(3, VEL, Matrix3::Identity());
+
+        Matrix<6, 6> r;
+        r.SetBlock(0, 0, positionNoise);
+        r.SetBlock(3, 3, velocityNoise);
+
+        applied = Correct(residual, h, r);
+    }
+    else
+    {
+        Matrix<3, NUM_STATES> h;
+        h.SetBlock(0, POS, Matrix3::Identity());
+
+        applied = Correct(positionResidual, h, positionNoise);
+    }
+
+    if (applied) m_updateCount++;
+    else m_rejectedCount++;
+
+    return applied;
+}
+
+NavigationSolution NavigationFilter::GetSolution() const
+{
+    NavigationSolution solution = {};
+    solution.initialized = m_initialized;
+    if (!m_initialized) return solution;
+
+    solution.latitude = m_latitude * RAD_TO_DEG;
+    solution.longitude = m_longitude * RAD_TO_DEG;
+    solution.altitude = m_altitude;
+    solution.velocityNorth = m_velocity[0];
+    solution.velocityEast = m_velocity[1];
+    solution.velocityDown = m_velocity[2];
+    m_attitude.ToEuler(solution.roll, solution.pitch, solution.yaw);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        solution.gyroBias[i] = m_gyroBias[i];
+        solution.accelBias[i] = m_accelBias[i];
+        solution.positionSigma[i] = std::sqrt(m_covariance(POS + i, POS + i));
+        solution.velocitySigma[i] = std::sqrt(m_covariance(VEL + i, VEL + i));
+        solution.attitudeSigma[i] = std::sqrt(m_covariance(ATT + i, ATT + i));
+    }
+
+    solution.timestampNs = m_timestampNs;
+    solution.updateCount = m_updateCount;
+    solution.rejectedUpdateCount = m_rejectedCount;
+    return solution;
+}
+
+template <size_t M>
+bool NavigationFilter::Correct(const Vector<M>& residual, const Matrix<M, NUM_STATES>& h, const Matrix<M, M>& r)
+{
+    // innovation covariance S = H P H' + R
+    const Matrix<M, NUM_STATES> hp = h * m_covariance;
+    const Matrix<M, M> innovation = hp * h.Transpose() + r;
+
+    // reject outliers before they touch the state
+    Vector<M> normalized;
+    if (!CholeskySolve(innovation, residual, normalized)) return false;
+    if (residual.Dot(normalized) > m_noise.innovationGate) return false;
+
+    // K' = S^-1 H P, P is symmetric
+    Matrix<M, NUM_STATES> gainTranspose;
+    if (!CholeskySolve(innovation, hp, gainTranspose)) return false;
+    const Matrix<NUM_STATES, M> gain = gainTranspose.Transpose();
+
+    Inject(gain * residual);
+
+    // P = P - K H P, exact for the optimal gain. Symmetrizing after every step holds off the drift
+    // the Joseph form would otherwise be needed for, at a fraction of its cost.
+    m_covariance -= gain * hp;
+    m_covariance.Symmetrize();
+    return true;
+}
+
+void NavigationFilter::Inject(const StateVector& error)
+{
+    double meridian = 0.0;
+    double transverse = 0.0;
+    EarthRadii(m_latitude, meridian, transverse);
+
+    m_latitude += error[POS + 0] / (meridian + m_altitude);
+    m_longitude += error[POS + 1] / ((transverse + m_altitude) * std::cos(m_latitude));
+    m_altitude -= error[POS + 2];
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        m_velocity[i] += error[VEL + i];
+        m_gyroBias[i] += error[GYRO_BIAS + i];
+        m_accelBias[i] += error[ACCEL_BIAS + i];
+    }
+
+    // attitude errors are small rotations of the navigation frame
+    m_attitude = Quaternion::FromRotationVector(error.Block<3, 1>(ATT, 0)) * m_attitude;
+    m_attitude.Normalize();
+}
@@ -0,0 +1,145 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            nav_filter.h
+// @brief           Loosely coupled GPS / IMU error state navigation filter
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstdint>                          // standard ints
+//
+#include "matrix.h"                         // fixed size matrices
+#include "quaternion.h"                     // attitude
+#include "../gps/gps_type.h"                // gps data
+#include "../imu/imu_preintegrator.h"       // imu increments
+#include "../utilities/topic.h"             // navigation topic
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Sensor noise and initial uncertainty, all 1-sigma
+struct NavigationNoise
+{
+    double  gyroNoise           = 2.0e-4;   // rad/s/sqrt(Hz), angle random walk
+    double  accelNoise          = 2.0e-3;   // m/s^2/sqrt(Hz), velocity random walk
+    double  gyroBiasWalk        = 2.0e-6;   // rad/s^2/sqrt(Hz)
+    double  accelBiasWalk       = 5.0e-5;   // m/s^3/sqrt(Hz)
+
+    double  initialPosition     = 5.0;      // m
+    double  initialVelocity     = 0.5;      // m/s
+    double  initialTilt         = 0.05;     // rad, roll and pitch
+    double  initialHeading      = 0.5;      // rad
+    double  initialGyroBias     = 5.0e-3;   // rad/s
+    double  initialAccelBias    = 0.2;      // m/s^2
+
+    double  innovationGate      = 30.0;     // chi-square limit for a GPS update, larger innovations are rejected
+};
+
+/// @brief Filter output
+struct NavigationSolution
+{
+    double  latitude            = 0.0;      // deg
+    double  longitude           = 0.0;      // deg
+    double  altitude            = 0.0;      // m, same datum as the GPS that initialized the filter
+    double  velocityNorth       = 0.0;      // m/s
+    double  velocityEast        = 0.0;      // m/s
+    double  velocityDown        = 0.0;      // m/s
+    double  roll                = 0.0;      // rad
+    double  pitch               = 0.0;      // rad
+    double  yaw                 = 0.0;      // rad
+    double  gyroBias[3]         = {};       // rad/s
+    double  accelBias[3]        = {};       // m/s^2
+    double  positionSigma[3]    = {};       // m, north east down
+    double  velocitySigma[3]    = {};       // m/s, north east down
+    double  attitudeSigma[3]    = {};       // rad, about north east down
+
+    int64_t timestampNs         = 0;        // monotonic time of the last IMU sample propagated
+    bool    initialized         = false;
+    long    updateCount         = 0;        // GPS updates applied
+    long    rejectedUpdateCount = 0;        // GPS updates failing the innovation gate
+};
+
+/// @brief Bus topic for NavigationSolution, published once per main loop pass that changed it
+using NavigationTopic = Topic<NavigationSolution, 256>;
+
+/// @brief 15 state error state extended Kalman filter. The full state is propagated at IMU rate
+/// from pre-integrated increments, the errors in position, velocity, attitude, gyro bias and
+/// accel bias are estimated and folded back in on each GPS position / velocity update.
+class NavigationFilter
+{
+public:
+
+    static constexpr size_t NUM_STATES = 15;
+
+    /// @brief Constructor
+    /// @param noise - [in/opt] - sensor noise and initial uncertainty
+    NavigationFilter(const NavigationNoise& noise = {});
+
+    /// @brief Start the filter on a GPS solution
+    /// @param gps - [in] - solution with at least a 3D fix
+    /// @param roll - [in] - rad, initial attitude
+    /// @param pitch - [in] - rad, initial attitude
+    /// @param yaw - [in] - rad, initial attitude
+    /// @return true if started, false if the solution is not usable
+    bool Initialize(const GpsData& gps, const double roll, const double pitch, const double yaw);
+
+    /// @brief Check if the filter has been started
+    /// @return true once Initialize() has succeeded
+    bool IsInitialized() const { return m_initialized; }
+
+    /// @brief Advance the state and covariance by one IMU increment
+    /// @param increment - [in] - coning and sculling compensated increment
+    void Propagate(const ImuIncrement& increment);
+
+    /// @brief Correct with a GPS position, and its velocity when reported
+    /// @param gps - [in] - solution, NAV-COV style covariance is used when present
+    /// @return true if applied, false if not initialized, no fix, or rejected by the innovation gate
+    bool Update(const GpsData& gps);
+
+    /// @brief Get the current solution
+    /// @return copy of the solution
+    NavigationSolution GetSolution() const;
+
+private:
+
+    using Covariance = Matrix<NUM_STATES, NUM_STATES>;
+    using StateVector = Vector<NUM_STATES>;
+
+    // error state layout
+    static constexpr size_t POS         = 0;
+    static constexpr size_t VEL         = 3;
+    static constexpr size_t ATT         = 6;
+    static constexpr size_t GYRO_BIAS   = 9;
+    static constexpr size_t ACCEL_BIAS  = 12;
+
+    /// @brief Apply a measurement of M error states
+    /// @param residual - [in] - measured minus predicted
+    /// @param h - [in] - measurement matrix
+    /// @param r - [in] - measurement noise covariance
+    /// @return true if applied, false if gated out or singular
+    template <size_t M>
+    bool Correct(const Vector<M>& residual, const Matrix<M, NUM_STATES>& h, const Matrix<M, M>& r);
+
+    /// @brief Fold an estimated error into the full state
+    /// @param error - [in] - error state
+    void Inject(const StateVector& error);
+
+    NavigationNoise     m_noise;                        /// Noise model
+    bool                m_initialized   = false;        /// Filter started
+
+    double              m_latitude      = 0.0;          /// rad
+    double              m_longitude     = 0.0;          /// rad
+    double              m_altitude      = 0.0;          /// m
+    Vector3             m_velocity;                     /// m/s, north east down
+    Quaternion          m_attitude;                     /// body to north east down
+    Vector3             m_gyroBias;                     /// rad/s
+    Vector3             m_accelBias;                    /// m/s^2
+    Covariance          m_covariance;                   /// Error state covariance
+
+    int64_t             m_timestampNs   = 0;            /// Time of the last propagated sample
+    long                m_updateCount   = 0;            /// GPS updates applied
+    long                m_rejectedCount = 0;            /// GPS updates gated out
+};
@@ -0,0 +1,142 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            quaternion.h
+// @brief           Attitude quaternion for the navigation filter
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cmath>                            // trig
+//
+#include "matrix.h"                         // vectors and dcm
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Hamilton unit quaternion, scalar first. As an attitude it rotates body frame
+/// vectors into the navigation frame.
+struct Quaternion
+{
+    double w    = 1.0;
+    double x    = 0.0;
+    double y    = 0.0;
+    double z    = 0.0;
+
+    /// @brief Hamilton product, this rotation applied after other
+    constexpr Quaternion operator*(const Quaternion& other) const
+    {
+        return { w * other.w - x * other.x - y * other.y - z * other.z,
+                 w * other.x + x * other.w + y * other.z - z * other.y,
+                 w * other.y - x * other.z + y * other.w + z * other.x,
+                 w * other.z + x * other.y - y * other.x + z * other.w };
+    }
+
+    /// @brief Inverse of a unit quaternion
+    constexpr Quaternion Conjugate() const { return { w, -x, -y, -z }; }
+
+    /// @brief Scale back to unit length, integration slowly drifts it
+    void Normalize()
+    {
+        const double norm = std::sqrt(w * w + x * x + y * y + z * z);
+        if (norm <= 0.0) { *this = {}; return; }
+
+        const double inverse = 1.0 / norm;
+        w *= inverse; x *= inverse; y *= inverse; z *= inverse;
+    }
+
+    /// @brief Rotation of an angle about an axis, given as their product
+    /// @param rotation - [in] - rotation vector in rad
+    static Quaternion FromRotationVector(const Vector3& rotation)
+    {
+        const double angle = rotation.Norm();
+
+        // small angles use the series so the axis division never blows up
+        double scale = 0.0;
+        double halfCos = 0.0;
+        if (angle < 1.0e-6)
+        {
+            scale = 0.5 - angle * angle / 48.0;
+            halfCos = 1.0 - angle * angle / 8.0;
+        }
+        else
+        {
+            scale = std::sin(0.5 * angle) / angle;
+            halfCos = std::cos(0.5 * angle);
+        }
+
+        return { halfCos, rotation[0] * scale, rotation[1] * scale, rotation[2] * scale };
+    }
+
+    /// @brief Attitude from aerospace 3-2-1 euler angles
+    /// @param roll - [in] - rad
+    /// @param pitch - [in] - rad
+    /// @param yaw - [in] - rad
+    static Quaternion FromEuler(const double roll, const double pitch, const double yaw)
+    {
+        const double cr = std::cos(0.5 * roll),  sr = std::sin(0.5 * roll);
+        const double cp = std::cos(0.5 * pitch), sp = std::sin(0.5 * pitch);
+        const double cy = std::cos(0.5 * yaw),   sy = std::sin(0.5 * yaw);
+
+        return { cr * cp * cy + sr * sp * sy,
+                 sr * cp * cy - cr * sp * sy,
+                 cr * sp * cy + sr * cp * sy,
+                 cr * cp * sy - sr * sp * cy };
+    }
+
+    /// @brief Aerospace 3-2-1 euler angles of the attitude
+    /// @param roll - [out] - rad
+    /// @param pitch - [out] - rad
+    /// @param yaw - [out] - rad
+    void ToEuler(double& roll, double& pitch, double& yaw) const
+    {
+        roll = std::atan2(2.0 * (w * x + y * z), 1.0 - 2.0 * (x * x + y * y));
+
+        const double sinPitch = 2.0 * (w * y - z * x);
+        pitch = std::asin(sinPitch > 1.0 ? 1.0 : (sinPitch < -1.0 ? -1.0 : sinPitch));
+
+        yaw = std::atan2(2.0 * (w * z + x * y), 1.0 - 2.0 * (y * y + z * z));
+    }
+
+    /// @brief Spherical linear interpolation along the shorter arc
+    /// @param from - [in] - attitude at fraction 0
+    /// @param to - [in] - attitude at fraction 1
+    /// @param fraction - [in] - 0 to 1
+    static Quaternion Slerp(const Quaternion& from, Quaternion to, const double fraction)
+    {
+        double cosAngle = from.w * to.w + from.x * to.x + from.y * to.y + from.z * to.z;
+        if (cosAngle < 0.0)
+        {
+            to = { -to.w, -to.x, -to.y, -to.z };
+            cosAngle = -cosAngle;
+        }
+
+        // nearly parallel, the sine below would lose precision and a normalized lerp is as good
+        double a = 1.0 - fraction;
+        double b = fraction;
+        if (cosAngle < 0.9995)
+        {
+            const double angle = std::acos(cosAngle);
+            const double inverseSin = 1.0 / std::sin(angle);
+            a = std::sin(a * angle) * inverseSin;
+            b = std::sin(b * angle) * inverseSin;
+        }
+
+        Quaternion result = { a * from.w + b * to.w, a * from.x + b * to.x, a * from.y + b * to.y, a * from.z + b * to.z };
+        result.Normalize();
+        return result;
+    }
+
+    /// @brief Direction cosine matrix of the rotation
+    constexpr Matrix3 ToDcm() const
+    {
+        const double ww = w * w, xx = x * x, yy = y * y, zz = z * z;
+        const double xy = x * y, xz = x * z, yz = y * z, wx = w * x, wy = w * y, wz = w * z;
+
+        return Matrix3({ ww + xx - yy - zz,  2.0 * (xy - wz),    2.0 * (xz + wy),
+                         2.0 * (xy + wz),    ww - xx + yy - zz,  2.0 * (yz - wx),
+                         2.0 * (xz - wy),    2.0 * (yz + wx),    ww - xx - yy + zz });
+    }
+};
@@ -0,0 +1,160 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            sensor_history.cpp
+// @brief           Implementation for the sensor history
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <algorithm>                        // min
+#include <numbers>                          // pi
+//
+#include "sensor_history.h"                 // header
+#include "quaternion.h"                     // slerp
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    constexpr int64_t NS_PER_SECOND = 1000000000;
+
+    inline double Lerp(const double from, const double to, const double fraction)
+    {
+        return from + (to - from) * fraction;
+    }
+
+    /// @brief Longitude in degrees, taking the short way across the date line
+    inline double LerpLongitude(const double from, double to, const double fraction)
+    {
+        if (to - from > 180.0) to -= 360.0;
+        else if (to - from < -180.0) to += 360.0;
+
+        double longitude = Lerp(from, to, fraction);
+        if (longitude > 180.0) longitude -= 360.0;
+        else if (longitude <= -180.0) longitude += 360.0;
+        return longitude;
+    }
+
+    /// @brief Slerp between two sets of euler angles
+    inline void SlerpEuler(const double fromRoll, const double fromPitch, const double fromYaw,
+        const double toRoll, const double toPitch, const double toYaw, const double fraction,
+        double& roll, double& pitch, double& yaw)
+    {
+        const Quaternion attitude = Quaternion::Slerp(Quaternion::FromEuler(fromRoll, fromPitch, fromYaw),
+            Quaternion::FromEuler(toRoll, toPitch, toYaw), fraction);
+        attitude.ToEuler(roll, pitch, yaw);
+    }
+}
+
+GpsData Interpolate(const GpsData& from, const GpsData& to, const double fraction)
+{
+    GpsData result = fraction < 0.5 ? from : to;
+
+    result.latitude = Lerp(from.latitude, to.latitude, fraction);
+    result.longitude = LerpLongitude(from.longitude, to.longitude, fraction);
+    result.altitude = Lerp(from.altitude, to.altitude, fraction);
+
+    if (from.velocityValid && to.velocityValid)
+    {
+        result.velocityNorth = Lerp(from.velocityNorth, to.velocityNorth, fraction);
+        result.velocityEast = Lerp(from.velocityEast, to.velocityEast, fraction);
+        result.velocityDown = Lerp(from.velocityDown, to.velocityDown, fraction);
+    }
+
+    return result;
+}
+
+ImuData Interpolate(const ImuData& from, const ImuData& to, const double fraction)
+{
+    ImuData result = fraction < 0.5 ? from : to;
+
+    SlerpEuler(from.roll, from.pitch, from.yaw, to.roll, to.pitch, to.yaw, fraction, result.roll, result.pitch, result.yaw);
+
+    result.gyroX = Lerp(from.gyroX, to.gyroX, fraction);
+    result.gyroY = Lerp(from.gyroY, to.gyroY, fraction);
+    result.gyroZ = Lerp(from.gyroZ, to.gyroZ, fraction);
+    result.accelX = Lerp(from.accelX, to.accelX, fraction);
+    result.accelY = Lerp(from.accelY, to.accelY, fraction);
+    result.accelZ = Lerp(from.accelZ, to.accelZ, fraction);
+    result.temperature = Lerp(from.temperature, to.temperature, fraction);
+    result.timestampNs = from.timestampNs + static_cast<int64_t>((to.timestampNs - from.timestampNs) * fraction);
+
+    return result;
+}
+
+NavigationSolution Interpolate(const NavigationSolution& from, const NavigationSolution& to, const double fraction)
+{
+    NavigationSolution result = fraction < 0.5 ? from : to;
+
+    result.latitude = Lerp(from.latitude, to.latitude, fraction);
+    result.longitude = LerpLongitude(from.longitude, to.longitude, fraction);
+    result.altitude = Lerp(from.altitude, to.altitude, fraction);
+    result.velocityNorth = Lerp(from.velocityNorth, to.velocityNorth, fraction);
+    result.velocityEast = Lerp(from.velocityEast, to.velocityEast, fraction);
+    result.velocityDown = Lerp(from.velocityDown, to.velocityDown, fraction);
+
+    SlerpEuler(from.roll, from.pitch, from.yaw, to.roll, to.pitch, to.yaw, fraction, result.roll, result.pitch, result.yaw);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        result.gyroBias[axis] = Lerp(from.gyroBias[axis], to.gyroBias[axis], fraction);
+        result.accelBias[axis] = Lerp(from.accelBias[axis], to.accelBias[axis], fraction);
+        result.positionSigma[axis] = Lerp(from.positionSigma[axis], to.positionSigma[axis], fraction);
+        result.velocitySigma[axis] = Lerp(from.velocitySigma[axis], to.velocitySigma[axis], fraction);
+        result.attitudeSigma[axis] = Lerp(from.attitudeSigma[axis], to.attitudeSigma[axis], fraction);
+    }
+    result.timestampNs = from.timestampNs + static_cast<int64_t>((to.timestampNs - from.timestampNs) * fraction);
+
+    return result;
+}
+
+SensorHistory::SensorHistory() :
+    m_gps(HISTORY_SECONDS * NS_PER_SECOND), m_imu(HISTORY_SECONDS * NS_PER_SECOND), m_navigation(HISTORY_SECONDS * NS_PER_SECOND)
+{
+}
+
+void SensorHistory::RecordGps(const GpsData& gps)
+{
+    if (gps.rxFirstByteNs == 0) return;
+    m_gps.Push(gps.rxFirstByteNs, gps);
+}
+
+void SensorHistory::RecordImu(const ImuData& imu)
+{
+    if (imu.timestampNs == 0) return;
+    m_imu.Push(imu.timestampNs, imu);
+}
+
+void SensorHistory::RecordNavigation(const NavigationSolution& navigation)
+{
+    if (!navigation.initialized || navigation.timestampNs == 0) return;
+    m_navigation.Push(navigation.timestampNs, navigation);
+}
+
+SensorSnapshot SensorHistory::Snapshot(const int64_t timeNs) const
+{
+    SensorSnapshot snapshot = {};
+    snapshot.timeNs = timeNs;
+    snapshot.gpsValid = m_gps.At(timeNs, snapshot.gps);
+    snapshot.imuValid = m_imu.At(timeNs, snapshot.imu);
+    snapshot.navValid = m_navigation.At(timeNs, snapshot.navigation);
+    return snapshot;
+}
+
+SensorSnapshot SensorHistory::LatestSnapshot() const
+{
+    TimeHistory<GpsData, 128>::Entry gps;
+    TimeHistory<ImuData, 4096>::Entry imu;
+    TimeHistory<NavigationSolution, 4096>::Entry navigation;
+
+    if (!m_gps.Latest(gps) || !m_imu.Latest(imu) || !m_navigation.Latest(navigation))
+    {
+        return {};
+    }
+
+    // the slowest stream decides how recent a consistent snapshot can be
+    return Snapshot(std::min({ gps.timeNs, imu.timeNs, navigation.timeNs }));
+}
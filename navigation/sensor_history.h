@@ -0,0 +1,83 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            sensor_history.h
+// @brief           Time aligned history of the GPS, IMU and navigation streams
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstdint>                          // standard ints
+//
+#include "../utilities/time_history.h"      // per stream history
+#include "../gps/gps_type.h"                // gps data
+#include "../imu/imu_type.h"                // imu data
+#include "nav_filter.h"                     // navigation solution
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief GPS data between two solutions. Position and velocity are linear, the rest is taken
+/// from the nearer solution.
+GpsData Interpolate(const GpsData& from, const GpsData& to, const double fraction);
+
+/// @brief IMU data between two samples. Rates and accelerations are linear, attitude is slerped.
+ImuData Interpolate(const ImuData& from, const ImuData& to, const double fraction);
+
+/// @brief Navigation solution between two epochs. Attitude is slerped, the rest is linear.
+NavigationSolution Interpolate(const NavigationSolution& from, const NavigationSolution& to, const double fraction);
+
+/// @brief Every stream at one time
+struct SensorSnapshot
+{
+    int64_t             timeNs      = 0;        // monotonic time of the snapshot
+    GpsData             gps         = {};
+    ImuData             imu         = {};
+    NavigationSolution  navigation  = {};
+    bool                gpsValid    = false;    // the time was inside the GPS history
+    bool                imuValid    = false;    // the time was inside the IMU history
+    bool                navValid    = false;    // the time was inside the navigation history
+};
+
+/// @brief Histories of the GPS, IMU and navigation streams on the MonotonicNowNs() clock. The
+/// loop that produces the data records it, fusion, telemetry and logging read consistent
+/// snapshots from any thread without holding the producer up.
+class SensorHistory
+{
+public:
+
+    /// @brief Seconds of every stream held, the capacities cover this at the highest expected rates
+    static constexpr int HISTORY_SECONDS = 5;
+
+    /// @brief Constructor
+    SensorHistory();
+
+    /// @brief Record a GPS solution, keyed on the time its first byte was read
+    /// @param gps - [in] - solution
+    void RecordGps(const GpsData& gps);
+
+    /// @brief Record an IMU sample, keyed on its sample time
+    /// @param imu - [in] - sample
+    void RecordImu(const ImuData& imu);
+
+    /// @brief Record a navigation solution, keyed on the last IMU sample it propagated
+    /// @param navigation - [in] - solution
+    void RecordNavigation(const NavigationSolution& navigation);
+
+    /// @brief Get every stream at a time
+    /// @param timeNs - [in] - monotonic time
+    /// @return snapshot, streams not covering the time are flagged invalid
+    SensorSnapshot Snapshot(const int64_t timeNs) const;
+
+    /// @brief Get every stream at the newest time all of them cover
+    /// @return snapshot, all streams invalid if one of them is empty
+    SensorSnapshot LatestSnapshot() const;
+
+private:
+
+    TimeHistory<GpsData, 128>               m_gps;          /// 5 s at 25Hz
+    TimeHistory<ImuData, 4096>              m_imu;          /// 5 s at 800Hz
+    TimeHistory<NavigationSolution, 4096>   m_navigation;   /// 5 s at 800Hz
+};
@@ -0,0 +1,79 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            aligned_buffer.h
+// @brief           Fixed size byte buffer aligned to a cache line
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // standard ints
+#include <cstring>                          // memset
+#include <new>                              // aligned new
+#include <utility>                          // exchange
+//
+#include "constants.h"                      // cache line size
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief A zeroed byte buffer whose storage starts on a cache line. Used for parser
+/// buffers so two instances never share a line and the framer scans from an aligned start.
+class AlignedBuffer
+{
+public:
+
+    /// @brief Default Constructor
+    /// @param size - [in] - buffer size in bytes
+    explicit AlignedBuffer(const size_t size = 0) : m_size(size)
+    {
+        if (m_size == 0) return;
+
+        m_data = static_cast<uint8_t*>(::operator new[](m_size, std::align_val_t(CACHE_LINE_SIZE)));
+        std::memset(m_data, 0, m_size);
+    }
+
+    /// @brief Default Deconstructor
+    ~AlignedBuffer()
+    {
+        Release();
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept :
+        m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+    {}
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Release();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    uint8_t*        Data()          { return m_data; }
+    const uint8_t*  Data() const    { return m_data; }
+    size_t          Size() const    { return m_size; }
+
+private:
+
+    /// @brief Free the storage
+    void Release()
+    {
+        if (m_data != nullptr) ::operator delete[](m_data, std::align_val_t(CACHE_LINE_SIZE));
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    uint8_t*    m_data  = nullptr;      /// Storage, CACHE_LINE_SIZE aligned
+    size_t      m_size  = 0;            /// Size in bytes
+};
@@ -0,0 +1,140 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cbor_writer.h
+// @brief           Streams CBOR (RFC 8949) into a reusable buffer without building a tree
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <string>                           // buffer
+#include <string_view>                      // text
+#include <cstring>                          // memcpy
+#include <cmath>                            // isnan
+#include <cstdint>                          // standard ints
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Appends CBOR to a caller owned byte buffer. Maps and arrays are definite length, so
+/// the item count is given when one is opened. Numbers take the shortest encoding that holds
+/// them exactly, a double that survives a round trip through float is sent as 4 bytes.
+class CborWriter
+{
+public:
+
+    /// @brief Constructor
+    /// @param buffer - [in] - buffer to append to, cleared by Reset()
+    explicit CborWriter(std::string& buffer) : m_buffer(buffer) {}
+
+    /// @brief Clear the buffer for a new message, keeping its capacity
+    void Reset() { m_buffer.clear(); }
+
+    /// @brief Open a map, followed by count key and value pairs
+    /// @param count - [in] - pairs in the map
+    CborWriter& BeginMap(const uint64_t count)      { Head(MAP, count); return *this; }
+
+    /// @brief Open an array, followed by count values
+    /// @param count - [in] - values in the array
+    CborWriter& BeginArray(const uint64_t count)    { Head(ARRAY, count); return *this; }
+
+    /// @brief Write an integer, also used for map keys
+    /// @param value - [in] - value
+    CborWriter& Integer(const int64_t value)
+    {
+        if (value >= 0) Head(UNSIGNED, static_cast<uint64_t>(value));
+        else            Head(NEGATIVE, static_cast<uint64_t>(-(value + 1)));
+        return *this;
+    }
+
+    /// @brief Write a floating point number
+    /// @param value - [in] - value
+    CborWriter& Number(const double value)
+    {
+        const float single = static_cast<float>(value);
+        if (std::isnan(value) || static_cast<double>(single) == value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &single, sizeof(bits));
+            m_buffer += static_cast<char>(SIMPLE | 26);
+            Big(bits, 4);
+        }
+        else
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            m_buffer += static_cast<char>(SIMPLE | 27);
+            Big(bits, 8);
+        }
+        return *this;
+    }
+
+    /// @brief Write a bool
+    /// @param value - [in] - value
+    CborWriter& Bool(const bool value)
+    {
+        m_buffer += static_cast<char>(SIMPLE | (value ? 21 : 20));
+        return *this;
+    }
+
+    /// @brief Write a UTF-8 string
+    /// @param text - [in] - value
+    CborWriter& String(std::string_view text)
+    {
+        Head(TEXT, text.size());
+        m_buffer += text;
+        return *this;
+    }
+
+private:
+
+    /// @brief Major types, in the top three bits of the first byte
+    static constexpr uint8_t UNSIGNED   = 0 << 5;
+    static constexpr uint8_t NEGATIVE   = 1 << 5;
+    static constexpr uint8_t TEXT       = 3 << 5;
+    static constexpr uint8_t ARRAY      = 4 << 5;
+    static constexpr uint8_t MAP        = 5 << 5;
+    static constexpr uint8_t SIMPLE     = 7 << 5;
+
+    /// @brief Write a major type with its argument in the fewest bytes
+    void Head(const uint8_t major, const uint64_t value)
+    {
+        if (value < 24)
+        {
+            m_buffer += static_cast<char>(major | value);
+        }
+        else if (value <= 0xFF)
+        {
+            m_buffer += static_cast<char>(major | 24);
+            Big(value, 1);
+        }
+        else if (value <= 0xFFFF)
+        {
+            m_buffer += static_cast<char>(major | 25);
+            Big(value, 2);
+        }
+        else if (value <= 0xFFFFFFFF)
+        {
+            m_buffer += static_cast<char>(major | 26);
+            Big(value, 4);
+        }
+        else
+        {
+            m_buffer += static_cast<char>(major | 27);
+            Big(value, 8);
+        }
+    }
+
+    /// @brief Write the low bytes of a value, network order
+    void Big(const uint64_t value, const int bytes)
+    {
+        for (int i = bytes - 1; i >= 0; i--)
+        {
+            m_buffer += static_cast<char>((value >> (i * 8)) & 0xFF);
+        }
+    }
+
+    std::string&    m_buffer;       /// Message being written
+};
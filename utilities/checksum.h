@@ -0,0 +1,114 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            checksum.h
+// @brief           Checksum helpers shared by the protocol parsers
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <array>                            // crc tables
+#include <cstddef>                          // size_t
+#include <cstdint>                          // standard ints
+#include <cstring>                          // memcpy
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Unsigned 16-bit sum of a run of bytes. Eight bytes are summed per step by splitting
+/// a word into four 16-bit lanes, the lanes are folded often enough that none can carry.
+/// @param data - [in] - bytes to sum
+/// @param length - [in] - number of bytes
+/// @return sum of the bytes modulo 2^16
+inline uint16_t ByteSum16(const uint8_t* data, const size_t length)
+{
+    constexpr uint64_t EVEN_BYTES = 0x00FF00FF00FF00FFULL;
+    constexpr size_t MAX_WORDS_PER_FOLD = 128;      // 128 * 2 * 255 fits a 16-bit lane
+
+    uint32_t sum = 0;
+    size_t i = 0;
+
+    while (length - i >= sizeof(uint64_t))
+    {
+        uint64_t lanes = 0;
+        for (size_t words = 0; words < MAX_WORDS_PER_FOLD && length - i >= sizeof(uint64_t); words++, i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            lanes += (word & EVEN_BYTES) + ((word >> 8) & EVEN_BYTES);
+        }
+
+        sum += static_cast<uint32_t>((lanes & 0xFFFF) + ((lanes >> 16) & 0xFFFF) + ((lanes >> 32) & 0xFFFF) + (lanes >> 48));
+    }
+
+    for (; i < length; i++)
+    {
+        sum += data[i];
+    }
+
+    return static_cast<uint16_t>(sum);
+}
+
+/// @brief Builds the slice-by-8 tables for the reflected CRC-32 polynomial 0xEDB88320.
+/// Table 0 is the classic byte table, table n advances a byte n further through zeros.
+/// @return eight 256 entry tables
+constexpr std::array<std::array<uint32_t, 256>, 8> MakeCrc32Tables()
+{
+    std::array<std::array<uint32_t, 256>, 8> tables = {};
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : (crc >> 1);
+        }
+        tables[0][i] = crc;
+    }
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (size_t slice = 1; slice < tables.size(); slice++)
+        {
+            tables[slice][i] = (tables[slice - 1][i] >> 8) ^ tables[0][tables[slice - 1][i] & 0xFF];
+        }
+    }
+
+    return tables;
+}
+
+/// @brief CRC-32 lookup tables, built at compile time
+inline constexpr std::array<std::array<uint32_t, 256>, 8> CRC32_TABLES = MakeCrc32Tables();
+
+/// @brief Reflected CRC-32 (polynomial 0xEDB88320) without the final inversion, eight bytes per
+/// step. A zero seed gives the NovAtel OEM CRC, a 0xFFFFFFFF seed and an inverted result gives zlib's.
+/// @param data - [in] - bytes to run through the crc
+/// @param length - [in] - number of bytes
+/// @param crc - [in/opt] - seed, or the result of a previous call to continue it
+/// @return crc of the bytes
+inline uint32_t Crc32(const uint8_t* data, const size_t length, uint32_t crc = 0)
+{
+    const auto& t = CRC32_TABLES;
+    size_t i = 0;
+
+    for (; length - i >= 8; i += 8)
+    {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, data + i, sizeof(low));
+        std::memcpy(&high, data + i + 4, sizeof(high));
+        low ^= crc;
+
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    }
+
+    for (; i < length; i++)
+    {
+        crc = t[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
@@ -58,6 +58,7 @@ constexpr int CM_TO_MM  = 10;
 constexpr int MM_TO_M   = 1000;
 
 constexpr int BUFFER_SIZE       = 1024;
+constexpr int CACHE_LINE_SIZE   = 64;
 constexpr int WEB_BUFFER_SIZE   = 50;
 constexpr int AUTO_DISCOVERY_TIMEOUT_SECS = 10;
 
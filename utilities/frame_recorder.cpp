@@ -0,0 +1,166 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            frame_recorder.cpp
+// @brief           Implementation for the raw frame recorder
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstring>                          // memcpy
+#include <chrono>                           // writer period
+//
+#include "frame_recorder.h"                 // header
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+FrameRecorder::FrameRecorder(const size_t bufferBytes) : m_bufferBytes(bufferBytes)
+{
+    m_front.data.resize(m_bufferBytes);
+    m_back.data.resize(m_bufferBytes);
+
+    // enough index records for a buffer of the smallest frames, Record() never allocates
+    m_front.index.resize(m_bufferBytes / MIN_FRAME_LENGTH + 1);
+    m_back.index.resize(m_bufferBytes / MIN_FRAME_LENGTH + 1);
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    Close();
+}
+
+bool FrameRecorder::Open(const std::string& path)
+{
+    if (m_open) return true;
+    if (path.empty()) return false;
+
+    m_dataFile.open(path + ".bin", std::ios::binary | std::ios::app);
+    m_indexFile.open(path + ".idx", std::ios::binary | std::ios::app);
+
+    if (!m_dataFile.is_open() || !m_indexFile.is_open())
+    {
+        m_dataFile.close();
+        m_indexFile.close();
+        return false;
+    }
+
+    // appending continues the offsets of an existing recording
+    m_dataFile.seekp(0, std::ios::end);
+    m_fileOffset = static_cast<uint64_t>(m_dataFile.tellp());
+
+    m_open = true;
+    m_writer = std::thread(&FrameRecorder::WriterLoop, this);
+    return true;
+}
+
+void FrameRecorder::Close()
+{
+    if (!m_open) return;
+
+    m_open = false;
+    m_wake.notify_one();
+    if (m_writer.joinable()) m_writer.join();
+
+    m_dataFile.close();
+    m_indexFile.close();
+}
+
+bool FrameRecorder::Record(const uint8_t* frame, const uint32_t length, const uint8_t classId, const uint8_t messageId, const int64_t rxTimeNs)
+{
+    if (!m_open) return false;
+
+    bool wakeWriter = false;
+    {
+        std::scoped_lock lock(m_stagingMutex);
+
+        if (m_front.used + length > m_front.data.size() || m_front.frames == m_front.index.size())
+        {
+            m_framesDropped++;
+            m_wake.notify_one();
+            return false;
+        }
+
+        std::memcpy(&m_front.data[m_front.used], frame, length);
+        m_front.index[m_front.frames++] = { m_front.used, length, classId, messageId, 0, rxTimeNs };
+        m_front.used += length;
+
+        // past half full, don't wait on the writer period
+        wakeWriter = m_front.used > m_front.data.size() / 2;
+    }
+
+    if (wakeWriter) m_wake.notify_one();
+    return true;
+}
+
+FrameRecorder::Stats FrameRecorder::GetStats() const
+{
+    Stats stats = {};
+    stats.framesRecorded = m_framesRecorded;
+    stats.bytesRecorded = m_bytesRecorded;
+    stats.framesDropped = m_framesDropped;
+    stats.writeErrors = m_writeErrors;
+    return stats;
+}
+
+void FrameRecorder::WriterLoop()
+{
+    while (true)
+    {
+        bool open = true;
+        {
+            std::unique_lock lock(m_stagingMutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(50));
+
+            // the back buffer is empty here, swapping is all the receive side waits on
+            std::swap(m_front, m_back);
+            open = m_open;
+        }
+
+        WriteStaging(m_back);
+
+        // closing - drain whatever was staged before the flag dropped
+        if (!open)
+        {
+            std::scoped_lock lock(m_stagingMutex);
+            std::swap(m_front, m_back);
+            WriteStaging(m_back);
+            break;
+        }
+    }
+
+    m_dataFile.flush();
+    m_indexFile.flush();
+}
+
+void FrameRecorder::WriteStaging(Staging& staging)
+{
+    if (staging.used == 0) return;
+
+    // rebase the buffer offsets onto the data file
+    for (size_t i = 0; i < staging.frames; i++)
+    {
+        staging.index[i].offset += m_fileOffset;
+    }
+
+    m_dataFile.write(reinterpret_cast<const char*>(staging.data.data()), staging.used);
+    m_indexFile.write(reinterpret_cast<const char*>(staging.index.data()), staging.frames * sizeof(IndexEntry));
+
+    if (!m_dataFile || !m_indexFile)
+    {
+        m_writeErrors++;
+        m_dataFile.clear();
+        m_indexFile.clear();
+    }
+    else
+    {
+        m_framesRecorded += staging.frames;
+        m_bytesRecorded += staging.used;
+    }
+
+    m_fileOffset += staging.used;
+    staging.used = 0;
+    staging.frames = 0;
+}
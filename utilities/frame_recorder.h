@@ -0,0 +1,123 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            frame_recorder.h
+// @brief           Append only recorder for raw protocol frames with an index
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <string>                           // strings
+#include <vector>                           // buffers
+#include <fstream>                          // file io
+#include <mutex>                            // mutex
+#include <condition_variable>               // writer wake up
+#include <thread>                           // writer thread
+#include <atomic>                           // counters
+#include <cstdint>                          // standard ints
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Records whole frames to "<path>.bin" and an index of them to "<path>.idx". The caller
+/// only copies the frame into a staging buffer, a writer thread owns all of the file io.
+/// Frames that do not fit while the writer is behind are dropped and counted.
+class FrameRecorder
+{
+public:
+
+#pragma pack(push, 1)
+    /// @brief One index record per frame in the data file
+    struct IndexEntry
+    {
+        uint64_t    offset;             // offset of the frame in the data file
+        uint32_t    length;             // frame length in bytes
+        uint8_t     classId;            // protocol class of the frame
+        uint8_t     messageId;          // protocol message id of the frame
+        uint16_t    reserved;
+        int64_t     rxTimeNs;           // monotonic time the first byte was read
+    };
+#pragma pack(pop)
+
+    /// @brief Recorder statistics
+    struct Stats
+    {
+        uint64_t    framesRecorded      = 0;    // frames written to disk
+        uint64_t    bytesRecorded       = 0;    // frame bytes written to disk
+        uint64_t    framesDropped       = 0;    // frames lost to a full staging buffer or index
+        uint64_t    writeErrors         = 0;    // failed file writes
+    };
+
+    /// @brief Default Constructor
+    /// @param bufferBytes - [in/opt] - size of each of the two staging buffers
+    FrameRecorder(const size_t bufferBytes = 512 * 1024);
+
+    /// @brief Default Deconstructor
+    ~FrameRecorder();
+
+    /// @brief Open the data and index files and start the writer
+    /// @param path - [in] - path without extension for the recording
+    /// @return true if the files were opened, else false
+    bool Open(const std::string& path);
+
+    /// @brief Flush what is staged, stop the writer and close the files
+    void Close();
+
+    /// @brief Check if the recorder is open
+    /// @return true if recording, else false
+    bool IsOpen() const { return m_open; }
+
+    /// @brief Stage a frame for recording. Safe to call from the receive thread.
+    /// @param frame - [in] - pointer to the whole frame
+    /// @param length - [in] - frame length in bytes
+    /// @param classId - [in] - protocol class of the frame
+    /// @param messageId - [in] - protocol message id of the frame
+    /// @param rxTimeNs - [in] - monotonic time the first byte was read
+    /// @return true if staged, false if dropped
+    bool Record(const uint8_t* frame, const uint32_t length, const uint8_t classId, const uint8_t messageId, const int64_t rxTimeNs);
+
+    /// @brief Get the recorder statistics
+    /// @return copy of the statistics
+    Stats GetStats() const;
+
+protected:
+
+private:
+
+    /// @brief Smallest frame recorded, a UBX header and checksum with no payload
+    static constexpr size_t MIN_FRAME_LENGTH = 8;
+
+    /// @brief Staging area for frames and their index records, both sized up front
+    struct Staging
+    {
+        std::vector<uint8_t>    data;
+        std::vector<IndexEntry> index;
+        size_t                  used    = 0;        // data bytes staged
+        size_t                  frames  = 0;        // index records staged
+    };
+
+    /// @brief Writer loop, swaps the staging buffers and writes the back one to disk
+    void WriterLoop();
+
+    /// @brief Write a staging buffer to the files
+    /// @param staging - [in] - buffer to write, emptied on return
+    void WriteStaging(Staging& staging);
+
+    size_t                      m_bufferBytes       = 0;        /// Capacity of each staging buffer
+    Staging                     m_front             = {};       /// Filled by Record()
+    Staging                     m_back              = {};       /// Drained by the writer
+    std::mutex                  m_stagingMutex      = {};       /// Protects m_front and the swap
+    std::condition_variable     m_wake              = {};       /// Wakes the writer early
+    std::thread                 m_writer;                       /// Writer thread
+    std::atomic_bool            m_open              = false;    /// Flag for if recording
+    std::ofstream               m_dataFile;                     /// Frame data
+    std::ofstream               m_indexFile;                    /// Frame index
+    uint64_t                    m_fileOffset        = 0;        /// Next offset in the data file
+
+    std::atomic<uint64_t>       m_framesRecorded    = 0;        /// Stats
+    std::atomic<uint64_t>       m_bytesRecorded     = 0;
+    std::atomic<uint64_t>       m_framesDropped     = 0;
+    std::atomic<uint64_t>       m_writeErrors       = 0;
+};
@@ -0,0 +1,274 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            gpio_interface.cpp
+// @brief           implementation of GPIO class
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                    reason included
+//          ------------------      ------------------------
+#include    <cstring>               // memset, strncpy
+#include    <cerrno>                // errno
+#include    <algorithm>             // min
+#ifdef __linux__
+#include    <fcntl.h>               // open
+#include    <unistd.h>              // read, close
+#include    <poll.h>                // poll
+#include    <sys/ioctl.h>           // ioctl
+#include    <linux/gpio.h>          // v2 uAPI
+#endif
+//
+#include    "gpio_interface.h"      // GPIO header
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+namespace
+{
+    constexpr size_t EVENT_READ_BATCH = 16;     // edges taken from the kernel per read
+
+    /// @brief Kernel flags for a line
+    uint64_t LineFlags(const GPIO::LineConfig& line)
+    {
+        uint64_t flags = line.activeLow ? GPIO_V2_LINE_FLAG_ACTIVE_LOW : 0;
+        if (line.direction == GPIO::GPIODirection::Output) return flags | GPIO_V2_LINE_FLAG_OUTPUT;
+
+        flags |= GPIO_V2_LINE_FLAG_INPUT;
+        if (line.edge == GPIO::GPIOEdge::Rising || line.edge == GPIO::GPIOEdge::Both)   flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+        if (line.edge == GPIO::GPIOEdge::Falling || line.edge == GPIO::GPIOEdge::Both)  flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        return flags;
+    }
+
+    /// @brief Add an attribute for the lines in mask, false if the request is full
+    bool AddAttribute(gpio_v2_line_config& config, const gpio_v2_line_attribute& attribute, const uint64_t mask)
+    {
+        if (config.num_attrs >= GPIO_V2_LINE_NUM_ATTRS_MAX) return false;
+
+        config.attrs[config.num_attrs].attr = attribute;
+        config.attrs[config.num_attrs].mask = mask;
+        config.num_attrs++;
+        return true;
+    }
+}
+#endif
+
+GPIO::~GPIO()
+{
+    ReleaseLines();
+}
+
+GPIO::GPIOStatus GPIO::RequestLines(const std::string& chipPath, const std::vector<LineConfig>& lines, const std::string& consumer)
+{
+    ReleaseLines();
+
+    if (lines.empty() || lines.size() > MAX_LINES) { return GPIOStatus::InvalidInput; }
+
+#ifdef __linux__
+    gpio_v2_line_request request;
+    std::memset(&request, 0, sizeof(request));
+    std::strncpy(request.consumer, consumer.c_str(), sizeof(request.consumer) - 1);
+    request.num_lines = static_cast<uint32_t>(lines.size());
+
+    // The first line's flags are the default, every other distinct set of flags or debounce
+    // period is one attribute covering the lines that use it
+    request.config.flags = LineFlags(lines[0]);
+
+    uint64_t handled = 1;
+    uint64_t outputMask = 0;
+    uint64_t outputValues = 0;
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        request.offsets[i] = lines[i].offset;
+
+        if (lines[i].direction == GPIODirection::Output)
+        {
+            outputMask |= 1ULL << i;
+            if (lines[i].initialValue) outputValues |= 1ULL << i;
+        }
+
+        if (handled & (1ULL << i)) continue;
+
+        const uint64_t flags = LineFlags(lines[i]);
+        uint64_t mask = 0;
+        for (size_t j = i; j < lines.size(); j++)
+        {
+            if (LineFlags(lines[j]) == flags) mask |= 1ULL << j;
+        }
+        handled |= mask;
+
+        if (flags == request.config.flags) continue;
+
+        gpio_v2_line_attribute attribute = {};
+        attribute.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        attribute.flags = flags;
+        if (!AddAttribute(request.config, attribute, mask)) { return GPIOStatus::InvalidInput; }
+    }
+
+    if (outputMask != 0)
+    {
+        gpio_v2_line_attribute attribute = {};
+        attribute.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        attribute.values = outputValues;
+        if (!AddAttribute(request.config, attribute, outputMask)) { return GPIOStatus::InvalidInput; }
+    }
+
+    uint64_t debounced = 0;
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        if (lines[i].debounceUs == 0 || (debounced & (1ULL << i))) continue;
+
+        uint64_t mask = 0;
+        for (size_t j = i; j < lines.size(); j++)
+        {
+            if (lines[j].debounceUs == lines[i].debounceUs) mask |= 1ULL << j;
+        }
+        debounced |= mask;
+
+        gpio_v2_line_attribute attribute = {};
+        attribute.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+        attribute.debounce_period_us = lines[i].debounceUs;
+        if (!AddAttribute(request.config, attribute, mask)) { return GPIOStatus::InvalidInput; }
+    }
+
+    const int chip = open(chipPath.c_str(), O_RDWR | O_CLOEXEC);
+    if (chip < 0) { return GPIOStatus::Error; }
+
+    const int rtn = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &request);
+    close(chip);
+    if (rtn < 0 || request.fd < 0) { return GPIOStatus::Error; }
+
+    // Edges are taken from the event loop, a read with nothing queued must not block it
+    const int fileFlags = fcntl(request.fd, F_GETFL);
+    if (fileFlags < 0 || fcntl(request.fd, F_SETFL, fileFlags | O_NONBLOCK) < 0)
+    {
+        close(request.fd);
+        return GPIOStatus::Error;
+    }
+
+    m_fd = request.fd;
+    m_offsets.clear();
+    for (const LineConfig& line : lines) m_offsets.push_back(line.offset);
+
+    return GPIOStatus::Success;
+#else
+    return GPIOStatus::Error;
+#endif
+}
+
+void GPIO::ReleaseLines()
+{
+#ifdef __linux__
+    if (m_fd >= 0) close(m_fd);
+#endif
+    m_fd = -1;
+    m_offsets.clear();
+}
+
+GPIO::GPIOStatus GPIO::SetValues(const uint64_t values, const uint64_t mask)
+{
+    if (m_fd < 0) { return GPIOStatus::NotRequested; }
+
+#ifdef __linux__
+    gpio_v2_line_values request = {};
+    request.bits = values;
+    request.mask = mask;
+    if (ioctl(m_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &request) < 0) { return GPIOStatus::Error; }
+
+    return GPIOStatus::Success;
+#else
+    return GPIOStatus::Error;
+#endif
+}
+
+GPIO::GPIOStatus GPIO::GetValues(uint64_t& values, const uint64_t mask)
+{
+    if (m_fd < 0) { return GPIOStatus::NotRequested; }
+
+#ifdef __linux__
+    // The kernel rejects mask bits past the lines requested
+    const uint64_t held = m_offsets.size() >= 64 ? ~0ULL : (1ULL << m_offsets.size()) - 1;
+
+    gpio_v2_line_values request = {};
+    request.mask = mask & held;
+    if (ioctl(m_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &request) < 0) { return GPIOStatus::Error; }
+
+    values = request.bits;
+    return GPIOStatus::Success;
+#else
+    return GPIOStatus::Error;
+#endif
+}
+
+GPIO::GPIOStatus GPIO::SetValue(const size_t line, const bool value)
+{
+    if (line >= m_offsets.size()) { return m_fd < 0 ? GPIOStatus::NotRequested : GPIOStatus::InvalidInput; }
+
+    return SetValues(value ? 1ULL << line : 0, 1ULL << line);
+}
+
+GPIO::GPIOStatus GPIO::GetValue(const size_t line, bool& value)
+{
+    if (line >= m_offsets.size()) { return m_fd < 0 ? GPIOStatus::NotRequested : GPIOStatus::InvalidInput; }
+
+    uint64_t values = 0;
+    const GPIOStatus status = GetValues(values, 1ULL << line);
+    if (status == GPIOStatus::Success) value = (values >> line) & 1;
+    return status;
+}
+
+bool GPIO::WaitForEvents(const int timeoutMs)
+{
+    if (m_fd < 0) return false;
+
+#ifdef __linux__
+    pollfd descriptor = {};
+    descriptor.fd = m_fd;
+    descriptor.events = POLLIN;
+    return poll(&descriptor, 1, timeoutMs) > 0 && (descriptor.revents & POLLIN);
+#else
+    return false;
+#endif
+}
+
+int GPIO::ReadEvents(Event* events, const size_t maxEvents)
+{
+    if (m_fd < 0) return -1;
+
+#ifdef __linux__
+    gpio_v2_line_event raw[EVENT_READ_BATCH];
+    size_t count = 0;
+    while (count < maxEvents)
+    {
+        const size_t want = std::min(maxEvents - count, EVENT_READ_BATCH);
+        const ssize_t rtn = read(m_fd, raw, want * sizeof(gpio_v2_line_event));
+        if (rtn < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return count > 0 ? static_cast<int>(count) : -1;
+        }
+
+        const size_t taken = static_cast<size_t>(rtn) / sizeof(gpio_v2_line_event);
+        for (size_t i = 0; i < taken; i++)
+        {
+            Event& event = events[count++];
+            event.timeNs = static_cast<int64_t>(raw[i].timestamp_ns);
+            event.offset = raw[i].offset;
+            event.edge = raw[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE ? GPIOEdge::Rising : GPIOEdge::Falling;
+            event.sequence = raw[i].line_seqno;
+            event.line = -1;
+            for (size_t line = 0; line < m_offsets.size(); line++)
+            {
+                if (m_offsets[line] == raw[i].offset) { event.line = static_cast<int>(line); break; }
+            }
+        }
+
+        if (taken < want) break;
+    }
+
+    return static_cast<int>(count);
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,149 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            gpio_interface.h
+// @brief           Class to interface with gpio lines through the gpio character device
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                    reason included
+//          ------------------      ------------------------
+#include <string>                   // strings
+#include <vector>                   // line configs
+#include <cstdint>                  // standard ints
+//
+#include "topic.h"                  // event topic
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief A set of lines on one gpio chip, requested together through the v2 character device
+/// uAPI. Every line is read or written in a single ioctl, and input lines can report edges
+/// with the kernel's monotonic timestamp, the same clock as MonotonicNowNs().
+class GPIO
+{
+public:
+    /// @brief enum for status returns
+    enum class GPIOStatus
+    {
+        Success,
+        Error,
+        NotRequested,
+        InvalidInput,
+    };
+
+    /// @brief enum for line directions
+    enum class GPIODirection
+    {
+        Input,
+        Output,
+    };
+
+    /// @brief enum for the edges an input line reports
+    enum class GPIOEdge
+    {
+        None,
+        Rising,
+        Falling,
+        Both,
+    };
+
+    /// @brief Configuration of one line in a request
+    struct LineConfig
+    {
+        unsigned        offset          = 0;                        // line on the chip
+        GPIODirection   direction       = GPIODirection::Input;
+        GPIOEdge        edge            = GPIOEdge::None;           // inputs only
+        bool            activeLow       = false;                    // values are inverted at the pin
+        bool            initialValue    = false;                    // outputs only, driven on request
+        uint32_t        debounceUs      = 0;                        // inputs only, 0 for none
+    };
+
+    /// @brief An edge seen on an input line
+    struct Event
+    {
+        int64_t         timeNs          = 0;                        // kernel monotonic time of the edge
+        int             line            = -1;                       // index of the line in the request
+        unsigned        offset          = 0;                        // line on the chip
+        GPIOEdge        edge            = GPIOEdge::None;           // Rising or Falling
+        uint32_t        sequence        = 0;                        // per line, a gap means the kernel dropped edges
+    };
+
+    /// @brief Maximum lines in one request, bit n of a value or mask is line n of the request
+    static constexpr size_t MAX_LINES = 64;
+
+    /// @brief Constructor
+    GPIO() = default;
+
+    /// @brief Deconstructor, releases the lines
+    ~GPIO();
+
+    /// @brief Owns the line file descriptor, not copyable
+    GPIO(const GPIO&) = delete;
+    GPIO& operator=(const GPIO&) = delete;
+
+    /// @brief - Request lines, releasing any held
+    /// @param chipPath - Path to the chip, typically "/dev/gpiochipX"
+    /// @param lines - lines to request, at most MAX_LINES
+    /// @param consumer - [opt] - name shown against the lines by the kernel
+    /// @return - GPIOStatus::Success if every line was requested, GPIOStatus::InvalidInput if the lines cannot be expressed in one request, else GPIOStatus::Error
+    GPIOStatus RequestLines(const std::string& chipPath, const std::vector<LineConfig>& lines, const std::string& consumer = "wasp");
+
+    /// @brief - Release the lines
+    void ReleaseLines();
+
+    /// @brief - Check if lines are held
+    /// @return - true if requested, else false
+    bool IsRequested() const { return m_fd >= 0; }
+
+    /// @brief - Get the number of lines held
+    /// @return - lines in the request
+    size_t GetLineCount() const { return m_offsets.size(); }
+
+    /// @brief - Set many output lines in one ioctl
+    /// @param values - bit per line, logical value
+    /// @param mask - bit per line to set, others are untouched
+    /// @return - GPIOStatus::Success if set, GPIOStatus::NotRequested if no lines are held, else GPIOStatus::Error
+    GPIOStatus SetValues(const uint64_t values, const uint64_t mask);
+
+    /// @brief - Read many lines in one ioctl
+    /// @param values - output variable for return, bit per line
+    /// @param mask - [opt] - bit per line to read
+    /// @return - GPIOStatus::Success if read, GPIOStatus::NotRequested if no lines are held, else GPIOStatus::Error
+    GPIOStatus GetValues(uint64_t& values, const uint64_t mask = ~0ULL);
+
+    /// @brief - Set one output line
+    /// @param line - index of the line in the request
+    /// @param value - logical value
+    /// @return - GPIOStatus::InvalidInput if the line is not in the request, else as SetValues()
+    GPIOStatus SetValue(const size_t line, const bool value);
+
+    /// @brief - Read one line
+    /// @param line - index of the line in the request
+    /// @param value - output variable for return
+    /// @return - GPIOStatus::InvalidInput if the line is not in the request, else as GetValues()
+    GPIOStatus GetValue(const size_t line, bool& value);
+
+    /// @brief - Get the descriptor that becomes readable when edges are queued, for an event loop's poll
+    /// @return - file descriptor, -1 if no lines are held
+    int GetEventFd() const { return m_fd; }
+
+    /// @brief - Block until edges are queued
+    /// @param timeoutMs - wait limit, 0 to check and return, -1 for no limit
+    /// @return - true if edges are queued, else false
+    bool WaitForEvents(const int timeoutMs);
+
+    /// @brief - Take the queued edges without blocking
+    /// @param events - output array for return
+    /// @param maxEvents - size of events
+    /// @return - number of edges taken, 0 if none are queued, -1 on error
+    int ReadEvents(Event* events, const size_t maxEvents);
+
+private:
+    int                     m_fd = -1;          // line request file descriptor, -1 when released
+    std::vector<unsigned>   m_offsets;          // chip line of each request index
+};
+
+/// @brief Edges from the discrete input lines
+using DiscreteTopic = Topic<GPIO::Event, 64>;
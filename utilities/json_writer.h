@@ -0,0 +1,167 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            json_writer.h
+// @brief           Streams JSON text into a reusable buffer without building a tree
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <string>                           // buffer
+#include <string_view>                      // keys and text
+#include <charconv>                         // to_chars
+#include <cmath>                            // isfinite
+#include <cstdint>                          // standard ints
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Appends JSON to a caller owned buffer. Commas are placed from the nesting, so a
+/// message is written as a sequence of calls with no intermediate objects. Once the buffer
+/// has grown to the largest message nothing allocates. Non finite numbers are written as null.
+class JsonWriter
+{
+public:
+
+    /// @brief Deepest nesting of objects and arrays
+    static constexpr int MAX_DEPTH = 16;
+
+    /// @brief Constructor
+    /// @param buffer - [in] - buffer to append to, cleared by Reset()
+    explicit JsonWriter(std::string& buffer) : m_buffer(buffer) {}
+
+    /// @brief Clear the buffer for a new message, keeping its capacity
+    void Reset()
+    {
+        m_buffer.clear();
+        m_depth = 0;
+        m_first[0] = true;
+    }
+
+    /// @brief Open an object, as a value or at the top level
+    JsonWriter& BeginObject()   { Separate(); m_buffer += '{'; Push(); return *this; }
+
+    /// @brief Close the innermost object
+    JsonWriter& EndObject()     { Pop(); m_buffer += '}'; return *this; }
+
+    /// @brief Open an array, as a value or at the top level
+    JsonWriter& BeginArray()    { Separate(); m_buffer += '['; Push(); return *this; }
+
+    /// @brief Close the innermost array
+    JsonWriter& EndArray()      { Pop(); m_buffer += ']'; return *this; }
+
+    /// @brief Write a key, the next call writes its value
+    /// @param key - [in] - key, written without escaping
+    JsonWriter& Key(std::string_view key)
+    {
+        Separate();
+        m_buffer += '"';
+        m_buffer += key;
+        m_buffer += "\":";
+        m_afterKey = true;
+        return *this;
+    }
+
+    /// @brief Write a number, shortest text that reads back to the same double
+    /// @param value - [in] - value
+    JsonWriter& Number(const double value)
+    {
+        Separate();
+        if (!std::isfinite(value))
+        {
+            m_buffer += "null";
+            return *this;
+        }
+
+        char text[32];
+        const std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+        m_buffer.append(text, result.ptr);
+        return *this;
+    }
+
+    /// @brief Write an integer
+    /// @param value - [in] - value
+    JsonWriter& Integer(const int64_t value)
+    {
+        Separate();
+        char text[24];
+        const std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+        m_buffer.append(text, result.ptr);
+        return *this;
+    }
+
+    /// @brief Write a bool
+    /// @param value - [in] - value
+    JsonWriter& Bool(const bool value)
+    {
+        Separate();
+        m_buffer += value ? "true" : "false";
+        return *this;
+    }
+
+    /// @brief Write a string, escaped
+    /// @param text - [in] - value
+    JsonWriter& String(std::string_view text)
+    {
+        Separate();
+        m_buffer += '"';
+        for (const char c : text)
+        {
+            switch (c)
+            {
+            case '"':   m_buffer += "\\\""; break;
+            case '\\':  m_buffer += "\\\\"; break;
+            case '\n':  m_buffer += "\\n";  break;
+            case '\r':  m_buffer += "\\r";  break;
+            case '\t':  m_buffer += "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    static constexpr char HEX[] = "0123456789abcdef";
+                    m_buffer += "\\u00";
+                    m_buffer += HEX[(c >> 4) & 0xF];
+                    m_buffer += HEX[c & 0xF];
+                }
+                else
+                {
+                    m_buffer += c;
+                }
+            }
+        }
+        m_buffer += '"';
+        return *this;
+    }
+
+private:
+
+    /// @brief Write the comma before a value or key when it is not the first in its container
+    void Separate()
+    {
+        if (m_afterKey)
+        {
+            m_afterKey = false;
+            return;
+        }
+
+        if (!m_first[m_depth]) m_buffer += ',';
+        m_first[m_depth] = false;
+    }
+
+    void Push()
+    {
+        if (m_depth + 1 < MAX_DEPTH) m_depth++;
+        m_first[m_depth] = true;
+    }
+
+    void Pop()
+    {
+        if (m_depth > 0) m_depth--;
+    }
+
+    std::string&    m_buffer;                   /// Message being written
+    int             m_depth     = 0;            /// Current nesting
+    bool            m_first[MAX_DEPTH] = { true };  /// Nothing written yet at each depth
+    bool            m_afterKey  = false;        /// A key was just written
+};
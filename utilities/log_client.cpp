@@ -29,6 +29,8 @@ void LogClient::AddLog(const std::string& name, const LogLevel level, const std:
         return;
     }
 
+    // Several threads log at once, the queue is shared with Run()
+    std::scoped_lock lock(mQueueMutex);
     mLogQueue.push({ 0, level, CreateLogString(name, LogLevelToStringMap.at(level), message) });
 }
 
@@ -67,6 +69,12 @@ bool LogClient::EnableFileLogging(const std::string& filename)
     return true;
 }
 
+void LogClient::SetForward(std::function<void(const LogLevel, const std::string&)> forward)
+{
+    std::scoped_lock lock(mQueueMutex);
+    mForward = std::move(forward);
+}
+
 void LogClient::Run()
 {
     mRun = true;
@@ -80,6 +88,7 @@ void LogClient::Run()
 
             LogItem log = mLogQueue.front();
             WriteLog(log);
+            if (mForward) mForward(log.level, log.message);
             mLogQueue.pop();
         }
 
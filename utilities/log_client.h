@@ -18,6 +18,7 @@
 #include <queue>                            // queue
 #include <mutex>                            // mutex
 #include <map>
+#include <functional>                       // forward callback
 //
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -57,6 +58,11 @@ public:
     /// @return true if logging enabled and file opened/created successfully.
     bool EnableFileLogging(const std::string& filename);
 
+    /// @brief Hand every log to a callback as well once it is written, from the Run() thread.
+    /// Set before Run() starts.
+    /// @param forward - [in] - callback taking the level and the formatted log, empty for none
+    void SetForward(std::function<void(const LogLevel, const std::string&)> forward);
+
     /// @brief Main working loop to log items. BLOCKING. Meant to be called in a thread.
     void Run();
 
@@ -92,6 +98,7 @@ private:
     bool mFileLoggingEnabled;       /// flag for file logging being enabled
     std::ofstream mLogFile;         /// filestream for the log file
     std::atomic_bool mRun;          /// bool for a run flag
+    std::function<void(const LogLevel, const std::string&)> mForward;   /// callback for each log written
 
     /// @brief 
     /// @param name 
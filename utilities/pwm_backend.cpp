@@ -0,0 +1,408 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            pwm_backend.cpp
+// @brief           Implementation of the PWM backends
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                    reason included
+//          ------------------      ------------------------
+#include    <charconv>              // to_chars, from_chars
+#include    <filesystem>            // channel directory check
+#include    <fstream>               // file io
+#include    <sstream>               // trace parsing
+#include    <iomanip>               // command precision
+#include    <limits>                // command precision
+#include    <thread>                // export retry sleep
+#include    <chrono>                // export retry sleep
+#ifdef __linux__
+#include    <fcntl.h>               // open
+#include    <unistd.h>              // pwrite, pread, close
+#endif
+//
+#include    "pwm_backend.h"         // header
+#include    "rx_timing.h"           // monotonic clock
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /// @brief File name of each attribute, indexed by PwmAttribute
+    constexpr const char* ATTRIBUTE_NAMES[] = { "period", "duty_cycle", "enable", "polarity" };
+
+    constexpr int EXPORT_OPEN_ATTEMPTS  = 10;   // tries to open the channel files after an export
+    constexpr int EXPORT_OPEN_RETRY_MS  = 10;   // wait between tries
+}
+
+PwmTrace::PwmTrace(const size_t capacity, const size_t commandCapacity) :
+    m_capacity(capacity), m_commandCapacity(commandCapacity), m_dropped(0)
+{
+    m_entries.reserve(capacity);
+    m_commands.reserve(commandCapacity);
+}
+
+void PwmTrace::Record(const Entry& entry)
+{
+    std::scoped_lock lock(m_mutex);
+
+    // Recording is on the actuator path, a full trace drops rather than grows
+    if (m_entries.size() >= m_capacity)
+    {
+        m_dropped++;
+        return;
+    }
+    m_entries.push_back(entry);
+}
+
+void PwmTrace::RecordCommand(const Command& command)
+{
+    std::scoped_lock lock(m_mutex);
+
+    if (m_commands.size() >= m_commandCapacity)
+    {
+        m_dropped++;
+        return;
+    }
+    m_commands.push_back(command);
+}
+
+uint64_t PwmTrace::GetDropped()
+{
+    std::scoped_lock lock(m_mutex);
+    return m_dropped;
+}
+
+std::vector<PwmTrace::Entry> PwmTrace::GetEntries()
+{
+    std::scoped_lock lock(m_mutex);
+    return m_entries;
+}
+
+std::vector<PwmTrace::Command> PwmTrace::GetCommands()
+{
+    std::scoped_lock lock(m_mutex);
+    return m_commands;
+}
+
+void PwmTrace::Clear()
+{
+    std::scoped_lock lock(m_mutex);
+    m_entries.clear();
+    m_commands.clear();
+    m_dropped = 0;
+}
+
+bool PwmTrace::Save(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file) return false;
+
+    std::scoped_lock lock(m_mutex);
+    for (const Entry& entry : m_entries)
+    {
+        file << entry.timeNs << ',' << entry.id << ',' << static_cast<int>(entry.attribute) << ',' << entry.value << '\n';
+    }
+
+    // Enough digits that a replayed command is the same double
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (const Command& command : m_commands)
+    {
+        file << "C," << command.timeNs << ',' << command.tick;
+        for (const double value : command.values) file << ',' << value;
+        file << '\n';
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool PwmTrace::Load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::vector<Entry> entries;
+    std::vector<Command> commands;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty()) continue;
+
+        if (line[0] == 'C')
+        {
+            std::istringstream fields(line.substr(1));
+            Command command;
+            char comma = 0;
+            if (!(fields >> comma >> command.timeNs >> comma >> command.tick)) return false;
+            for (double& value : command.values)
+            {
+                if (!(fields >> comma >> value)) return false;
+            }
+            commands.push_back(command);
+            continue;
+        }
+
+        std::istringstream fields(line);
+        Entry entry;
+        int attribute = 0;
+        char comma = 0;
+        if (!(fields >> entry.timeNs >> comma >> entry.id >> comma >> attribute >> comma >> entry.value)) return false;
+        if (attribute < 0 || attribute >= static_cast<int>(PwmAttribute::Count)) return false;
+
+        entry.attribute = static_cast<PwmAttribute>(attribute);
+        entries.push_back(entry);
+    }
+
+    // Copied in so the reserved capacity is kept for recording
+    std::scoped_lock lock(m_mutex);
+    m_entries.assign(entries.begin(), entries.end());
+    m_commands.assign(commands.begin(), commands.end());
+    m_dropped = 0;
+    return true;
+}
+
+long PwmTrace::Compare(PwmTrace& reference)
+{
+    const std::vector<Entry> expected = reference.GetEntries();
+
+    std::scoped_lock lock(m_mutex);
+    const size_t count = std::min(m_entries.size(), expected.size());
+    for (size_t i = 0; i < count; i++)
+    {
+        const Entry& a = m_entries[i];
+        const Entry& b = expected[i];
+        if (a.id != b.id || a.attribute != b.attribute || a.value != b.value) return static_cast<long>(i);
+    }
+
+    if (m_entries.size() != expected.size()) return static_cast<long>(count);
+    return -1;
+}
+
+SysfsPwmBackend::SysfsPwmBackend() : m_channel(0), m_exported(false)
+{
+    m_fds.fill(-1);
+}
+
+SysfsPwmBackend::~SysfsPwmBackend()
+{
+    CloseAttributes();
+}
+
+void SysfsPwmBackend::SetChannel(const std::string& chipPath, const int channel)
+{
+    CloseAttributes();
+    m_chipPath = chipPath;
+    m_channel = channel;
+}
+
+bool SysfsPwmBackend::Export()
+{
+    if (!IsExported())
+    {
+        std::ofstream file(m_chipPath + "/export");
+
+        if (!file) { return false; }
+
+        file << m_channel;
+        file.close();
+    }
+
+    // Keep the hot attributes open so control writes are a single syscall. The kernel creates
+    // the channel files on export, udev may take a moment to hand them over.
+    for (int attempt = 0; attempt < EXPORT_OPEN_ATTEMPTS; attempt++)
+    {
+        if (OpenAttributes())
+        {
+            m_exported = true;
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(EXPORT_OPEN_RETRY_MS));
+    }
+
+    return false;
+}
+
+bool SysfsPwmBackend::Unexport()
+{
+    CloseAttributes();
+
+    if (!IsExported()) { return true; }
+
+    std::ofstream file(m_chipPath + "/unexport");
+
+    if (!file) { return false; }
+
+    file << m_channel;
+    file.close();
+
+    return true;
+}
+
+bool SysfsPwmBackend::IsExported()
+{
+    // Known without a lookup once Export() holds the files
+    if (m_exported) { return true; }
+
+    // Exported elsewhere, the kernel creates the channel directory on export and the export
+    // file itself is write only
+    std::error_code error;
+    return std::filesystem::is_directory(AttributePath(""), error);
+}
+
+bool SysfsPwmBackend::Write(const PwmAttribute attribute, const int64_t value)
+{
+    const size_t index = static_cast<size_t>(attribute);
+
+    char buffer[24];
+    size_t length = 0;
+    if (attribute == PwmAttribute::Polarity)
+    {
+        const char* text = value ? "inverted" : "normal";
+        length = std::char_traits<char>::length(text);
+        std::char_traits<char>::copy(buffer, text, length);
+    }
+    else
+    {
+        const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        length = static_cast<size_t>(result.ptr - buffer);
+    }
+
+#ifdef __linux__
+    if (index < NUM_HELD && m_fds[index] >= 0)
+    {
+        // sysfs takes the whole value in one write at offset 0
+        return pwrite(m_fds[index], buffer, length, 0) == static_cast<ssize_t>(length);
+    }
+#endif
+
+    // Not exported through Export(), polarity, or no descriptors on this platform
+    std::ofstream file(AttributePath(ATTRIBUTE_NAMES[index]));
+    if (!file) { return false; }
+
+    file.write(buffer, static_cast<std::streamsize>(length));
+    return static_cast<bool>(file);
+}
+
+bool SysfsPwmBackend::Read(const PwmAttribute attribute, int64_t& value)
+{
+    const size_t index = static_cast<size_t>(attribute);
+
+    char buffer[24] = {};
+    size_t length = 0;
+    bool held = false;
+
+#ifdef __linux__
+    if (index < NUM_HELD && m_fds[index] >= 0)
+    {
+        const ssize_t rtn = pread(m_fds[index], buffer, sizeof(buffer) - 1, 0);
+        if (rtn <= 0) { return false; }
+        length = static_cast<size_t>(rtn);
+        held = true;
+    }
+#endif
+
+    if (!held)
+    {
+        std::ifstream file(AttributePath(ATTRIBUTE_NAMES[index]));
+        if (!file) { return false; }
+
+        file.read(buffer, sizeof(buffer) - 1);
+        length = static_cast<size_t>(file.gcount());
+    }
+
+    if (attribute == PwmAttribute::Polarity)
+    {
+        const std::string_view text(buffer, length);
+        if (text.starts_with("normal"))     { value = 0; return true; }
+        if (text.starts_with("inverted"))   { value = 1; return true; }
+        return false;
+    }
+
+    const std::from_chars_result result = std::from_chars(buffer, buffer + length, value);
+    return result.ec == std::errc();
+}
+
+bool SysfsPwmBackend::OpenAttributes()
+{
+#ifdef __linux__
+    CloseAttributes();
+
+    for (size_t i = 0; i < NUM_HELD; i++)
+    {
+        m_fds[i] = open(AttributePath(ATTRIBUTE_NAMES[i]).c_str(), O_RDWR | O_CLOEXEC);
+        if (m_fds[i] < 0)
+        {
+            CloseAttributes();
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+void SysfsPwmBackend::CloseAttributes()
+{
+    m_exported = false;
+
+#ifdef __linux__
+    for (int& fd : m_fds)
+    {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+std::string SysfsPwmBackend::AttributePath(const char* name) const
+{
+    return m_chipPath + "/pwm" + std::to_string(m_channel) + "/" + name;
+}
+
+SimulatedPwmBackend::SimulatedPwmBackend(std::shared_ptr<PwmTrace> trace, const int id) :
+    m_trace(std::move(trace)), m_id(id), m_exported(false)
+{
+    m_values.fill(0);
+}
+
+void SimulatedPwmBackend::SetChannel(const std::string& /*chipPath*/, const int /*channel*/)
+{
+    m_exported = false;
+}
+
+bool SimulatedPwmBackend::Export()
+{
+    m_exported = true;
+    return true;
+}
+
+bool SimulatedPwmBackend::Unexport()
+{
+    m_exported = false;
+    return true;
+}
+
+bool SimulatedPwmBackend::IsExported()
+{
+    return m_exported;
+}
+
+bool SimulatedPwmBackend::Write(const PwmAttribute attribute, const int64_t value)
+{
+    if (!m_exported) return false;
+
+    m_values[static_cast<size_t>(attribute)] = value;
+    if (m_trace != nullptr)
+    {
+        m_trace->Record({ MonotonicNowNs(), m_id, attribute, value });
+    }
+    return true;
+}
+
+bool SimulatedPwmBackend::Read(const PwmAttribute attribute, int64_t& value)
+{
+    if (!m_exported) return false;
+
+    value = m_values[static_cast<size_t>(attribute)];
+    return true;
+}
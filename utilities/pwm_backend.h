@@ -0,0 +1,225 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            pwm_backend.h
+// @brief           Hardware access behind a PWM channel, sysfs or simulated
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                    reason included
+//          ------------------      ------------------------
+#include <string>                   // strings
+#include <vector>                   // trace
+#include <array>                    // attribute values
+#include <memory>                   // shared trace
+#include <mutex>                    // trace safety
+#include <cstdint>                  // standard ints
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Backend a PWM channel is driven through
+enum class PwmBackendType
+{
+    Sysfs,          // kernel sysfs files, the target hardware. A tmpfs tree laid out like sysfs also works.
+    Simulated,      // in memory, records every write to a PwmTrace
+};
+
+/// @brief Channel attributes a backend reads and writes
+enum class PwmAttribute
+{
+    Period,         // ns
+    DutyCycle,      // ns
+    Enable,         // 0 or 1
+    Polarity,       // 0 normal, 1 inverted
+    Count
+};
+
+/// @brief One channel's hardware access. A PWM owns one.
+class PwmBackend
+{
+public:
+
+    virtual ~PwmBackend() = default;
+
+    /// @brief Select the channel, closes anything open for the previous one
+    /// @param chipPath - [in] - chip path, typically "/sys/class/pwm/pwmchipX"
+    /// @param channel - [in] - channel on the chip
+    virtual void SetChannel(const std::string& chipPath, const int channel) = 0;
+
+    /// @brief Export the channel if needed and get it ready for writes
+    /// @return true if ready, else false
+    virtual bool Export() = 0;
+
+    /// @brief Unexport the channel
+    /// @return true if unexported or it was not exported, else false
+    virtual bool Unexport() = 0;
+
+    /// @brief Check if the channel is exported
+    /// @return true if exported, else false
+    virtual bool IsExported() = 0;
+
+    /// @brief Write an attribute. The hot path, must not allocate once exported.
+    /// @param attribute - [in] - attribute to write
+    /// @param value - [in] - value to write
+    /// @return true if written, else false
+    virtual bool Write(const PwmAttribute attribute, const int64_t value) = 0;
+
+    /// @brief Read an attribute
+    /// @param attribute - [in] - attribute to read
+    /// @param value - [out] - value read
+    /// @return true if read, else false
+    virtual bool Read(const PwmAttribute attribute, int64_t& value) = 0;
+};
+
+/// @brief Timestamped writes made through simulated backends, shared by every channel that
+/// records into it, and the command frames the writes came from so a run can be replayed.
+/// Saved and loaded as CSV so a run can be kept as a regression reference. Holds a fixed
+/// number of writes and commands, later ones are dropped and counted.
+class PwmTrace
+{
+public:
+
+    /// @brief One write
+    struct Entry
+    {
+        int64_t         timeNs      = 0;                        // monotonic time of the write
+        int             id          = 0;                        // channel id the backend was given
+        PwmAttribute    attribute   = PwmAttribute::DutyCycle;
+        int64_t         value       = 0;
+    };
+
+    /// @brief Channels a command frame carries, one value per channel id
+    static constexpr size_t COMMAND_CHANNELS = 4;
+
+    /// @brief One command frame as the loop writing the channels took it
+    struct Command
+    {
+        int64_t                                 timeNs  = 0;    // monotonic time the command was issued
+        uint64_t                                tick    = 0;    // loop tick it was taken on, from the first
+        std::array<double, COMMAND_CHANNELS>    values  = {};   // value per channel id
+    };
+
+    /// @brief Constructor
+    /// @param capacity - [in/opt] - writes held, reserved up front so recording does not allocate
+    /// @param commandCapacity - [in/opt] - command frames held, reserved the same way
+    explicit PwmTrace(const size_t capacity = 65536, const size_t commandCapacity = 16384);
+
+    /// @brief Add a write, dropped if the trace is full
+    /// @param entry - [in] - write to add
+    void Record(const Entry& entry);
+
+    /// @brief Add a command frame, dropped if the trace is full
+    /// @param command - [in] - command to add
+    void RecordCommand(const Command& command);
+
+    /// @brief Get the number of writes and commands dropped because the trace was full
+    /// @return entries dropped
+    uint64_t GetDropped();
+
+    /// @brief Get a copy of the writes
+    /// @return writes in the order they were made
+    std::vector<Entry> GetEntries();
+
+    /// @brief Get a copy of the command frames
+    /// @return commands in the order they were taken
+    std::vector<Command> GetCommands();
+
+    /// @brief Remove every write, command and the drop count
+    void Clear();
+
+    /// @brief Save the writes as "timeNs,id,attribute,value" lines and the commands as
+    /// "C,timeNs,tick,value,..." lines
+    /// @param path - [in] - file to write
+    /// @return true if saved, else false
+    bool Save(const std::string& path);
+
+    /// @brief Replace the writes and commands with a saved trace
+    /// @param path - [in] - file to read
+    /// @return true if loaded, else false
+    bool Load(const std::string& path);
+
+    /// @brief Compare the values written against a reference, ignoring times and commands
+    /// @param reference - [in] - expected trace
+    /// @return -1 if the same, else index of the first write that differs
+    long Compare(PwmTrace& reference);
+
+private:
+
+    size_t                  m_capacity;         /// Writes held
+    size_t                  m_commandCapacity;  /// Commands held
+    uint64_t                m_dropped;          /// Writes and commands dropped when full
+    std::vector<Entry>      m_entries;          /// Writes, oldest first
+    std::vector<Command>    m_commands;         /// Commands, oldest first
+    std::mutex              m_mutex;            /// Protects the entries, commands and m_dropped
+};
+
+/// @brief Channel driven through the kernel sysfs interface. The period, duty cycle and enable
+/// files are held open after export and written with pwrite, and the export is remembered so
+/// enabling and disabling never touch the filesystem.
+class SysfsPwmBackend : public PwmBackend
+{
+public:
+
+    SysfsPwmBackend();
+    ~SysfsPwmBackend() override;
+
+    SysfsPwmBackend(const SysfsPwmBackend&) = delete;
+    SysfsPwmBackend& operator=(const SysfsPwmBackend&) = delete;
+
+    void SetChannel(const std::string& chipPath, const int channel) override;
+    bool Export() override;
+    bool Unexport() override;
+    bool IsExported() override;
+    bool Write(const PwmAttribute attribute, const int64_t value) override;
+    bool Read(const PwmAttribute attribute, int64_t& value) override;
+
+private:
+
+    /// @brief Number of attributes held open, polarity is opened on use
+    static constexpr size_t NUM_HELD = 3;
+
+    /// @brief Open the held attribute files of an exported channel
+    /// @return true if every file opened, else false
+    bool OpenAttributes();
+
+    /// @brief Close the held attribute files
+    void CloseAttributes();
+
+    /// @brief Get the path of an attribute file
+    /// @param name - [in] - attribute file name
+    /// @return full path
+    std::string AttributePath(const char* name) const;
+
+    std::string                     m_chipPath;     /// Chip path
+    int                             m_channel;      /// Channel on the chip
+    std::array<int, NUM_HELD>       m_fds;          /// Open attribute files, -1 when closed
+    bool                            m_exported;     /// Exported through Export() and the files are held
+};
+
+/// @brief Channel held in memory. Every write is kept and recorded to a trace, so the actuator
+/// path can be run and timed on any host.
+class SimulatedPwmBackend : public PwmBackend
+{
+public:
+
+    /// @brief Constructor
+    /// @param trace - [in/opt] - trace to record writes to, nullptr for none
+    /// @param id - [in/opt] - id recorded with each write, the fin index for the signal manager
+    SimulatedPwmBackend(std::shared_ptr<PwmTrace> trace = nullptr, const int id = 0);
+
+    void SetChannel(const std::string& chipPath, const int channel) override;
+    bool Export() override;
+    bool Unexport() override;
+    bool IsExported() override;
+    bool Write(const PwmAttribute attribute, const int64_t value) override;
+    bool Read(const PwmAttribute attribute, int64_t& value) override;
+
+private:
+
+    std::shared_ptr<PwmTrace>       m_trace;        /// Trace writes are recorded to
+    int                             m_id;           /// Id recorded with each write
+    bool                            m_exported;     /// Channel exported
+    std::array<int64_t, static_cast<size_t>(PwmAttribute::Count)> m_values;    /// Attribute values
+};
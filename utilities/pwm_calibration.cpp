@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            pwm_calibration.cpp
+// @brief           Implementation of the pwm calibration table
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                    reason included
+//          ------------------      ------------------------
+#include    <cmath>                 // isfinite, ceil
+//
+#include    "pwm_calibration.h"     // header
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    constexpr size_t MAX_TABLE_SIZE = 1 << 16;  // largest table a curve and step may build
+}
+
+PwmCalibration::PwmCalibration() : m_minDegrees(0), m_maxDegrees(0), m_inverseStep(1), m_lastIndex(0), m_trim(0)
+{
+    Build(LinearCurve());
+}
+
+PwmCalibration::Curve PwmCalibration::LinearCurve()
+{
+    return { { -60.0, 900.0 }, { 60.0, 2100.0 } };
+}
+
+bool PwmCalibration::Build(Curve curve, const double trimDegrees, const double stepDegrees)
+{
+    if (curve.size() < 2 || !std::isfinite(trimDegrees) || !std::isfinite(stepDegrees) || stepDegrees <= 0) return false;
+
+    std::sort(curve.begin(), curve.end(), [](const auto& a, const auto& b) { return a[0] < b[0]; });
+
+    for (size_t i = 0; i < curve.size(); i++)
+    {
+        if (!std::isfinite(curve[i][0]) || !std::isfinite(curve[i][1])) return false;
+        if (curve[i][1] < MIN_PULSE_US || curve[i][1] > MAX_PULSE_US) return false;
+        if (i > 0 && curve[i][0] <= curve[i - 1][0]) return false;
+    }
+
+    const double span = curve.back()[0] - curve.front()[0];
+    const size_t size = static_cast<size_t>(std::ceil(span / stepDegrees)) + 1;
+    if (size > MAX_TABLE_SIZE) return false;
+
+    // Secant slope of each segment
+    const size_t points = curve.size();
+    std::vector<double> secants(points - 1);
+    for (size_t i = 0; i + 1 < points; i++)
+    {
+        secants[i] = (curve[i + 1][1] - curve[i][1]) / (curve[i + 1][0] - curve[i][0]);
+    }
+
+    // Fritsch-Carlson tangents, flat where the curve turns so it never overshoots a point
+    std::vector<double> tangents(points);
+    tangents.front() = secants.front();
+    tangents.back() = secants.back();
+    for (size_t i = 1; i + 1 < points; i++)
+    {
+        if (secants[i - 1] * secants[i] <= 0)
+        {
+            tangents[i] = 0;
+            continue;
+        }
+
+        const double before = curve[i][0] - curve[i - 1][0];
+        const double after = curve[i + 1][0] - curve[i][0];
+        const double w1 = 2 * after + before;
+        const double w2 = after + 2 * before;
+        tangents[i] = (w1 + w2) / (w1 / secants[i - 1] + w2 / secants[i]);
+    }
+
+    std::vector<float> table(size);
+    const double step = span / static_cast<double>(size - 1);
+    size_t segment = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        const double degrees = curve.front()[0] + step * static_cast<double>(i);
+        while (segment + 2 < points && degrees > curve[segment + 1][0]) segment++;
+
+        // Cubic Hermite across the segment
+        const double h = curve[segment + 1][0] - curve[segment][0];
+        const double t = std::clamp((degrees - curve[segment][0]) / h, 0.0, 1.0);
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        const double pulse = (2 * t3 - 3 * t2 + 1) * curve[segment][1] + (t3 - 2 * t2 + t) * h * tangents[segment]
+            + (-2 * t3 + 3 * t2) * curve[segment + 1][1] + (t3 - t2) * h * tangents[segment + 1];
+
+        table[i] = static_cast<float>(pulse);
+    }
+
+    m_table = std::move(table);
+    m_minDegrees = curve.front()[0];
+    m_maxDegrees = curve.back()[0];
+    m_inverseStep = 1.0 / step;
+    m_lastIndex = static_cast<double>(size - 1);
+    m_trim = trimDegrees;
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            pwm_calibration.h
+// @brief           Degree to pulse width calibration compiled into a lookup table
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                    reason included
+//          ------------------      ------------------------
+#include <vector>                   // curve and table
+#include <array>                    // curve points
+#include <algorithm>                // clamp
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief A servo's degree to pulse width mapping. The calibration points are joined with a
+/// monotone cubic, so the curve passes through every point without overshooting between them,
+/// and sampled into a dense table at startup. Converting a deflection is then one table lookup.
+class PwmCalibration
+{
+public:
+
+    /// @brief Calibration points as { degrees, pulse width us }, any order
+    using Curve = std::vector<std::array<double, 2>>;
+
+    /// @brief Table spacing used unless one is given, deg
+    static constexpr double DEFAULT_STEP_DEGREES = 0.05;
+
+    /// @brief Pulse widths accepted in a curve, us
+    static constexpr double MIN_PULSE_US = 500.0;
+    static constexpr double MAX_PULSE_US = 2500.0;
+
+    /// @brief Constructor, builds the linear 900 - 2100 us over +/-60 deg mapping
+    PwmCalibration();
+
+    /// @brief The linear 900 - 2100 us over +/-60 deg mapping
+    /// @return curve
+    static Curve LinearCurve();
+
+    /// @brief Compile a curve into the table. The table is unchanged if the curve is invalid.
+    /// @param curve - [in] - at least two points, no two at the same degrees
+    /// @param trimDegrees - [in/opt] - added to every deflection before the lookup
+    /// @param stepDegrees - [in/opt] - table spacing
+    /// @return true if built, false if the curve or step is invalid
+    bool Build(Curve curve, const double trimDegrees = 0, const double stepDegrees = DEFAULT_STEP_DEGREES);
+
+    /// @brief Convert a deflection, held at the end points outside the curve
+    /// @param degrees - [in] - deflection
+    /// @return pulse width, us
+    double PulseUs(const double degrees) const
+    {
+        const double position = std::clamp((degrees + m_trim - m_minDegrees) * m_inverseStep, 0.0, m_lastIndex);
+        const size_t index = static_cast<size_t>(position);
+        if (index + 1 >= m_table.size()) return m_table.back();
+
+        const double fraction = position - static_cast<double>(index);
+        return m_table[index] + (m_table[index + 1] - m_table[index]) * fraction;
+    }
+
+    /// @brief Get the deflection range the curve covers, before trim
+    /// @return deg
+    double GetMinDegrees() const { return m_minDegrees; }
+    double GetMaxDegrees() const { return m_maxDegrees; }
+
+    /// @brief Get the trim
+    /// @return deg
+    double GetTrim() const { return m_trim; }
+
+private:
+
+    std::vector<float>  m_table;            /// Pulse width per step from m_minDegrees, us
+    double              m_minDegrees;       /// Deflection of the first entry
+    double              m_maxDegrees;       /// Deflection of the last entry
+    double              m_inverseStep;      /// Entries per degree
+    double              m_lastIndex;        /// Index of the last entry
+    double              m_trim;             /// Added to every deflection
+};
@@ -10,6 +10,8 @@
 // Includes:
 //          name                    reason included
 //          ------------------      ------------------------
+#include    <cmath>                 // lround
+//
 #include    "pwm_interface.h"       // PWM header
 //
 /////////////////////////////////////////////////////////////////////////////////
@@ -19,15 +21,26 @@ bool PWM::SetPath(const std::string& pwmPath)
     if (pwmPath.empty()) return false;
 
     m_pwmPath = pwmPath;
+    m_backend->SetChannel(m_pwmPath, m_pwmChannel);
     return m_pwmPath == pwmPath;
 }
 
 bool PWM::SetChannel(const int pwmChannel)
 {
     m_pwmChannel = pwmChannel;
+    m_backend->SetChannel(m_pwmPath, m_pwmChannel);
     return m_pwmChannel == pwmChannel;
 }
 
+bool PWM::SetBackend(std::unique_ptr<PwmBackend> backend)
+{
+    if (backend == nullptr) return false;
+
+    m_backend = std::move(backend);
+    m_backend->SetChannel(m_pwmPath, m_pwmChannel);
+    return true;
+}
+
 bool PWM::UpdateDegreeClamp(const double pwmMinDegrees, const double pwmMaxDegrees)
 {
     m_minDegrees = pwmMinDegrees;
@@ -35,50 +48,24 @@ bool PWM::UpdateDegreeClamp(const double pwmMinDegrees, const double pwmMaxDegre
     return m_minDegrees == pwmMinDegrees && m_maxDegrees == pwmMaxDegrees;
 }
 
-PWM::PWMStatus PWM::ExportPWM()
+bool PWM::SetCalibration(const PwmCalibration::Curve& curve, const double trimDegrees)
 {
-    if (IsExported() == PWMStatus::Success) { return PWMStatus::Success; }
-
-    std::ofstream file(m_pwmPath + "/export");
-
-    if (!file) { return PWMStatus::Error; }
-
-    file << m_pwmChannel;
-    file.close();
+    return m_calibration.Build(curve, trimDegrees);
+}
 
-    return PWMStatus::Success;
+PWM::PWMStatus PWM::ExportPWM()
+{
+    return m_backend->Export() ? PWMStatus::Success : PWMStatus::Error;
 }
 
 PWM::PWMStatus PWM::UnExportPWM()
 {
-    if (IsExported() == PWMStatus::NotExported) { return PWMStatus::Success; }
-
-    std::ofstream file(m_pwmPath + "/unexport");
-
-    if (!file) { return PWMStatus::Error; }
-
-    file << m_pwmChannel;
-    file.close();
-
-    return PWMStatus::Success;
+    return m_backend->Unexport() ? PWMStatus::Success : PWMStatus::Error;
 }
 
 PWM::PWMStatus PWM::GetPeriod(size_t& period_ns)
 {
-    PWMStatus status = PWMStatus::Error;
-    std::ifstream file(m_pwmPath + "/pwm" + std::to_string(m_pwmChannel) + "/period");
-
-    if (!file) { return status; }
-
-    std::string period;
-    if (std::getline(file, period))
-    {
-        period_ns = std::stoi(period);
-        status = PWMStatus::Success;
-    }
-    file.close();
-
-    return status;
+    return ReadAttribute(PwmAttribute::Period, period_ns);
 }
 
 size_t PWM::GetPeriod()
@@ -90,32 +77,12 @@ size_t PWM::GetPeriod()
 
 PWM::PWMStatus PWM::SetPeriod(size_t period_ns)
 {
-    std::ofstream file(m_pwmPath + "/pwm" + std::to_string(m_pwmChannel) + "/period");
-
-    if (!file) { return PWMStatus::Error; }
-
-    file << period_ns;
-    file.close();
-
-    return PWMStatus::Success;
+    return WriteAttribute(PwmAttribute::Period, static_cast<int64_t>(period_ns));
 }
 
 PWM::PWMStatus PWM::GetDutyCycle(size_t& dutyCycle_ns)
 {
-    PWMStatus status = PWMStatus::Error;
-    std::ifstream file(m_pwmPath + "/pwm" + std::to_string(m_pwmChannel) + "/duty_cycle");
-
-    if (!file) { return status; }
-
-    std::string duty;
-    if (std::getline(file, duty))
-    {
-        dutyCycle_ns = std::stoi(duty);
-        status = PWMStatus::Success;
-    }
-    file.close();
-
-    return status;
+    return ReadAttribute(PwmAttribute::DutyCycle, dutyCycle_ns);
 }
 
 size_t PWM::GetDutyCycle()
@@ -127,33 +94,22 @@ size_t PWM::GetDutyCycle()
 
 PWM::PWMStatus PWM::SetDutyCycle(int dutyCycle_ns)
 {
-    std::ofstream file(m_pwmPath + "/pwm" + std::to_string(m_pwmChannel) + "/duty_cycle");
-
-    if (!file) { return PWMStatus::Error; }
-
-    file << dutyCycle_ns;
-    file.close();
+    return WriteAttribute(PwmAttribute::DutyCycle, dutyCycle_ns);
+}
 
-    return PWMStatus::Success;
+PWM::PWMStatus PWM::SetDegrees(const double degrees)
+{
+    // DegreesToPWM gives the pulse width in microseconds
+    return SetDutyCycle(static_cast<int>(DegreesToPWM(degrees)) * 1000);
 }
 
 PWM::PWMStatus PWM::GetPolarity(PWMPolarity& polarity)
 {
-    PWMStatus status = PWMStatus::Error;
-
-    std::ifstream file(m_pwmPath + "/pwm" + std::to_string(m_pwmChannel) + "/polarity");
-
-    if (!file) { return status; }
+    int64_t value = 0;
+    if (!m_backend->Read(PwmAttribute::Polarity, value)) { return PWMStatus::Error; }
 
-    std::string read;
-    if (std::getline(file, read))
-    {
-        if (read == "normal") { polarity = PWMPolarity::Normal; status = PWMStatus::Success; }
-        else if (read == "inverted") { polarity = PWMPolarity::Inverted; status = PWMStatus::Success; }
-    }
-    file.close();
-
-    return status;
+    polarity = value ? PWMPolarity::Inverted : PWMPolarity::Normal;
+    return PWMStatus::Success;
 }
 
 PWM::PWMPolarity PWM::GetPolarity()
@@ -168,16 +124,7 @@ PWM::PWMStatus PWM::SetPolarity(const PWM::PWMPolarity polarity)
     if (DisablePWM() != PWMStatus::Success) { return PWMStatus::Error; }
     if (polarity == PWMPolarity::Unknown) { return PWMStatus::InvalidInput; }
 
-    std::ofstream file(m_pwmPath + "/pwm" + std::to_string(m_pwmChannel) + "/polarity");
-
-    if (!file) { return PWMStatus::Error; }
-
-    if (polarity == PWMPolarity::Normal) { file << "normal"; }
-    else if (polarity == PWMPolarity::Inverted) { file << "inverted"; }
-
-    file.close();
-
-    return PWMStatus::Success;
+    return WriteAttribute(PwmAttribute::Polarity, polarity == PWMPolarity::Inverted ? 1 : 0);
 }
 
 PWM::PWMStatus PWM::EnablePWM()
@@ -194,30 +141,30 @@ PWM::PWMStatus PWM::EnableDisablePWM(bool value)
 {
     if (IsExported() != PWMStatus::Success) { return PWMStatus::NotExported; }
 
-    std::ofstream file(m_pwmPath + "/pwm" + std::to_string(m_pwmChannel) + "/enable");
-
-    if (!file) { return PWMStatus::Error; }
-
-    file << std::to_string(value);
-    file.close();
-
-    return PWMStatus::Success;
+    return WriteAttribute(PwmAttribute::Enable, value ? 1 : 0);
 }
 
 PWM::PWMStatus PWM::IsExported()
 {
-    PWMStatus status = PWMStatus::NotExported;
+    return m_backend->IsExported() ? PWMStatus::Success : PWMStatus::NotExported;
+}
 
-    std::ifstream file(m_pwmPath + "/export");
-    std::string line;
+PWM::PWMStatus PWM::WriteAttribute(const PwmAttribute attribute, const int64_t value)
+{
+    const int64_t start = MonotonicNowNs();
+    const bool written = m_backend->Write(attribute, value);
+    m_writeLatency.Record(MonotonicNowNs() - start);
 
-    if (std::getline(file, line))
-    {
-        if (line == std::to_string(m_pwmChannel)) { status = PWMStatus::Success; }
-    }
-    file.close();
+    return written ? PWMStatus::Success : PWMStatus::Error;
+}
 
-    return status;
+PWM::PWMStatus PWM::ReadAttribute(const PwmAttribute attribute, size_t& value)
+{
+    int64_t read = 0;
+    if (!m_backend->Read(attribute, read)) { return PWMStatus::Error; }
+
+    value = static_cast<size_t>(read);
+    return PWMStatus::Success;
 }
 
 double PWM::Constrain(double value) const
@@ -225,13 +172,18 @@ double PWM::Constrain(double value) const
     return std::max(std::min(value, m_maxDegrees), m_minDegrees);
 }
 
-size_t PWM::DegreesToPWM(double degrees)
+double PWM::ClampDegrees(double degrees) const
 {
     // Make sure value is within bounds, if bounds are set
     if (m_maxDegrees != 0 && m_minDegrees != 0) { degrees = Constrain(degrees); }
 
-    // Map the degrees to pulse width linearly
-    int pulseWidth = 900 + ((degrees + 60) * (2100 - 900)) / 120;
+    return degrees;
+}
+
+size_t PWM::DegreesToPWM(double degrees) const
+{
+    degrees = ClampDegrees(degrees);
 
-    return pulseWidth;
+    // One lookup, the curve was compiled into the table when it was set
+    return static_cast<size_t>(std::lround(m_calibration.PulseUs(degrees)));
 }
@@ -14,6 +14,12 @@
 #include <iostream>                 // console io
 #include <fstream>                  // file io
 #include <algorithm>                // min and max
+#include <memory>                   // backend
+#include <cstdint>                  // standard ints
+//
+#include "rx_timing.h"              // write latency
+#include "pwm_backend.h"            // hardware access
+#include "pwm_calibration.h"        // degrees to pulse width
 //
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -43,7 +49,17 @@ public:
     /// @param pwmMinDegrees - [opt] - Adds ability to clamp the degrees to pwm via this minimum degree spec. 
     /// @param pwmMaxDegrees - [opt] - Adds ability to clamp the degrees to pwm via this max degree spec.
     PWM(const std::string& pwmPath, const int pwmChannel = 0, const double pwmMinDegrees = 0, const double pwmMaxDegrees = 0)
-        : m_pwmPath(pwmPath), m_pwmChannel(pwmChannel), m_minDegrees(pwmMinDegrees), m_maxDegrees(pwmMaxDegrees) {}
+        : m_pwmPath(pwmPath), m_pwmChannel(pwmChannel), m_maxDegrees(pwmMaxDegrees), m_minDegrees(pwmMinDegrees),
+        m_backend(std::make_unique<SysfsPwmBackend>()) { m_backend->SetChannel(m_pwmPath, m_pwmChannel); }
+
+    /// @brief Owns its backend, not copyable
+    PWM(const PWM&) = delete;
+    PWM& operator=(const PWM&) = delete;
+
+    /// @brief Replace the hardware access, the sysfs backend is used by default. Unexport first.
+    /// @param backend - backend to drive the channel through
+    /// @return true if successfully set, otherwise false
+    bool SetBackend(std::unique_ptr<PwmBackend> backend);
 
     /// @brief Sets the path for the PWM
     /// @param pwmPath - Path to the pwm Typically "/sys/class/pwm/pwmchipX"
@@ -61,6 +77,16 @@ public:
     /// @return true if successfully set, otherwise false
     bool UpdateDegreeClamp(const double pwmMinDegrees, const double pwmMaxDegrees);
 
+    /// @brief Replace the degree to pulse width calibration, the linear mapping is used by default
+    /// @param curve - calibration points as { degrees, pulse width us }
+    /// @param trimDegrees - [opt] - added to every deflection before the lookup
+    /// @return true if the curve is valid and set, otherwise false and the calibration is unchanged
+    bool SetCalibration(const PwmCalibration::Curve& curve, const double trimDegrees = 0);
+
+    /// @brief Get the degree to pulse width calibration
+    /// @return calibration
+    const PwmCalibration& GetCalibration() const { return m_calibration; }
+
     /// @brief - export a PWM for usage
     /// @return - PWMStatus::Success if successful export, else PWMStatus::Error.
     PWMStatus ExportPWM();
@@ -97,6 +123,11 @@ public:
     /// @return - PWMStatus::Success if successful set of duty cycle, else PWMStatus::Error.
     PWMStatus SetDutyCycle(int dutyCycle_ns);
 
+    /// @brief - Set the PWM Duty Cycle for a deflection
+    /// @param degrees - deflection, constrained to the degree clamp when one is set
+    /// @return - PWMStatus::Success if successful set of duty cycle, else PWMStatus::Error.
+    PWMStatus SetDegrees(const double degrees);
+
     /// @brief - Get the PWM polarity
     /// @param polarity - output variable for return
     /// @return - PWMStatus::Success if successful polarity read, else PWMStatus::Error.
@@ -119,12 +150,42 @@ public:
     /// @return - PWMStatus::Sucess if good set, PWMStatus::NotExported if not exported, else PWMStatus::Error
     PWMStatus DisablePWM();
 
+    /// @brief Constrain degrees to the degree clamp, if one is set
+    /// @param degrees - input for desired degree of input
+    /// @return - constrained degrees
+    double ClampDegrees(double degrees) const;
+
+    /// @brief Convert degrees into A valid PWM signal through the calibration table, Will constrain to min/max range if thy're not zero. 
+    /// @param degrees - input for desired degree of input
+    /// @return - converted PWM value, pulse width in microseconds
+    size_t DegreesToPWM(double degrees) const;
+
+    /// @brief - Get the time taken by period, duty cycle and enable writes
+    /// @return - histogram of write latencies
+    const LatencyHistogram& GetWriteLatency() const { return m_writeLatency; }
+
 private:
     std::string m_pwmPath;      // path of the pwm
     int         m_pwmChannel;   // channel of the pwm
     double      m_maxDegrees;   // maximum degree range for the pwm
     double      m_minDegrees;   // minimum degree range for the pwm
 
+    std::unique_ptr<PwmBackend> m_backend;      // hardware access, sysfs unless replaced
+    LatencyHistogram            m_writeLatency; // time taken by each attribute write
+    PwmCalibration              m_calibration;  // degrees to pulse width table
+
+    /// @brief Write a number to an attribute through the backend, timing the write
+    /// @param attribute - attribute to write
+    /// @param value - value to write
+    /// @return - PWMStatus::Success if written, else PWMStatus::Error
+    PWMStatus WriteAttribute(const PwmAttribute attribute, const int64_t value);
+
+    /// @brief Read a number from an attribute through the backend
+    /// @param attribute - attribute to read
+    /// @param value - output variable for return
+    /// @return - PWMStatus::Success if read, else PWMStatus::Error
+    PWMStatus ReadAttribute(const PwmAttribute attribute, size_t& value);
+
     /// @brief function to enable or disable a PWM
     /// @param value - bool to enable (true) or disable (false) PWM
     /// @return - PWMStatus::Sucess if good set, PWMStatus::NotExported if not exported, else PWMStatus::Error
@@ -139,9 +200,4 @@ private:
     /// @return - constrained value
     double Constrain(double value) const;
 
-    /// @brief Convert degrees into A valid PWM signal, Will constrain to min/max range if thy're not zero. 
-    /// @param degrees - input for desired degree of input
-    /// @return - converted PWM value
-    size_t DegreesToPWM(double degrees);
-
 };
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            rx_timing.h
+// @brief           Host side receive time stamping and latency accounting
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <array>                            // fixed storage
+#include <bit>                              // bit_width
+#include <chrono>                           // steady clock
+#include <cstddef>                          // size_t
+#include <cstdint>                          // standard ints
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Get the monotonic time in nanoseconds. All receive stamps share this clock.
+/// @return nanoseconds since an unspecified steady epoch
+inline int64_t MonotonicNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// @brief Monotonic times the first and last bytes of a framed message were read
+struct RxStamp
+{
+    int64_t firstByteNs     = 0;
+    int64_t lastByteNs      = 0;
+};
+
+/// @brief Tracks when the bytes of a parse buffer were read. Every read appends a chunk
+/// and every consume from the front of the buffer shifts the chunks down with it,
+/// so any framed message can be stamped by its offset and length within the buffer.
+class RxTimeline
+{
+public:
+
+    /// @brief Record a read appended to the end of the buffer
+    /// @param bytes - [in] - number of bytes read
+    /// @param timeNs - [in] - monotonic time the read returned
+    void Append(size_t bytes, int64_t timeNs)
+    {
+        if (bytes == 0) return;
+
+        size_t end = m_count > 0 ? m_chunks[m_count - 1].endOffset + bytes : bytes;
+
+        // out of chunks, fold into the newest one. Those bytes read late rather than early.
+        if (m_count == MAX_CHUNKS)
+        {
+            m_chunks[m_count - 1] = { end, timeNs };
+            return;
+        }
+
+        m_chunks[m_count++] = { end, timeNs };
+    }
+
+    /// @brief Remove bytes from the front of the buffer
+    /// @param bytes - [in] - number of bytes removed
+    void Consume(size_t bytes)
+    {
+        size_t dropped = 0;
+        while (dropped < m_count && m_chunks[dropped].endOffset <= bytes) dropped++;
+
+        for (size_t i = dropped; i < m_count; i++)
+        {
+            m_chunks[i - dropped] = { m_chunks[i].endOffset - bytes, m_chunks[i].timeNs };
+        }
+
+        m_count -= dropped;
+    }
+
+    /// @brief Forget all chunks, used when the buffer is flushed
+    void Reset()
+    {
+        m_count = 0;
+    }
+
+    /// @brief Stamp a message held in the buffer
+    /// @param offset - [in] - offset of the first byte of the message
+    /// @param length - [in] - length of the message in bytes
+    /// @return stamp for the message, zeros if the bytes are not tracked
+    RxStamp StampFor(size_t offset, size_t length) const
+    {
+        RxStamp stamp = {};
+        if (length == 0) return stamp;
+
+        stamp.firstByteNs = TimeAt(offset);
+        stamp.lastByteNs = TimeAt(offset + length - 1);
+        return stamp;
+    }
+
+private:
+
+    /// @brief Get the read time of the byte at an offset
+    /// @param offset - [in] - byte offset in the buffer
+    /// @return monotonic time of the read that delivered the byte, 0 if not tracked
+    int64_t TimeAt(size_t offset) const
+    {
+        for (size_t i = 0; i < m_count; i++)
+        {
+            if (offset < m_chunks[i].endOffset) return m_chunks[i].timeNs;
+        }
+        return 0;
+    }
+
+    struct Chunk
+    {
+        size_t  endOffset;      // one past the last byte of this read
+        int64_t timeNs;         // time the read returned
+    };
+
+    static constexpr size_t MAX_CHUNKS = 64;
+
+    std::array<Chunk, MAX_CHUNKS>   m_chunks    = {};   /// Reads held in the buffer, oldest first
+    size_t                          m_count     = 0;    /// Number of valid chunks
+};
+
+/// @brief Log2 histogram of latencies. Bucket 0 holds under 1us,
+/// bucket i holds [2^(i-1), 2^i) us, the last bucket holds everything above.
+class LatencyHistogram
+{
+public:
+
+    static constexpr size_t NUM_BUCKETS = 24;
+
+    /// @brief Add a latency sample
+    /// @param latencyNs - [in] - latency in nanoseconds, negative samples are counted as 0
+    void Record(int64_t latencyNs)
+    {
+        if (latencyNs < 0) latencyNs = 0;
+
+        uint64_t us = static_cast<uint64_t>(latencyNs) / 1000;
+        size_t bucket = static_cast<size_t>(std::bit_width(us));
+        if (bucket >= NUM_BUCKETS) bucket = NUM_BUCKETS - 1;
+
+        m_buckets[bucket]++;
+        m_count++;
+        m_sumNs += latencyNs;
+        if (latencyNs > m_maxNs) m_maxNs = latencyNs;
+    }
+
+    /// @brief Get the upper bound of a bucket
+    /// @param bucket - [in] - bucket index
+    /// @return upper bound in microseconds, 0 for the open ended last bucket
+    static uint64_t BucketUpperBoundUs(size_t bucket)
+    {
+        return bucket + 1 < NUM_BUCKETS ? (uint64_t{ 1 } << bucket) : 0;
+    }
+
+    uint64_t Bucket(size_t bucket) const    { return bucket < NUM_BUCKETS ? m_buckets[bucket] : 0; }
+    uint64_t Count() const                  { return m_count; }
+    int64_t  MaxNs() const                  { return m_maxNs; }
+    double   MeanNs() const                 { return m_count > 0 ? static_cast<double>(m_sumNs) / m_count : 0.0; }
+
+private:
+    std::array<uint64_t, NUM_BUCKETS>   m_buckets   = {};   /// Sample counts per bucket
+    uint64_t                            m_count     = 0;    /// Total samples
+    int64_t                             m_sumNs     = 0;    /// Sum of samples for the mean
+    int64_t                             m_maxNs     = 0;    /// Largest sample
+};
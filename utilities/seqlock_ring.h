@@ -0,0 +1,121 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            seqlock_ring.h
+// @brief           Lock free ring of seqlock slots, one writer and any number of readers
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <array>                            // storage
+#include <atomic>                           // sequences
+#include <cstdint>                          // standard ints
+#include <cstring>                          // memcpy
+#include <type_traits>                      // trivially copyable
+//
+#include "constants.h"                      // cache line size
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief The last Capacity values written, by write index. One thread writes and never waits,
+/// any number of threads read without it knowing about them. Every slot is a seqlock: a reader
+/// copies the slot and keeps the copy only if the slot's sequence was the expected one, and
+/// even, before and after. The base of Topic and TimeHistory.
+/// @tparam T - value type, trivially copyable
+/// @tparam Capacity - values held, a power of two
+template <typename T, size_t Capacity>
+class SeqlockRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SeqlockRing capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "SeqlockRing values are copied under a seqlock");
+
+public:
+
+    /// @brief Writer side. Add the newest value, over the oldest once the ring is full.
+    /// @param value - [in] - value
+    void Write(const T& value)
+    {
+        const uint64_t index = m_count.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[index & MASK];
+
+        // odd while writing, readers that see it or see it change retry
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(&slot.value, &value, sizeof(T));
+
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        m_count.store(index + 1, std::memory_order_release);
+    }
+
+    /// @brief Number of values written since construction
+    /// @return count
+    uint64_t Count() const { return m_count.load(std::memory_order_acquire); }
+
+    /// @brief Read a value
+    /// @param index - [in] - write index of the value
+    /// @param value - [out] - value
+    /// @return true if the value was still held and was not written during the copy
+    bool Read(const uint64_t index, T& value) const
+    {
+        const Slot& slot = m_slots[index & MASK];
+        const uint64_t expected = 2 * index + 2;
+
+        if (slot.sequence.load(std::memory_order_acquire) != expected) return false;
+        std::memcpy(&value, &slot.value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == expected;
+    }
+
+    /// @brief Read one member of a value, cheaper than the whole value for a search
+    /// @param index - [in] - write index of the value
+    /// @param member - [in] - member to read
+    /// @param field - [out] - member value
+    /// @return true if the value was still held and was not written during the copy
+    template <typename Field>
+    bool ReadMember(const uint64_t index, Field T::* member, Field& field) const
+    {
+        const Slot& slot = m_slots[index & MASK];
+        const uint64_t expected = 2 * index + 2;
+
+        if (slot.sequence.load(std::memory_order_acquire) != expected) return false;
+        std::memcpy(&field, &(slot.value.*member), sizeof(Field));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == expected;
+    }
+
+    /// @brief Read the newest value
+    /// @param value - [out] - newest value
+    /// @return true if read, false if nothing was written or the writer kept lapping the read
+    bool Latest(T& value) const
+    {
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++)
+        {
+            const uint64_t count = Count();
+            if (count == 0) return false;
+            if (Read(count - 1, value)) return true;
+        }
+        return false;
+    }
+
+    /// @brief Number of values held
+    /// @return capacity
+    static constexpr size_t GetCapacity() { return Capacity; }
+
+private:
+
+    static constexpr uint64_t MASK = Capacity - 1;
+    static constexpr int MAX_ATTEMPTS = 4;
+
+    struct Slot
+    {
+        std::atomic<uint64_t>   sequence    = 0;    /// 2 * index + 2 once written, odd while writing
+        T                       value       = {};   /// Value
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_count  = 0;    /// Values written
+    alignas(CACHE_LINE_SIZE) std::array<Slot, Capacity> m_slots;    /// Values, by index masked to the capacity
+};
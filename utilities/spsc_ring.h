@@ -0,0 +1,106 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            spsc_ring.h
+// @brief           Lock free single producer, single consumer ring buffer
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <array>                            // storage
+#include <atomic>                           // indices
+#include <cstddef>                          // size_t
+//
+#include "constants.h"                      // cache line size
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Fixed capacity ring passing items from one producer thread to one consumer thread
+/// without locks. The indices only grow, the slot is the index masked by the capacity. Each
+/// side keeps a cached copy of the other side's index on its own cache line, so the shared
+/// index is only read when the ring looks full or empty.
+/// @tparam T - item type, copied in and out
+/// @tparam Capacity - number of slots, a power of two
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+
+    /// @brief Producer side. Copy an item into the ring.
+    /// @param item - [in] - item to add
+    /// @return true if added, false if the ring is full
+    bool TryPush(const T& item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head - m_cachedTail == Capacity)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail == Capacity) return false;
+        }
+
+        m_items[head & MASK] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Consumer side. Look at the oldest item without removing it.
+    /// @return pointer to the oldest item, valid until Pop(), or nullptr if empty
+    const T* Front()
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail == m_cachedHead)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) return nullptr;
+        }
+
+        return &m_items[tail & MASK];
+    }
+
+    /// @brief Consumer side. Remove the oldest item, only after Front() returned one.
+    void Pop()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// @brief Consumer side. Copy out and remove the oldest item.
+    /// @param item - [out] - oldest item
+    /// @return true if an item was removed, false if the ring is empty
+    bool TryPop(T& item)
+    {
+        const T* front = Front();
+        if (front == nullptr) return false;
+
+        item = *front;
+        Pop();
+        return true;
+    }
+
+    /// @brief Number of items in the ring, a snapshot when called from a third thread
+    /// @return item count
+    size_t Size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    /// @brief Number of slots
+    /// @return capacity
+    static constexpr size_t GetCapacity() { return Capacity; }
+
+private:
+
+    static constexpr size_t MASK = Capacity - 1;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t>    m_head          = 0;    /// Next slot to write, producer owned
+    size_t                                          m_cachedTail    = 0;    /// Producer's copy of m_tail
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t>    m_tail          = 0;    /// Next slot to read, consumer owned
+    size_t                                          m_cachedHead    = 0;    /// Consumer's copy of m_head
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> m_items        = {};   /// Slots
+};
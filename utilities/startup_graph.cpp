@@ -0,0 +1,183 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            startup_graph.cpp
+// @brief           Implementation for the startup graph
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstdio>                           // snprintf
+//
+#include "startup_graph.h"                  // header
+#include "rx_timing.h"                      // monotonic clock
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+StartupGraph::StartupGraph(LogClient& logger) : m_name("STARTUP"), m_logger(logger),
+    m_running(false), m_ready(false), m_runNs(0), m_readyNs(0)
+{
+}
+
+StartupGraph::~StartupGraph()
+{
+    Wait();
+}
+
+int StartupGraph::AddStage(const std::string& name, std::function<bool()> stage, const std::vector<int>& dependencies, const bool critical)
+{
+    if (m_running)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Stage " + name + " added after startup began.");
+        return -1;
+    }
+
+    // only earlier stages can be depended on, so the graph cannot have a cycle
+    for (int dependency : dependencies)
+    {
+        if (dependency < 0 || dependency >= static_cast<int>(m_stages.size()))
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Error, "Stage " + name + " depends on an unknown stage.");
+            return -1;
+        }
+    }
+
+    Stage entry;
+    entry.body = std::move(stage);
+    entry.dependencies = dependencies;
+    entry.result.name = name;
+    entry.result.critical = critical;
+    m_stages.push_back(std::move(entry));
+
+    return static_cast<int>(m_stages.size()) - 1;
+}
+
+void StartupGraph::Run()
+{
+    if (m_running.exchange(true)) return;
+
+    m_runNs = MonotonicNowNs();
+
+    {
+        std::scoped_lock lock(m_mutex);
+        CheckReady();
+    }
+
+    m_threads.reserve(m_stages.size());
+    for (size_t i = 0; i < m_stages.size(); i++)
+    {
+        m_threads.emplace_back(&StartupGraph::RunStage, this, static_cast<int>(i));
+    }
+}
+
+bool StartupGraph::WaitReady()
+{
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this] { return m_ready.load(); });
+
+    for (const Stage& stage : m_stages)
+    {
+        if (stage.result.critical && stage.result.state != StageState::Succeeded) return false;
+    }
+    return true;
+}
+
+void StartupGraph::Wait()
+{
+    for (std::thread& thread : m_threads)
+    {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+std::vector<StartupGraph::StageResult> StartupGraph::GetResults()
+{
+    std::scoped_lock lock(m_mutex);
+
+    std::vector<StageResult> results;
+    results.reserve(m_stages.size());
+    for (const Stage& stage : m_stages)
+    {
+        results.push_back(stage.result);
+    }
+    return results;
+}
+
+void StartupGraph::RunStage(const int id)
+{
+    Stage& stage = m_stages[id];
+
+    // wait for the dependencies, give up on the first one that did not succeed
+    bool skip = false;
+    {
+        std::unique_lock lock(m_mutex);
+        m_changed.wait(lock, [&] {
+            for (int dependency : stage.dependencies)
+            {
+                if (!IsDone(m_stages[dependency].result.state)) return false;
+            }
+            return true;
+        });
+
+        for (int dependency : stage.dependencies)
+        {
+            if (m_stages[dependency].result.state != StageState::Succeeded) skip = true;
+        }
+
+        stage.result.waitNs = MonotonicNowNs() - m_runNs;
+        stage.result.state = skip ? StageState::Skipped : StageState::Running;
+        if (skip)
+        {
+            CheckReady();
+        }
+    }
+
+    if (skip)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, stage.result.name + " skipped, a stage it depends on failed.");
+        m_changed.notify_all();
+        return;
+    }
+
+    const int64_t start = MonotonicNowNs();
+    const bool success = stage.body();
+    const int64_t duration = MonotonicNowNs() - start;
+
+    {
+        std::scoped_lock lock(m_mutex);
+        stage.result.startNs = start;
+        stage.result.durationNs = duration;
+        stage.result.state = success ? StageState::Succeeded : StageState::Failed;
+        CheckReady();
+    }
+    m_changed.notify_all();
+
+    char timing[64];
+    std::snprintf(timing, sizeof(timing), " in %.1f ms", duration / 1.0e6);
+    m_logger.AddLog(m_name, success ? LogClient::LogLevel::Info : LogClient::LogLevel::Warning,
+        stage.result.name + (success ? " done" : " failed") + timing);
+}
+
+void StartupGraph::CheckReady()
+{
+    if (m_ready) return;
+
+    for (const Stage& stage : m_stages)
+    {
+        if (stage.result.critical && !IsDone(stage.result.state)) return;
+    }
+
+    m_readyNs = MonotonicNowNs() - m_runNs;
+    m_ready = true;
+
+    char timing[64];
+    std::snprintf(timing, sizeof(timing), "Ready in %.1f ms.", m_readyNs / 1.0e6);
+    m_logger.AddLog(m_name, LogClient::LogLevel::Info, timing);
+}
+
+bool StartupGraph::IsDone(const StageState state)
+{
+    return state == StageState::Succeeded || state == StageState::Failed || state == StageState::Skipped;
+}
@@ -0,0 +1,122 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            startup_graph.h
+// @brief           Runs startup stages concurrently in dependency order
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <string>                           // strings
+#include <vector>                           // stages
+#include <functional>                       // stage bodies
+#include <mutex>                            // mutex
+#include <condition_variable>               // dependency and ready waits
+#include <thread>                           // stage threads
+#include <atomic>                           // ready flag
+#include <cstdint>                          // standard ints
+//
+#include "log_client.h"                     // logger
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Startup stages run as a graph. Every stage gets its own thread and starts as soon
+/// as the stages it depends on have succeeded, a stage whose dependency failed is skipped.
+/// The graph is ready once every critical stage has finished, stages that are not critical
+/// keep running behind it.
+class StartupGraph
+{
+public:
+
+    /// @brief Where a stage is
+    enum class StageState
+    {
+        Pending,
+        Running,
+        Succeeded,
+        Failed,
+        Skipped,
+    };
+
+    /// @brief Outcome and timing of a stage
+    struct StageResult
+    {
+        std::string     name;
+        bool            critical    = true;
+        StageState      state       = StageState::Pending;
+        int64_t         startNs     = 0;        // monotonic time the stage started, 0 if it never ran
+        int64_t         durationNs  = 0;        // time the stage ran for
+        int64_t         waitNs      = 0;        // time from Run() until its dependencies were done
+    };
+
+    /// @brief Constructor
+    /// @param logger - [in] - logger for the stage timings
+    StartupGraph(LogClient& logger);
+
+    /// @brief Deconstructor, waits for every stage
+    ~StartupGraph();
+
+    /// @brief Add a stage, before Run()
+    /// @param name - [in] - stage name for the timings
+    /// @param stage - [in] - stage body, returns true on success
+    /// @param dependencies - [in/opt] - ids of the stages that must succeed first
+    /// @param critical - [in/opt] - the graph is not ready until this stage is done
+    /// @return stage id, -1 if the graph is already running or a dependency is unknown
+    int AddStage(const std::string& name, std::function<bool()> stage, const std::vector<int>& dependencies = {}, const bool critical = true);
+
+    /// @brief Start every stage
+    void Run();
+
+    /// @brief Check if every critical stage has finished
+    /// @return true once ready
+    bool IsReady() const { return m_ready; }
+
+    /// @brief Block until every critical stage has finished
+    /// @return true if every critical stage succeeded, else false
+    bool WaitReady();
+
+    /// @brief Block until every stage has finished and join the stage threads
+    void Wait();
+
+    /// @brief Get the outcome and timing of every stage
+    /// @return results in the order the stages were added
+    std::vector<StageResult> GetResults();
+
+    /// @brief Time from Run() until the graph was ready
+    /// @return ns, 0 until ready
+    int64_t GetReadyNs() const { return m_readyNs; }
+
+private:
+
+    /// @brief A stage and its place in the graph
+    struct Stage
+    {
+        std::function<bool()>   body;
+        std::vector<int>        dependencies;
+        StageResult             result;
+    };
+
+    /// @brief Stage thread body, waits on the dependencies then runs the stage
+    /// @param id - [in] - stage to run
+    void RunStage(const int id);
+
+    /// @brief Update the ready flag, call with m_mutex held
+    void CheckReady();
+
+    /// @brief Check if a stage is done, call with m_mutex held
+    static bool IsDone(const StageState state);
+
+    std::string                 m_name;             /// Name for logging
+    LogClient&                  m_logger;           /// Logger
+    std::vector<Stage>          m_stages;           /// Stages by id
+    std::vector<std::thread>    m_threads;          /// One per stage while running
+    std::mutex                  m_mutex;            /// Protects the stage results
+    std::condition_variable     m_changed;          /// Signalled as each stage finishes
+    std::atomic_bool            m_running;          /// Run() has been called
+    std::atomic_bool            m_ready;            /// Every critical stage has finished
+    int64_t                     m_runNs;            /// Monotonic time of Run()
+    std::atomic<int64_t>        m_readyNs;          /// Time from Run() until ready
+};
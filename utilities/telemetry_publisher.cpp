@@ -0,0 +1,338 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            telemetry_publisher.cpp
+// @brief           Implementation for the telemetry publisher
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cmath>                            // llround
+#include <algorithm>                        // copy
+//
+#include "telemetry_publisher.h"            // header
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    constexpr size_t BUFFER_RESERVE = 512;      // larger than a full message of any stream
+}
+
+TelemetryPublisher::TelemetryPublisher(WebServer& server) : m_server(server), m_writer(m_buffer), m_cborWriter(m_cborBuffer),
+    m_topics(), m_groups(), m_version(0), m_keyframeNs(1000000000), m_logsQueued(0), m_logsDropped(0)
+{
+    m_buffer.reserve(BUFFER_RESERVE);
+    m_cborBuffer.reserve(BUFFER_RESERVE);
+
+    for (size_t i = 0; i < STREAM_COUNT; i++)
+    {
+        const StreamInfo& info = Info(static_cast<Stream>(i));
+        m_topics[i] = m_server.AddTopic(info.name, info.defaultRateHz);
+    }
+
+    // Groups are built on the first send
+    m_version = m_server.GetSubscriptionVersion() - 1;
+}
+
+const TelemetryPublisher::StreamInfo& TelemetryPublisher::Info(const Stream stream)
+{
+    static constexpr FieldInfo GPS[] =
+    {
+        { "hour",           true    },
+        { "min",            true    },
+        { "sec",            true    },
+        { "latitude",       false   },
+        { "longitude",      false   },
+        { "altitude",       false   },
+    };
+
+    static constexpr FieldInfo IMU[] =
+    {
+        { "roll",           false   },
+        { "pitch",          false   },
+        { "yaw",            false   },
+        { "gyroX",          false   },
+        { "gyroY",          false   },
+        { "gyroZ",          false   },
+        { "accelX",         false   },
+        { "accelY",         false   },
+        { "accelZ",         false   },
+        { "temperature",    false   },
+    };
+
+    static constexpr FieldInfo FINS[] =
+    {
+        { "fin1",           false   },
+        { "fin2",           false   },
+        { "fin3",           false   },
+        { "fin4",           false   },
+        { "frames",         true    },
+        { "writes",         true    },
+        { "writeErrors",    true    },
+        { "missedTicks",    true    },
+    };
+
+    static constexpr FieldInfo HEALTH[] =
+    {
+        { "gpsFix",         true    },
+        { "gpsRateHz",      false   },
+        { "gpsDropped",     true    },
+        { "imuDropped",     true    },
+        { "imuErrors",      true    },
+        { "navInitialized", true    },
+    };
+
+    static constexpr FieldInfo TARGET[] =
+    {
+        { "range",          false   },
+        { "bearing",        false   },
+        { "north",          false   },
+        { "east",           false   },
+        { "down",           false   },
+    };
+
+    static_assert(std::size(IMU) <= MAX_FIELDS && std::size(FINS) <= MAX_FIELDS, "stream has more than MAX_FIELDS");
+
+    // Stream order, logs are lines sent by PublishLogs() and have no fields
+    static const StreamInfo STREAMS[STREAM_COUNT] =
+    {
+        { "gps",        10, GPS     },
+        { "logs",       10, {}      },
+        { "imu",        0,  IMU     },
+        { "fins",       0,  FINS    },
+        { "health",     0,  HEALTH  },
+        { "target",     0,  TARGET  },
+    };
+
+    return STREAMS[static_cast<size_t>(stream)];
+}
+
+bool TelemetryPublisher::SetRate(const int rateHz)
+{
+    if (rateHz <= 0 || rateHz > WebServer::MAX_RATE_HZ) return false;
+
+    return m_server.SetTopicDefaultRate(m_topics[static_cast<size_t>(Stream::Gps)], rateHz);
+}
+
+void TelemetryPublisher::SetKeyframeInterval(const int intervalMs)
+{
+    m_keyframeNs = intervalMs > 0 ? static_cast<int64_t>(intervalMs) * 1000000 : 0;
+}
+
+void TelemetryPublisher::Refresh()
+{
+    const uint64_t version = m_server.GetSubscriptionVersion();
+    if (version == m_version) return;
+    m_version = version;
+
+    for (size_t i = 0; i < STREAM_COUNT; i++)
+    {
+        std::vector<GroupState> groups;
+        for (const int rateHz : m_server.GetSubscriptionRates(m_topics[i]))
+        {
+            // A group that carries on keeps its schedule, a client may have joined it so it starts
+            // over with a full message
+            GroupState group;
+            for (const GroupState& existing : m_groups[i])
+            {
+                if (existing.rateHz == rateHz) group = existing;
+            }
+            group.rateHz = rateHz;
+            group.periodNs = 1000000000LL / rateHz;
+            group.anySent = false;
+            groups.push_back(group);
+        }
+        m_groups[i] = std::move(groups);
+    }
+}
+
+bool TelemetryPublisher::IsDue(const Stream stream, const int64_t nowNs)
+{
+    Refresh();
+
+    for (const GroupState& group : m_groups[static_cast<size_t>(stream)])
+    {
+        if (nowNs >= group.nextNs) return true;
+    }
+
+    return false;
+}
+
+int TelemetryPublisher::Publish(const Stream stream, std::span<const double> values, const int64_t nowNs)
+{
+    const size_t index = static_cast<size_t>(stream);
+    const std::span<const FieldInfo> fields = Info(stream).fields;
+    if (values.size() != fields.size() || fields.empty()) return -1;
+
+    Refresh();
+
+    int clients = 0;
+    for (GroupState& group : m_groups[index])
+    {
+        if (nowNs < group.nextNs) continue;
+
+        // Hold the schedule, sends missed by a slow pass are dropped rather than made back to back
+        group.nextNs += group.periodNs;
+        if (group.nextNs <= nowNs) group.nextNs = nowNs + group.periodNs;
+
+        bool keyframe = !group.anySent || (m_keyframeNs > 0 && nowNs >= group.nextKeyframeNs);
+        if (!keyframe && m_server.TakeResync(m_topics[index], group.rateHz))
+        {
+            keyframe = true;
+            m_stats.resyncs++;
+        }
+
+        const int64_t start = MonotonicNowNs();
+
+        // CBOR maps are sized up front, so find the changed fields before writing either encoding
+        std::array<bool, MAX_FIELDS> changed = {};
+        uint64_t count = 0;
+        for (size_t i = 0; i < fields.size(); i++)
+        {
+            changed[i] = keyframe || values[i] != group.sent[i];
+            if (changed[i]) count++;
+        }
+
+        if (count == 0)
+        {
+            m_stats.serialize.Record(MonotonicNowNs() - start);
+            m_stats.framesUnchanged++;
+            continue;
+        }
+
+        Write(stream, values, changed, count);
+        m_stats.serialize.Record(MonotonicNowNs() - start);
+
+        std::copy(values.begin(), values.end(), group.sent.begin());
+        group.anySent = true;
+        if (keyframe) group.nextKeyframeNs = nowNs + m_keyframeNs;
+
+        m_stats.framesSent++;
+        m_stats.fieldsSent += count;
+
+        // Written once for the group, a newer message supersedes one a slow member has not been sent yet
+        clients += m_server.SendToSubscribers(m_topics[index], group.rateHz, m_buffer, m_cborBuffer, WebServer::SendPolicy::Latest, keyframe);
+    }
+
+    return clients;
+}
+
+void TelemetryPublisher::Write(const Stream stream, std::span<const double> values, const std::array<bool, MAX_FIELDS>& changed, const uint64_t count)
+{
+    const StreamInfo& info = Info(stream);
+
+    m_writer.Reset();
+    m_writer.BeginObject().Key(info.name).BeginObject();
+    m_cborWriter.Reset();
+    m_cborWriter.BeginMap(1).Integer(static_cast<int64_t>(stream)).BeginMap(count);
+
+    for (size_t i = 0; i < info.fields.size(); i++)
+    {
+        if (!changed[i]) continue;
+
+        m_writer.Key(info.fields[i].name);
+        m_cborWriter.Integer(static_cast<int64_t>(i));
+        if (info.fields[i].integer)
+        {
+            const int64_t value = std::llround(values[i]);
+            m_writer.Integer(value);
+            m_cborWriter.Integer(value);
+        }
+        else
+        {
+            m_writer.Number(values[i]);
+            m_cborWriter.Number(values[i]);
+        }
+    }
+
+    m_writer.EndObject().EndObject();
+}
+
+void TelemetryPublisher::QueueMessage(const std::string& text, const int timeoutSec)
+{
+    std::lock_guard<std::mutex> lock(m_logMutex);
+
+    // Bounded for a group that stops keeping up, it loses its oldest lines
+    if (m_logs.size() >= MAX_QUEUED_LOGS)
+    {
+        m_logs.pop_front();
+        m_logsDropped++;
+    }
+
+    m_logs.push_back({ text, timeoutSec });
+    m_logsQueued++;
+}
+
+int TelemetryPublisher::PublishLogs(const int64_t nowNs)
+{
+    const size_t index = static_cast<size_t>(Stream::Logs);
+
+    Refresh();
+
+    int clients = 0;
+    for (GroupState& group : m_groups[index])
+    {
+        if (nowNs < group.nextNs) continue;
+
+        // Copied out so the queue is not held while sending, the logger thread adds to it
+        {
+            std::lock_guard<std::mutex> lock(m_logMutex);
+
+            // A new group starts at the oldest line still queued
+            const uint64_t first = m_logsQueued - m_logs.size();
+            if (group.nextLog < first) group.nextLog = first;
+
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(m_logsQueued - group.nextLog, MAX_LOG_LINES));
+            if (count == 0) continue;
+
+            const auto begin = m_logs.begin() + static_cast<ptrdiff_t>(group.nextLog - first);
+            m_logBatch.assign(begin, begin + static_cast<ptrdiff_t>(count));
+        }
+
+        group.nextLog += m_logBatch.size();
+        group.nextNs = nowNs + group.periodNs;
+
+        WriteLogs();
+        m_stats.logsSent += m_logBatch.size();
+
+        clients += m_server.SendToSubscribers(m_topics[index], group.rateHz, m_buffer, m_cborBuffer, WebServer::SendPolicy::Queued);
+    }
+
+    // Lines every group has been sent are done with, all of them when nobody subscribes
+    std::lock_guard<std::mutex> lock(m_logMutex);
+
+    uint64_t oldest = m_logsQueued;
+    for (const GroupState& group : m_groups[index]) oldest = std::min(oldest, group.nextLog);
+
+    uint64_t first = m_logsQueued - m_logs.size();
+    for (; first < oldest && !m_logs.empty(); first++) m_logs.pop_front();
+
+    m_stats.logsDropped = m_logsDropped;
+
+    return clients;
+}
+
+void TelemetryPublisher::WriteLogs()
+{
+    // One timeout for the message, long enough for every line in it
+    int timeoutSec = 0;
+    for (const LogLine& line : m_logBatch) timeoutSec = std::max(timeoutSec, line.timeoutSec);
+
+    m_writer.Reset();
+    m_writer.BeginObject().Key(Info(Stream::Logs).name).BeginObject().Key("lines").BeginArray();
+    m_cborWriter.Reset();
+    m_cborWriter.BeginMap(1).Integer(static_cast<int64_t>(Stream::Logs)).BeginMap(2)
+        .Integer(KEY_LINES).BeginArray(m_logBatch.size());
+
+    for (const LogLine& line : m_logBatch)
+    {
+        m_writer.String(line.text);
+        m_cborWriter.String(line.text);
+    }
+
+    m_writer.EndArray().Key("timeout").Integer(timeoutSec).EndObject().EndObject();
+    m_cborWriter.Integer(KEY_TIMEOUT).Integer(timeoutSec);
+}
@@ -0,0 +1,194 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            telemetry_publisher.h
+// @brief           Fixed rate, change driven telemetry to the web clients
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <string>                           // strings
+#include <array>                            // frames
+#include <vector>                           // groups
+#include <deque>                            // queued logs
+#include <mutex>                            // queued logs
+#include <span>                             // field values
+#include <cstdint>                          // standard ints
+//
+#include "web_server.h"                     // websocket clients
+#include "json_writer.h"                    // serialization
+#include "cbor_writer.h"                    // binary serialization
+#include "rx_timing.h"                      // serialize timing
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Sends the telemetry streams the web clients subscribe to. Each client names the
+/// streams it wants and a max rate, clients on the same stream and rate form a group and every
+/// group is written once and shared by its members. Publish() is called every pass of the main
+/// loop and sends to the groups that are due, holding only the fields that changed since that
+/// group's last send. Every keyframe interval, and whenever the groups change, all fields are
+/// sent so a client that just joined fills in. A slow client can have a message replaced before
+/// it is written, and the changes in it would be lost, so the group's next message after that
+/// holds every field.
+///
+/// Each message is also written as CBOR for clients that asked for binary frames. The binary
+/// schema keys everything by number so frames carry no names, and numbers only ever get added:
+///     stream message      { Stream: { field index: value, ... } }
+///     logs message        { 1: { 0: [ text, ... ], 1: timeout } }
+/// Integer fields are CBOR integers, the rest are floats.
+class TelemetryPublisher
+{
+public:
+
+    /// @brief Streams the clients subscribe to. Values are the binary keys, append only
+    enum class Stream
+    {
+        Gps,
+        Logs,
+        Imu,
+        Fins,
+        Health,
+        Target,
+        Count
+    };
+
+    /// @brief Most fields a stream carries
+    static constexpr size_t MAX_FIELDS = 16;
+
+    /// @brief Sending counts and cost
+    struct TelemetryStats
+    {
+        uint64_t            framesSent      = 0;        // messages sent, one per group
+        uint64_t            framesUnchanged = 0;        // sends due with nothing changed
+        uint64_t            fieldsSent      = 0;        // fields across every message
+        uint64_t            logsSent        = 0;        // logs lines across every message
+        uint64_t            logsDropped     = 0;        // logs lines dropped from a full queue
+        uint64_t            resyncs         = 0;        // complete messages sent because a slow client had a change replaced
+        LatencyHistogram    serialize       = {};       // time to write a message
+    };
+
+    /// @brief Constructor, registers the streams as websocket topics
+    /// @param server - [in] - web server the clients are connected to
+    TelemetryPublisher(WebServer& server);
+
+    /// @brief Set the GPS rate a client gets until it subscribes
+    /// @param rateHz - [in] - messages per second at most
+    /// @return true if set, false if out of range
+    bool SetRate(const int rateHz);
+
+    /// @brief Set how often every field is sent
+    /// @param intervalMs - [in] - ms between full messages, 0 to send only changes
+    void SetKeyframeInterval(const int intervalMs);
+
+    /// @brief Check whether a send of a stream is due, so its values are only gathered when needed
+    /// @param stream - [in] - stream to check
+    /// @param nowNs - [in] - monotonic time
+    /// @return true if a group of the stream is due
+    bool IsDue(const Stream stream, const int64_t nowNs);
+
+    /// @brief Send the fields that changed to every group of a stream that is due
+    /// @param stream - [in] - stream the values are for
+    /// @param values - [in] - current value of every field, the stream's field order
+    /// @param nowNs - [in] - monotonic time
+    /// @return clients sent to, 0 if nothing was sent, -1 if values is the wrong size
+    int Publish(const Stream stream, std::span<const double> values, const int64_t nowNs);
+
+    /// @brief Queue a line of text for the logs stream, sent in order by PublishLogs(). Safe to
+    /// call from any thread.
+    /// @param text - [in] - line
+    /// @param timeoutSec - [in] - seconds the page shows it for
+    void QueueMessage(const std::string& text, const int timeoutSec);
+
+    /// @brief Send every logs group that is due the lines it has not had yet, together in one
+    /// message so a burst of logs is held back to the group's rate rather than dropped
+    /// @param nowNs - [in] - monotonic time
+    /// @return clients sent to
+    int PublishLogs(const int64_t nowNs);
+
+    /// @brief Get the sending counts
+    /// @return stats
+    const TelemetryStats& GetStats() const { return m_stats; }
+
+private:
+
+    /// @brief Binary keys of the logs message
+    static constexpr int64_t KEY_LINES      = 0;
+    static constexpr int64_t KEY_TIMEOUT    = 1;
+
+    /// @brief Most lines in one logs message, the rest wait for the group's next send
+    static constexpr size_t MAX_LOG_LINES = 32;
+
+    /// @brief Lines held for groups that have not been sent them before the oldest is dropped
+    static constexpr size_t MAX_QUEUED_LOGS = 512;
+
+    static constexpr size_t STREAM_COUNT = static_cast<size_t>(Stream::Count);
+
+    /// @brief Name of a field and whether it is written as an integer
+    struct FieldInfo
+    {
+        const char*     name;
+        bool            integer;
+    };
+
+    /// @brief A stream's topic name and fields
+    struct StreamInfo
+    {
+        const char*                 name;
+        int                         defaultRateHz;      // rate a client gets until it subscribes
+        std::span<const FieldInfo>  fields;
+    };
+
+    /// @brief Sending state of the clients on one stream at one rate
+    struct GroupState
+    {
+        int                                 rateHz          = 0;
+        int64_t                             periodNs        = 0;
+        int64_t                             nextNs          = 0;        // time the next send is due
+        int64_t                             nextKeyframeNs  = 0;        // time the next full message is due
+        bool                                anySent         = false;    // a full message has been sent
+        uint64_t                            nextLog         = 0;        // logs only, number of the first line not sent
+        std::array<double, MAX_FIELDS>      sent            = {};       // values last sent
+    };
+
+    /// @brief Get the topic name and fields of a stream
+    static const StreamInfo& Info(const Stream stream);
+
+    /// @brief A line queued for the logs stream
+    struct LogLine
+    {
+        std::string     text;
+        int             timeoutSec;
+    };
+
+    /// @brief Match the groups to the server's subscriptions if they changed
+    void Refresh();
+
+    /// @brief Write m_logBatch as one logs message into both buffers
+    void WriteLogs();
+
+    /// @brief Write one stream message into both buffers
+    /// @param stream - [in] - stream
+    /// @param values - [in] - every field
+    /// @param changed - [in] - fields to write
+    /// @param count - [in] - number of changed fields
+    void Write(const Stream stream, std::span<const double> values, const std::array<bool, MAX_FIELDS>& changed, const uint64_t count);
+
+    WebServer&          m_server;               /// Clients
+    std::string         m_buffer;               /// Message, reused so sends do not allocate
+    JsonWriter          m_writer;               /// Writes into m_buffer
+    std::string         m_cborBuffer;           /// Message as CBOR, reused the same way
+    CborWriter          m_cborWriter;           /// Writes into m_cborBuffer
+    std::array<int, STREAM_COUNT>               m_topics;       /// Websocket topic id per stream
+    std::array<std::vector<GroupState>, STREAM_COUNT> m_groups; /// Groups per stream
+    uint64_t            m_version;              /// Subscription version the groups match
+    int64_t             m_keyframeNs;           /// Time between full messages, 0 for never
+    TelemetryStats      m_stats;                /// Sending counts
+    std::vector<LogLine> m_logBatch;            /// Lines for the logs message being written
+    std::mutex          m_logMutex;             /// Protects the three below
+    std::deque<LogLine> m_logs;                 /// Lines some group has not been sent, oldest first
+    uint64_t            m_logsQueued;           /// Lines ever queued, the number of the next one
+    uint64_t            m_logsDropped;          /// Lines dropped from a full queue
+};
@@ -0,0 +1,148 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            time_history.h
+// @brief           Lock free time indexed history of a data stream
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <cstdint>                          // standard ints
+//
+#include "seqlock_ring.h"                   // value slots
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief The last Capacity values of a stream keyed on MonotonicNowNs() time. One thread
+/// pushes, any number of threads look values up at a time without blocking it. The values are
+/// held in a SeqlockRing. Times must not go backwards, so a lookup is a binary search over the
+/// held values.
+/// @tparam T - value type, trivially copyable
+/// @tparam Capacity - values held, a power of two. Size it as stream rate times the seconds needed.
+template <typename T, size_t Capacity>
+class TimeHistory
+{
+    static_assert(Capacity >= 4 && (Capacity & (Capacity - 1)) == 0, "TimeHistory capacity must be a power of two");
+
+public:
+
+    /// @brief A value and its time
+    struct Entry
+    {
+        int64_t     timeNs  = 0;
+        T           value   = {};
+    };
+
+    /// @brief Constructor
+    /// @param horizonNs - [in/opt] - lookups further than this behind the newest value fail, 0 for the whole ring
+    explicit TimeHistory(const int64_t horizonNs = 0) : m_horizonNs(horizonNs) {}
+
+    /// @brief Producer side. Add the newest value.
+    /// @param timeNs - [in] - monotonic time of the value
+    /// @param value - [in] - value
+    /// @return true if added, false if older than the newest value
+    bool Push(const int64_t timeNs, const T& value)
+    {
+        if (m_ring.Count() > 0 && timeNs < m_newestNs) return false;
+
+        m_ring.Write({ timeNs, value });
+        m_newestNs = timeNs;
+        return true;
+    }
+
+    /// @brief Get the newest value
+    /// @param entry - [out] - newest value and its time
+    /// @return true if a value was read, false if empty
+    bool Latest(Entry& entry) const { return m_ring.Latest(entry); }
+
+    /// @brief Find the values either side of a time
+    /// @param timeNs - [in] - time to look up
+    /// @param before - [out] - newest value at or before the time
+    /// @param after - [out] - oldest value at or after the time, the same as before on an exact match
+    /// @return true if the time is inside the history, else false
+    bool Bracket(const int64_t timeNs, Entry& before, Entry& after) const
+    {
+        // the writer may lap a slow search, start again on the current ring when it does
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++)
+        {
+            const uint64_t count = m_ring.Count();
+            if (count == 0) return false;
+
+            // the slot after the newest is the next one written, leave it out
+            uint64_t low = count > Capacity - 1 ? count - (Capacity - 1) : 0;
+            uint64_t high = count - 1;
+
+            int64_t lowTime = 0;
+            int64_t highTime = 0;
+            if (!m_ring.ReadMember(low, &Entry::timeNs, lowTime) || !m_ring.ReadMember(high, &Entry::timeNs, highTime)) continue;
+
+            if (timeNs > highTime) return false;
+            if (m_horizonNs > 0 && timeNs < highTime - m_horizonNs) return false;
+            if (timeNs < lowTime) return false;
+
+            // newest index with a time at or before timeNs
+            bool torn = false;
+            while (low < high)
+            {
+                const uint64_t mid = low + (high - low + 1) / 2;
+                int64_t midTime = 0;
+                if (!m_ring.ReadMember(mid, &Entry::timeNs, midTime)) { torn = true; break; }
+
+                if (midTime <= timeNs) low = mid;
+                else high = mid - 1;
+            }
+            if (torn) continue;
+
+            if (!m_ring.Read(low, before)) continue;
+            if (before.timeNs == timeNs || low + 1 >= count)
+            {
+                after = before;
+                return true;
+            }
+            if (!m_ring.Read(low + 1, after)) continue;
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief Get the value at a time, interpolated between the values either side of it.
+    /// Uses an Interpolate(const T& from, const T& to, double fraction) found for T.
+    /// @param timeNs - [in] - time to look up
+    /// @param value - [out] - value at the time
+    /// @return true if the time is inside the history, else false
+    bool At(const int64_t timeNs, T& value) const
+    {
+        Entry before;
+        Entry after;
+        if (!Bracket(timeNs, before, after)) return false;
+
+        if (after.timeNs == before.timeNs)
+        {
+            value = before.value;
+            return true;
+        }
+
+        const double fraction = static_cast<double>(timeNs - before.timeNs) / static_cast<double>(after.timeNs - before.timeNs);
+        value = Interpolate(before.value, after.value, fraction);
+        return true;
+    }
+
+    /// @brief Number of values pushed since construction
+    /// @return count
+    uint64_t Count() const { return m_ring.Count(); }
+
+    /// @brief Number of values held
+    /// @return capacity
+    static constexpr size_t GetCapacity() { return Capacity; }
+
+private:
+
+    static constexpr int MAX_ATTEMPTS = 4;
+
+    int64_t                                     m_horizonNs     = 0;    /// Lookups further back fail, 0 for none
+    int64_t                                     m_newestNs      = 0;    /// Newest time, producer owned
+    SeqlockRing<Entry, Capacity>                m_ring;                 /// Values and their times, by push index
+};
@@ -0,0 +1,132 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            topic.h
+// @brief           Lock free single producer, multiple subscriber topic
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// Includes:
+//          name                            reason included
+//          ------------------              ------------------------
+#include <algorithm>                        // min
+#include <cstdint>                          // standard ints
+//
+#include "seqlock_ring.h"                   // message slots
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief The last Capacity messages of a stream. One thread publishes, any number of
+/// Subscribers read at their own pace without the publisher knowing about them, so a publish
+/// costs one slot copy however many subscribers there are. The slots are a SeqlockRing.
+/// @tparam T - message type, trivially copyable
+/// @tparam Capacity - messages held, a power of two. Size it for the slowest queued subscriber.
+template <typename T, size_t Capacity>
+class Topic
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Topic capacity must be a power of two");
+
+public:
+
+    /// @brief Producer side. Publish a message.
+    /// @param message - [in] - message
+    void Publish(const T& message) { m_ring.Write(message); }
+
+    /// @brief Number of messages published since construction
+    /// @return count
+    uint64_t Count() const { return m_ring.Count(); }
+
+    /// @brief Read a message
+    /// @param index - [in] - publish index of the message
+    /// @param message - [out] - message
+    /// @return true if the message was still held and was not written during the copy
+    bool Read(const uint64_t index, T& message) const { return m_ring.Read(index, message); }
+
+    /// @brief Number of messages held
+    /// @return capacity
+    static constexpr size_t GetCapacity() { return Capacity; }
+
+private:
+
+    SeqlockRing<T, Capacity>    m_ring;     /// Messages, by publish index
+};
+
+/// @brief How a Subscriber is handed messages
+enum class Delivery
+{
+    Latest,     // only the newest message, anything published in between is skipped
+    Queued,     // every message in order, messages the publisher laps before they are read are dropped
+};
+
+/// @brief One reader of a Topic. It holds its own cursor so subscribers never touch each
+/// other or the publisher. A subscriber is used from one thread.
+template <typename T, size_t Capacity>
+class Subscriber
+{
+public:
+
+    /// @brief Constructor, starts after the messages already published
+    /// @param topic - [in] - topic to read
+    /// @param delivery - [in] - latest value or queued delivery
+    Subscriber(const Topic<T, Capacity>& topic, const Delivery delivery) :
+        m_topic(topic), m_delivery(delivery), m_cursor(topic.Count())
+    {
+    }
+
+    /// @brief Take the next message
+    /// @param message - [out] - newest message for Latest, oldest unread message for Queued
+    /// @return true if a message was taken, false if there is nothing new
+    bool Poll(T& message)
+    {
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++)
+        {
+            const uint64_t count = m_topic.Count();
+            if (m_cursor >= count) return false;
+
+            uint64_t index = m_cursor;
+            if (m_delivery == Delivery::Latest)
+            {
+                index = count - 1;
+            }
+            else if (count - m_cursor > Capacity - 1)
+            {
+                // the slot after the newest is the next one written, leave it out
+                index = count - (Capacity - 1);
+                m_dropped += index - m_cursor;
+                m_cursor = index;
+            }
+
+            if (m_topic.Read(index, message))
+            {
+                m_cursor = index + 1;
+                return true;
+            }
+
+            // the publisher lapped the slot during the copy, look again at what is held now
+        }
+        return false;
+    }
+
+    /// @brief Number of unread messages, capped at what the topic holds
+    /// @return count
+    uint64_t Pending() const
+    {
+        const uint64_t count = m_topic.Count();
+        if (m_cursor >= count) return 0;
+        return std::min<uint64_t>(count - m_cursor, Capacity - 1);
+    }
+
+    /// @brief Number of messages a queued subscriber lost to the publisher lapping it
+    /// @return count
+    uint64_t Dropped() const { return m_dropped; }
+
+private:
+
+    static constexpr int MAX_ATTEMPTS = 4;
+
+    const Topic<T, Capacity>&   m_topic;            /// Topic read
+    Delivery                    m_delivery;         /// Latest value or queued
+    uint64_t                    m_cursor    = 0;    /// Publish index of the next message to read
+    uint64_t                    m_dropped   = 0;    /// Queued messages lost to laps
+};
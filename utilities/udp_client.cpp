@@ -183,7 +183,7 @@ int8_t UdpClient::EnableBroadcastSender(const int16_t port)
 	m_broadcastAddr.sin_addr.s_addr = INADDR_BROADCAST;
 
 	// set broadcast option
-	int8_t broadcast = 1;
+	int broadcast = 1;
 	if (setsockopt(m_broadcastSocket, SOL_SOCKET, SO_BROADCAST, (char*)&broadcast, sizeof(broadcast)) < 0)
 	{
 		m_lastError = ErrorCode::ENABLE_BROADCAST_FAILED;
@@ -289,7 +289,7 @@ int8_t UdpClient::AddMulticastGroup(const std::string& groupIP, const int16_t gr
 	}
 
 	// Enable SO_REUSEADDR to allow multiple sockets to bind to the same address
-	int8_t reuseAddr = 1;
+	int reuseAddr = 1;
 	if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuseAddr, sizeof(reuseAddr)) == SOCKET_ERROR)
 	{
 		closesocket(sock);
@@ -419,7 +419,7 @@ int8_t UdpClient::OpenUnicast()
 	}
 #endif
 	// Set reuseable address. 
-	int8_t opt = 1;
+	int opt = 1;
 	if (setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt)) < 0)
 	{
 		m_lastError = ErrorCode::ENABLE_REUSEADDR_FAILED;
@@ -570,7 +570,7 @@ int8_t UdpClient::SendMulticast(const char* buffer, const uint32_t size, const s
 	return -1;
 }
 
-int8_t UdpClient::ReceiveUnicast(void* buffer, const uint32_t maxSize)
+int32_t UdpClient::ReceiveUnicast(void* buffer, const uint32_t maxSize)
 {
 	// Store the data source info
 	sockaddr_in sourceAddress{};
@@ -619,9 +619,9 @@ int8_t UdpClient::ReceiveUnicast(void* buffer, const uint32_t maxSize)
 	return sizeRead;
 }
 
-int8_t UdpClient::ReceiveUnicast(void* buffer, const uint32_t maxSize, std::string& recvFromAddr, int16_t& recvFromPort)
+int32_t UdpClient::ReceiveUnicast(void* buffer, const uint32_t maxSize, std::string& recvFromAddr, int16_t& recvFromPort)
 {
-	int8_t rtn = ReceiveUnicast(buffer, maxSize);
+	int32_t rtn = ReceiveUnicast(buffer, maxSize);
 
 	if (rtn > 0)
 	{
@@ -632,7 +632,7 @@ int8_t UdpClient::ReceiveUnicast(void* buffer, const uint32_t maxSize, std::stri
 	return rtn;;
 }
 
-int8_t UdpClient::ReceiveBroadcast(void* buffer, const uint32_t maxSize)
+int32_t UdpClient::ReceiveBroadcast(void* buffer, const uint32_t maxSize)
 {
 	if (m_broadcastListeners.size() > 0)
 	{
@@ -702,7 +702,7 @@ int8_t UdpClient::ReceiveBroadcast(void* buffer, const uint32_t maxSize)
 	return -1;
 }
 
-int8_t UdpClient::ReceiveBroadcast(void* buffer, const uint32_t maxSize, int16_t& port)
+int32_t UdpClient::ReceiveBroadcast(void* buffer, const uint32_t maxSize, int16_t& port)
 {
 	int rtn = ReceiveBroadcast(buffer, maxSize);
 
@@ -713,7 +713,7 @@ int8_t UdpClient::ReceiveBroadcast(void* buffer, const uint32_t maxSize, int16_t
 	return rtn;
 }
 
-int8_t UdpClient::ReceiveBroadcastFromListenerPort(void* buffer, const uint32_t maxSize, const int16_t port)
+int32_t UdpClient::ReceiveBroadcastFromListenerPort(void* buffer, const uint32_t maxSize, const int16_t port)
 {
 	if (m_broadcastListeners.size() > 0)
 	{
@@ -790,7 +790,7 @@ int8_t UdpClient::ReceiveBroadcastFromListenerPort(void* buffer, const uint32_t
 	return -1;
 }
 
-int8_t UdpClient::ReceiveMulticast(void* buffer, const uint32_t maxSize, std::string& multicastGroup)
+int32_t UdpClient::ReceiveMulticast(void* buffer, const uint32_t maxSize, std::string& multicastGroup)
 {
 	if (m_multicastSockets.size() > 0)
 	{
@@ -865,6 +865,91 @@ int8_t UdpClient::ReceiveMulticast(void* buffer, const uint32_t maxSize, std::st
 	return -1;
 }
 
+int32_t UdpClient::ReceiveBatch(uint8_t* buffer, const uint32_t slotSize, const uint32_t maxDatagrams, uint32_t* lengths)
+{
+	if (m_socket == INVALID_SOCKET)
+	{
+		m_lastError = ErrorCode::READ_FAILED;
+		return -1;
+	}
+
+	if (buffer == nullptr || lengths == nullptr || slotSize == 0 || maxDatagrams == 0) return 0;
+
+#ifdef __linux__
+	// One syscall for the whole batch. The headers are kept so the hot path never allocates.
+	if (m_batchHeaders.size() < maxDatagrams)
+	{
+		m_batchHeaders.resize(maxDatagrams);
+		m_batchVectors.resize(maxDatagrams);
+	}
+
+	for (uint32_t i = 0; i < maxDatagrams; i++)
+	{
+		m_batchVectors[i].iov_base = buffer + static_cast<size_t>(i) * slotSize;
+		m_batchVectors[i].iov_len = slotSize;
+		m_batchHeaders[i] = {};
+		m_batchHeaders[i].msg_hdr.msg_iov = &m_batchVectors[i];
+		m_batchHeaders[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int received = recvmmsg(m_socket, m_batchHeaders.data(), maxDatagrams, MSG_DONTWAIT, nullptr);
+
+	if (received == -1)
+	{
+		if (errno != EWOULDBLOCK && errno != EAGAIN)
+		{
+			m_lastError = ErrorCode::READ_FAILED;
+			return -1;
+		}
+		return 0;
+	}
+
+	for (int i = 0; i < received; i++)
+	{
+		lengths[i] = m_batchHeaders[i].msg_len;
+	}
+
+	return received;
+#else
+	// No batched receive here, drain the nonblocking socket one datagram at a time
+	int32_t received = 0;
+	while (static_cast<uint32_t>(received) < maxDatagrams)
+	{
+		uint8_t* slot = buffer + static_cast<size_t>(received) * slotSize;
+#if defined WIN32
+		int32_t sizeRead = recv(m_socket, reinterpret_cast<char*>(slot), slotSize, 0);
+#else
+		int32_t sizeRead = recv(m_socket, slot, slotSize, 0);
+#endif
+
+		if (sizeRead == SOCKET_ERROR)
+		{
+#ifdef WIN32
+			int errorCode = WSAGetLastError();
+			if (errorCode == WSAEMSGSIZE)
+			{
+				// Truncated to the slot, the parser rejects what is missing
+				lengths[received++] = slotSize;
+				continue;
+			}
+			if (errorCode != WSAEWOULDBLOCK)
+#else
+			if (errno != EWOULDBLOCK && errno != EAGAIN)
+#endif
+			{
+				m_lastError = ErrorCode::READ_FAILED;
+				return received > 0 ? received : -1;
+			}
+			break;
+		}
+
+		lengths[received++] = static_cast<uint32_t>(sizeRead);
+	}
+
+	return received;
+#endif
+}
+
 void UdpClient::CloseUnicast()
 {
 	closesocket(m_socket);
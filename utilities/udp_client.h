@@ -21,6 +21,7 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/uio.h>					// iovec for batched receives
 typedef int SOCKET;
 typedef struct sockaddr_in SOCKADDR_IN;
 typedef struct sockaddr SOCKADDR;
@@ -32,6 +33,8 @@ const int SD_BOTH = SHUT_RDWR;
 #include <map>							// Error enum to strings.
 #include <string>						// Strings
 #include <regex>						// Regular expression for ip validation
+#include <vector>						// Socket lists and batch headers
+#include <tuple>						// Socket list entries
 //
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -183,7 +186,7 @@ public:
 	/// @param buffer -[out]- Buffer to place received data into
 	/// @param maxSize -[in]- Maximum number of bytes to be read
 	/// @return 0+ if successful (number bytes received), -1 if fails. Call GetLastError() to find out more.
-	int8_t ReceiveUnicast(void* buffer, const uint32_t maxSize);
+	int32_t ReceiveUnicast(void* buffer, const uint32_t maxSize);
 
 	/// @brief Receive data from a server and get the IP and Port of the sender
 	/// @param "buffer"> -[out]- Buffer to place received data into
@@ -191,34 +194,43 @@ public:
 	/// @param "recvFromAddr"> -[out]- IP Address of the sender
 	/// @param "recvFromPort"> -[out]- Port of the sender
 	/// @return 0+ if successful (number bytes received), -1 if fails. Call GetLastError() to find out more.
-	int8_t ReceiveUnicast(void* buffer, const uint32_t maxSize, std::string& recvFromAddr, int16_t& recvFromPort);
+	int32_t ReceiveUnicast(void* buffer, const uint32_t maxSize, std::string& recvFromAddr, int16_t& recvFromPort);
 
 	/// @brief Receive a broadcast message
 	/// @param buffer -[out]- Buffer to place received data into
 	/// @param maxSize -[in]- Maximum number of bytes to be read
 	/// @return 0+ if successful (number bytes received), -1 if fails. Call GetLastError() to find out more.
-	int8_t ReceiveBroadcast(void* buffer, const uint32_t maxSize);
+	int32_t ReceiveBroadcast(void* buffer, const uint32_t maxSize);
 
 	/// @brief Receive a broadcast message
 	/// @param buffer -[out]- Buffer to place received data into
 	/// @param maxSize -[in]- Maximum number of bytes to be read
 	/// @param port -[out]- Port the broadcast was received from
 	/// @return 0+ if successful (number bytes received), -1 if fails. Call GetLastError() to find out more.
-	int8_t ReceiveBroadcast(void* buffer, const uint32_t maxSize, int16_t& port);
+	int32_t ReceiveBroadcast(void* buffer, const uint32_t maxSize, int16_t& port);
 
 	/// @brief Receive a broadcast message from a specific listener port
 	/// @param buffer -[out]- Buffer to place received data into
 	/// @param maxSize -[in]- Maximum number of bytes to be read
 	/// @param port -[in]- Port of the broadcast to receive from
 	/// @return 0+ if successful (number bytes received), -1 if fails. Call GetLastError() to find out more.
-	int8_t ReceiveBroadcastFromListenerPort(void* buffer, const uint32_t maxSize, const int16_t port);
+	int32_t ReceiveBroadcastFromListenerPort(void* buffer, const uint32_t maxSize, const int16_t port);
 
 	/// @brief Receive a multicast message
 	/// @param buffer -[out]- Buffer to place received data into
 	/// @param maxSize -[in]- Maximum number of bytes to be read
 	/// @param multicastGroup -[out]- IP of the group received from
 	/// @return 0+ if successful (number bytes received), -1 if fails. Call GetLastError() to find out more.
-	int8_t ReceiveMulticast(void* buffer, const uint32_t maxSize, std::string& multicastGroup);
+	int32_t ReceiveMulticast(void* buffer, const uint32_t maxSize, std::string& multicastGroup);
+
+	/// @brief Receive every datagram waiting on the unicast socket, up to maxDatagrams, in one call.
+	/// Datagram i is placed at buffer + i * slotSize, datagrams larger than a slot are truncated.
+	/// @param buffer -[out]- Buffer of maxDatagrams slots to place received datagrams into
+	/// @param slotSize -[in]- Size of each slot in bytes
+	/// @param maxDatagrams -[in]- Maximum number of datagrams to be read
+	/// @param lengths -[out]- Array of maxDatagrams, filled with the length of each datagram read
+	/// @return 0+ if successful (number datagrams received), -1 if fails. Call GetLastError() to find out more.
+	int32_t ReceiveBatch(uint8_t* buffer, const uint32_t slotSize, const uint32_t maxDatagrams, uint32_t* lengths);
 
 	/// @brief Closes the unicast client and cleans up
 	void CloseUnicast();
@@ -319,4 +331,8 @@ private:
 	SOCKET				m_broadcastSocket;			// socket FD for broadcasting
 	std::vector<std::tuple<SOCKET, sockaddr_in, Endpoint>>   m_broadcastListeners;	// Vector of tuples containing the socket and addr info for listening to broadcasts
 	std::vector<std::tuple<SOCKET, sockaddr_in, Endpoint>>   m_multicastSockets;	// Vector of tuples containing the socket and addr info for multicasts
+#ifdef __linux__
+	std::vector<mmsghdr>	m_batchHeaders;				// Message headers reused by ReceiveBatch
+	std::vector<iovec>		m_batchVectors;				// Slot vectors reused by ReceiveBatch
+#endif
 };
\ No newline at end of file
@@ -10,10 +10,24 @@
 // Includes:
 //          name                            reason included
 //          ------------------              ------------------------
+#include <cstring>                          // strcmp
+#include <algorithm>                        // find_if
+//
 #include "web_server.h"                     // header
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // Subprotocols a client may offer, the first it lists that is known here is accepted
+    constexpr const char* CBOR_SUBPROTOCOL = "wasp.cbor";
+    const char* SUBPROTOCOL_NAMES[] = { CBOR_SUBPROTOCOL, "wasp.json" };
+    mg_websocket_subprotocols WEBSOCKET_SUBPROTOCOLS = { 2, SUBPROTOCOL_NAMES };
+
+    // Largest subscription request read from a client
+    constexpr size_t MAX_REQUEST_SIZE = 1024;
+}
+
 WebServer::WebServer(LogClient& logger, const int port, const std::string directory, 
     const int maxThreads, const std::string websocketName) :
     m_name("WEB SVR"), m_logger(logger), m_port(port), m_directory(directory),
@@ -161,8 +175,8 @@ void WebServer::Start()
         return 1;
     }, this);
 
-    // Start the websocket
-    mg_set_websocket_handler(m_context, "/websocket",
+    // Start the websocket, a client may ask for binary telemetry by subprotocol
+    mg_set_websocket_handler_with_subprotocols(m_context, "/websocket", &WEBSOCKET_SUBPROTOCOLS,
         [](const mg_connection* conn, void* user_data) 
         {
             static_cast<WebServer*>(user_data)->WebSocketConnectHandler(conn);
@@ -174,8 +188,7 @@ void WebServer::Start()
         },
         [](mg_connection* conn, int opcode, char* data, size_t datasize, void* user_data) 
         {
-            static_cast<WebServer*>(user_data)->WebsocketDataHandler(conn, opcode, data, datasize);
-            return 0;
+            return static_cast<WebServer*>(user_data)->WebsocketDataHandler(conn, opcode, data, datasize);
         },
         [](const mg_connection* conn, void* user_data)
         {
@@ -190,28 +203,349 @@ int WebServer::SendJsonOverWebSocket(const nlohmann::json& json)
     return SendMessageOverWebSocket(message);
 }
 
-int WebServer::SendMessageOverWebSocket(const std::string& msg)
+int WebServer::SendMessageOverWebSocket(const std::string& msg, const SendPolicy policy)
+{
+    return Enqueue(msg, nullptr, policy);
+}
+
+int WebServer::SendEncodedOverWebSocket(const std::string& json, const std::string& cbor, const SendPolicy policy)
+{
+    return Enqueue(json, &cbor, policy);
+}
+
+int WebServer::Enqueue(const std::string& json, const std::string* cbor, const SendPolicy policy)
+{
+    // One copy of each encoding shared by every client, the senders write it after this returns
+    Outgoing text = {};
+    Outgoing binary = { nullptr, true };
+
+    std::lock_guard<std::mutex> lock(m_connectionLock);
+
+    int msgsQueued = 0;
+
+    // Hand the message to each WebSocket client, the writes happen on the client's sender
+    for (auto& pair : m_connections)
+    {
+        if (QueueFor(*pair.second, text, binary, json, cbor, policy, MAX_TOPICS)) msgsQueued++;
+    }
+
+    return msgsQueued;
+}
+
+bool WebServer::QueueFor(Client& client, Outgoing& text, Outgoing& binary, const std::string& json, const std::string* cbor,
+    const SendPolicy policy, const size_t slot, const bool complete)
+{
+    {
+        std::lock_guard<std::mutex> clientLock(client.mutex);
+        if (!client.ready || client.closing) return false;
+
+        // Copied on first use, an encoding no client asked for is never copied
+        Outgoing* message = &text;
+        if (cbor != nullptr && client.encoding == Encoding::Cbor)
+        {
+            message = &binary;
+            if (message->data == nullptr) message->data = std::make_shared<const std::string>(*cbor);
+        }
+        else if (message->data == nullptr)
+        {
+            message->data = std::make_shared<const std::string>(json);
+        }
+
+        if (policy == SendPolicy::Latest)
+        {
+            Outgoing& latest = client.latest[slot];
+            if (latest.data != nullptr)
+            {
+                client.stats.replaced++;
+
+                // Fields only the replaced message held are lost unless the next one has them all
+                if (slot < MAX_TOPICS && !complete)
+                {
+                    if (!client.resync[slot]) client.stats.resyncs++;
+                    client.resync[slot] = true;
+                }
+            }
+            else
+            {
+                client.latestWaiting++;
+            }
+            if (slot < MAX_TOPICS && complete) client.resync[slot] = false;
+            latest = *message;
+        }
+        else
+        {
+            if (client.queue.size() >= MAX_QUEUED)
+            {
+                client.queue.pop_front();
+                client.stats.dropped++;
+            }
+            client.queue.push_back(*message);
+        }
+    }
+
+    client.wake.notify_one();
+    return true;
+}
+
+int WebServer::AddTopic(const std::string& name, const int defaultRateHz)
+{
+    if (m_topics.size() >= MAX_TOPICS) return -1;
+
+    for (const TopicInfo& topic : m_topics)
+    {
+        if (topic.name == name) return -1;
+    }
+
+    m_topics.push_back({ name, SnapRate(defaultRateHz) });
+    return static_cast<int>(m_topics.size()) - 1;
+}
+
+bool WebServer::SetTopicDefaultRate(const int topic, const int rateHz)
+{
+    if (topic < 0 || topic >= static_cast<int>(m_topics.size())) return false;
+
+    std::lock_guard<std::mutex> lock(m_connectionLock);
+    m_topics[topic].defaultRateHz = SnapRate(rateHz);
+    return true;
+}
+
+std::vector<int> WebServer::GetSubscriptionRates(const int topic)
+{
+    std::vector<int> rates;
+    if (topic < 0 || topic >= MAX_TOPICS) return rates;
+
+    std::lock_guard<std::mutex> lock(m_connectionLock);
+    rates.reserve(m_groups[topic].size());
+    for (const Group& group : m_groups[topic])
+    {
+        rates.push_back(group.rateHz);
+    }
+
+    return rates;
+}
+
+int WebServer::SendToSubscribers(const int topic, const int rateHz, const std::string& json, const std::string& cbor, const SendPolicy policy,
+    const bool complete)
+{
+    if (topic < 0 || topic >= MAX_TOPICS) return 0;
+
+    Outgoing text = {};
+    Outgoing binary = { nullptr, true };
+
+    std::lock_guard<std::mutex> lock(m_connectionLock);
+
+    int msgsQueued = 0;
+    for (const Group& group : m_groups[topic])
+    {
+        if (group.rateHz != rateHz) continue;
+
+        // Only the group's members, the clients on other rates or topics are not visited
+        for (Client* client : group.members)
+        {
+            if (QueueFor(*client, text, binary, json, &cbor, policy, static_cast<size_t>(topic), complete)) msgsQueued++;
+        }
+        break;
+    }
+
+    return msgsQueued;
+}
+
+bool WebServer::TakeResync(const int topic, const int rateHz)
+{
+    if (topic < 0 || topic >= MAX_TOPICS) return false;
+
+    std::lock_guard<std::mutex> lock(m_connectionLock);
+
+    bool resync = false;
+    for (const Group& group : m_groups[topic])
+    {
+        if (group.rateHz != rateHz) continue;
+
+        for (Client* client : group.members)
+        {
+            std::lock_guard<std::mutex> clientLock(client->mutex);
+            resync |= client->resync[topic];
+            client->resync[topic] = false;
+        }
+        break;
+    }
+
+    return resync;
+}
+
+void WebServer::HandleSubscription(Client& client, const std::string& request)
 {
+    const nlohmann::json message = nlohmann::json::parse(request, nullptr, false);
+    if (message.is_discarded() || !message.is_object()) return;
+
+    // Names outside the registered topics and rates that are not numbers are skipped
+    auto topicId = [this](const std::string& name)
+    {
+        for (size_t i = 0; i < m_topics.size(); i++)
+        {
+            if (m_topics[i].name == name) return static_cast<int>(i);
+        }
+        return -1;
+    };
+
     std::lock_guard<std::mutex> lock(m_connectionLock);
 
-    int msgsSent = 0;
+    auto subscribe = message.find("subscribe");
+    if (subscribe != message.end() && subscribe->is_object())
+    {
+        for (auto& item : subscribe->items())
+        {
+            const int topic = topicId(item.key());
+            if (topic >= 0 && item.value().is_number()) client.rates[topic] = SnapRate(item.value().get<double>());
+        }
+    }
+
+    auto unsubscribe = message.find("unsubscribe");
+    if (unsubscribe != message.end() && unsubscribe->is_array())
+    {
+        for (auto& item : *unsubscribe)
+        {
+            const int topic = item.is_string() ? topicId(item.get<std::string>()) : -1;
+            if (topic >= 0) client.rates[topic] = 0;
+        }
+    }
+
+    RebuildGroups();
+
+    // Tell the client the rates it was given
+    nlohmann::json reply;
+    reply["subscribed"] = nlohmann::json::object();
+    for (size_t i = 0; i < m_topics.size(); i++)
+    {
+        if (client.rates[i] > 0) reply["subscribed"][m_topics[i].name] = client.rates[i];
+    }
+
+    Outgoing text = {};
+    Outgoing binary = { nullptr, true };
+    QueueFor(client, text, binary, reply.dump(), nullptr, SendPolicy::Queued, MAX_TOPICS);
+}
+
+void WebServer::RebuildGroups()
+{
+    for (std::vector<Group>& groups : m_groups)
+    {
+        groups.clear();
+    }
 
-    // Iterate through connections and send message to each WebSocket client
     for (auto& pair : m_connections)
     {
-        struct mg_connection* conn = pair.first;
-        bool ready = pair.second;
+        Client* client = pair.second.get();
+        {
+            std::lock_guard<std::mutex> clientLock(client->mutex);
+            if (!client->ready || client->closing) continue;
+        }
 
-        if (ready)
+        for (size_t topic = 0; topic < m_topics.size(); topic++)
         {
-            if (mg_websocket_write(conn, MG_WEBSOCKET_OPCODE_TEXT, msg.c_str(), msg.length()) <= 0)
-                m_sendErrorCount++;
+            const int rateHz = client->rates[topic];
+            if (rateHz <= 0) continue;
+
+            std::vector<Group>& groups = m_groups[topic];
+            auto it = std::find_if(groups.begin(), groups.end(), [rateHz](const Group& group) { return group.rateHz == rateHz; });
+            if (it == groups.end())
+            {
+                groups.push_back({ rateHz, {} });
+                it = groups.end() - 1;
+            }
+            it->members.push_back(client);
+        }
+    }
+
+    m_subscriptionVersion++;
+}
+
+int WebServer::SnapRate(const double rateHz)
+{
+    if (!(rateHz >= 1.0)) return 0;
+    if (rateHz >= MAX_RATE_HZ) return MAX_RATE_HZ;
+
+    int decade = 1;
+    while (decade * 10 <= rateHz) decade *= 10;
+
+    if (rateHz >= decade * 5) return decade * 5;
+    if (rateHz >= decade * 2) return decade * 2;
+    return decade;
+}
+
+std::vector<WebServer::ClientStats> WebServer::GetClientStats()
+{
+    std::lock_guard<std::mutex> lock(m_connectionLock);
+
+    std::vector<ClientStats> stats;
+    stats.reserve(m_connections.size());
+    for (auto& pair : m_connections)
+    {
+        Client& client = *pair.second;
+        std::lock_guard<std::mutex> clientLock(client.mutex);
+        stats.push_back(client.stats);
+        stats.back().waiting = client.queue.size() + client.latestWaiting;
+    }
+
+    return stats;
+}
+
+void WebServer::ClientSender(Client* client)
+{
+    while (true)
+    {
+        Outgoing message;
+        {
+            std::unique_lock<std::mutex> lock(client->mutex);
+            client->wake.wait(lock, [client] { return client->closing || !client->queue.empty() || client->latestWaiting > 0; });
+            if (client->closing) return;
+
+            // Queued messages keep their order, the latest telemetry goes once they are out
+            if (!client->queue.empty())
+            {
+                message = std::move(client->queue.front());
+                client->queue.pop_front();
+            }
             else
-                msgsSent++;
+            {
+                // Topics take turns so a fast one cannot starve the others
+                size_t slot = client->nextLatest;
+                while (client->latest[slot].data == nullptr) slot = (slot + 1) % client->latest.size();
+
+                message = std::move(client->latest[slot]);
+                client->latest[slot] = {};
+                client->latestWaiting--;
+                client->nextLatest = (slot + 1) % client->latest.size();
+            }
         }
+
+        // Only this client waits on its link
+        const int opcode = message.binary ? MG_WEBSOCKET_OPCODE_BINARY : MG_WEBSOCKET_OPCODE_TEXT;
+        const bool written = mg_websocket_write(client->conn, opcode, message.data->data(), message.data->size()) > 0;
+
+        std::lock_guard<std::mutex> lock(client->mutex);
+        if (written) client->stats.sent++;
+        else client->stats.errors++;
+    }
+}
+
+void WebServer::StopClient(Client& client)
+{
+    {
+        std::lock_guard<std::mutex> lock(client.mutex);
+        client.closing = true;
     }
+    client.wake.notify_one();
 
-    return msgsSent;
+    if (client.sender.joinable()) client.sender.join();
+
+    const ClientStats& stats = client.stats;
+    if (stats.replaced > 0 || stats.dropped > 0 || stats.errors > 0)
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Websocket client closed, sent " + std::to_string(stats.sent) +
+            ", replaced " + std::to_string(stats.replaced) + " (" + std::to_string(stats.resyncs) + " resynced)" +
+            ", dropped " + std::to_string(stats.dropped) +
+            ", failed " + std::to_string(stats.errors) + ".");
+    }
 }
 
 void WebServer::Stop()
@@ -224,6 +558,18 @@ void WebServer::Stop()
         m_context = nullptr;
     }
 
+    // Any client civetweb did not close
+    std::map<mg_connection*, std::unique_ptr<Client>> remaining;
+    {
+        std::lock_guard<std::mutex> lock(m_connectionLock);
+        remaining.swap(m_connections);
+        RebuildGroups();
+    }
+    for (auto& pair : remaining)
+    {
+        StopClient(*pair.second);
+    }
+
     // Log server stop
     m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Stopped");
 }
@@ -379,8 +725,26 @@ std::string WebServer::Parse(const std::string name, const char* data)
 
 int WebServer::WebSocketConnectHandler(const mg_connection* conn) 
 {
+    std::unique_ptr<Client> client = std::make_unique<Client>();
+    client->conn = const_cast<mg_connection*>(conn);
+
+    // Encoding from the accepted subprotocol, or from the query for clients that cannot set one
+    const mg_request_info* info = mg_get_request_info(conn);
+    char encoding[16] = {};
+    if (info != nullptr && info->acceptedWebSocketSubprotocol != nullptr &&
+        std::strcmp(info->acceptedWebSocketSubprotocol, CBOR_SUBPROTOCOL) == 0)
+    {
+        client->encoding = Encoding::Cbor;
+    }
+    else if (info != nullptr && info->query_string != nullptr &&
+        mg_get_var(info->query_string, std::strlen(info->query_string), "encoding", encoding, sizeof(encoding)) > 0 &&
+        std::strcmp(encoding, "cbor") == 0)
+    {
+        client->encoding = Encoding::Cbor;
+    }
+
     std::lock_guard<std::mutex> lock(m_connectionLock);
-    m_connections.insert({const_cast<mg_connection*>(conn), false});
+    m_connections.insert({ client->conn, std::move(client) });
     return 1;
 }
 
@@ -390,21 +754,58 @@ void WebServer::WebSocketReadyHandler(const mg_connection* conn)
     std::lock_guard<std::mutex> lock(m_connectionLock);
     auto it = m_connections.find(const_cast<mg_connection*>(conn));
 
-    // Mark connection as ready
-    if (it != m_connections.end()) 
+    // Mark connection as ready and start writing to it
+    if (it != m_connections.end())
     {
-        it->second = true;
+        Client* client = it->second.get();
+        {
+            std::lock_guard<std::mutex> clientLock(client->mutex);
+            client->ready = true;
+            client->sender = std::thread(&WebServer::ClientSender, this, client);
+        }
+
+        // Topics with a default rate until the client asks for its own
+        for (size_t topic = 0; topic < m_topics.size(); topic++)
+        {
+            client->rates[topic] = m_topics[topic].defaultRateHz;
+        }
+        RebuildGroups();
     }
 }
 
 int WebServer::WebsocketDataHandler(const mg_connection* conn, int bits, char* data, size_t data_len) 
 {
-    // Only sending for now
+    // Subscription requests are short text, anything else is ignored
+    if ((bits & 0x0F) != MG_WEBSOCKET_OPCODE_TEXT || data_len == 0 || data_len > MAX_REQUEST_SIZE) return 1;
+
+    Client* client = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_connectionLock);
+        auto it = m_connections.find(const_cast<mg_connection*>(conn));
+        if (it != m_connections.end()) client = it->second.get();
+    }
+
+    // Only this connection's thread closes it, so the client outlives the request
+    if (client != nullptr) HandleSubscription(*client, std::string(data, data_len));
+
+    // Returning 0 would close the connection
     return 1;
 }
 
 void WebServer::WebSocketCloseHandler(const mg_connection* conn) 
 {
-    std::lock_guard<std::mutex> lock(m_connectionLock);
-    m_connections.erase(const_cast<mg_connection*>(conn));
+    std::unique_ptr<Client> client;
+    {
+        std::lock_guard<std::mutex> lock(m_connectionLock);
+        auto it = m_connections.find(const_cast<mg_connection*>(conn));
+        if (it == m_connections.end()) return;
+
+        client = std::move(it->second);
+        m_connections.erase(it);
+        RebuildGroups();
+    }
+
+    // The connection is freed once this returns, its sender must be done with it. Joined
+    // outside the connection lock so senders to other clients are not held up.
+    StopClient(*client);
 }
\ No newline at end of file
@@ -17,6 +17,13 @@
 #include "log_client.h"             // Log Client
 #include "constants.h"				// Buffer size
 #include <mutex>
+#include <map>							// connections
+#include <vector>						// client stats
+#include <array>						// subscriptions
+#include <deque>						// send queues
+#include <memory>						// shared messages
+#include <thread>						// sender threads
+#include <condition_variable>			// sender wake up
 #include "version.h"				// Generated version file
 #include "../web_pages/web_pages.h"	// web pages
 //
@@ -37,6 +44,41 @@ public:
 		Error
 	};
 
+	/// @brief How a websocket message is queued for each client
+	enum class SendPolicy
+	{
+		Queued,		// kept in order, the oldest is dropped once a client has MAX_QUEUED waiting
+		Latest,		// replaces any Latest message the client has not been sent yet, see TakeResync()
+	};
+
+	/// @brief Messages a client may have waiting before the oldest is dropped
+	static constexpr size_t MAX_QUEUED = 32;
+
+	/// @brief Topics that may be registered for clients to subscribe to
+	static constexpr int MAX_TOPICS = 8;
+
+	/// @brief Fastest rate a topic may be subscribed at
+	static constexpr int MAX_RATE_HZ = 1000;
+
+	/// @brief Telemetry encoding a websocket client asked for when it connected, by the
+	/// "wasp.cbor" subprotocol or an "encoding=cbor" query parameter. JSON otherwise.
+	enum class Encoding
+	{
+		Json,		// text frames
+		Cbor,		// binary frames, RFC 8949
+	};
+
+	/// @brief Sending counts for one websocket client
+	struct ClientStats
+	{
+		uint64_t	sent		= 0;	// messages written
+		uint64_t	replaced	= 0;	// Latest messages replaced before they were written
+		uint64_t	resyncs		= 0;	// replaced messages that left the client needing a complete one
+		uint64_t	dropped		= 0;	// Queued messages dropped from a full queue
+		uint64_t	errors		= 0;	// writes that failed
+		size_t		waiting		= 0;	// messages not yet written
+	};
+
 	/// @brief Constructor
 	/// @param logger - instance of LogClient
 	/// @param port - port to serve the server at
@@ -70,10 +112,65 @@ public:
 	/// @return 0 on error, else the total number of messages sent to websockets
 	int SendJsonOverWebSocket(const nlohmann::json& json);
 
-	/// @brief Sends a string over WebSocket
+	/// @brief Queues a string for every WebSocket client, never waits on the network
 	/// @param msg - [in] - string to send
-	/// @return 0 on error, else the total number of messages sent to websockets
-	int SendMessageOverWebSocket(const std::string& msg);
+	/// @param policy - [in/opt] - how the message is queued
+	/// @return 0 on error, else the number of clients the message was queued for
+	int SendMessageOverWebSocket(const std::string& msg, const SendPolicy policy = SendPolicy::Queued);
+
+	/// @brief Queues one message in two encodings, each client is sent the one it asked for
+	/// @param json - [in] - message as JSON, sent as a text frame
+	/// @param cbor - [in] - the same message as CBOR, sent as a binary frame
+	/// @param policy - [in/opt] - how the message is queued
+	/// @return 0 on error, else the number of clients the message was queued for
+	int SendEncodedOverWebSocket(const std::string& json, const std::string& cbor, const SendPolicy policy = SendPolicy::Queued);
+
+	/// @brief Register a topic clients may subscribe to, before Start(). A client subscribes by
+	/// sending {"subscribe":{"<topic>":<max rate Hz>, ...}} and stops with {"unsubscribe":["<topic>", ...]}.
+	/// Rates are rounded down to 1, 2 or 5 times a power of ten so clients share groups.
+	/// @param name - [in] - name the clients use
+	/// @param defaultRateHz - [in] - rate a client gets until it subscribes, 0 for none
+	/// @return topic id, -1 if the name is taken or MAX_TOPICS are registered
+	int AddTopic(const std::string& name, const int defaultRateHz);
+
+	/// @brief Set the rate a client gets until it subscribes, for clients that connect after
+	/// @param topic - [in] - topic id
+	/// @param rateHz - [in] - rate, 0 for none
+	/// @return true if set, false if the topic is unknown
+	bool SetTopicDefaultRate(const int topic, const int rateHz);
+
+	/// @brief Get a count that changes whenever the subscription groups do
+	/// @return version
+	uint64_t GetSubscriptionVersion() const { return m_subscriptionVersion; }
+
+	/// @brief Get the distinct rates a topic is subscribed at, one group of clients each
+	/// @param topic - [in] - topic id
+	/// @return rates, empty when no client is subscribed
+	std::vector<int> GetSubscriptionRates(const int topic);
+
+	/// @brief Queues one message for the clients subscribed to a topic at a rate, each is sent
+	/// the encoding it asked for. A Latest message only replaces one of the same topic.
+	/// @param topic - [in] - topic id
+	/// @param rateHz - [in] - group rate, from GetSubscriptionRates()
+	/// @param json - [in] - message as JSON, sent as a text frame
+	/// @param cbor - [in] - the same message as CBOR, sent as a binary frame
+	/// @param policy - [in] - how the message is queued
+	/// @param complete - [in/opt] - the message holds every field, so replacing one loses nothing
+	/// @return number of clients the message was queued for
+	int SendToSubscribers(const int topic, const int rateHz, const std::string& json, const std::string& cbor, const SendPolicy policy,
+		const bool complete = false);
+
+	/// @brief Check whether a member of a group had a Latest message replaced by one that was not
+	/// complete, and clear the flags. A Latest message may hold only what changed since the one
+	/// before it, so the member has missed fields and the group's next message must be complete.
+	/// @param topic - [in] - topic id
+	/// @param rateHz - [in] - group rate, from GetSubscriptionRates()
+	/// @return true if the next message must hold every field
+	bool TakeResync(const int topic, const int rateHz);
+
+	/// @brief Get the sending counts of every connected client
+	/// @return stats per client
+	std::vector<ClientStats> GetClientStats();
 
 	/// @brief Stops the web server process.
 	void Stop();
@@ -115,6 +212,89 @@ private:
 
 	void WebSocketCloseHandler(const mg_connection* conn);
 
+	/// @brief A message waiting for a client, shared between every client it was queued for
+	struct Outgoing
+	{
+		std::shared_ptr<const std::string>			data;					// nullptr when empty
+		bool										binary		= false;	// write as a binary frame
+	};
+
+	/// @brief A websocket connection and the messages waiting for it. Each client is written
+	/// from its own thread so a slow link only holds up itself.
+	struct Client
+	{
+		mg_connection*								conn		= nullptr;
+		Encoding									encoding	= Encoding::Json;
+		bool										ready		= false;	// handshake done
+		bool										closing		= false;	// sender should exit
+		std::deque<Outgoing>						queue;					// Queued messages, oldest first
+		std::array<Outgoing, MAX_TOPICS + 1>		latest;					// newest Latest message per topic, then untopiced
+		size_t										latestWaiting = 0;		// latest slots holding a message
+		size_t										nextLatest	= 0;		// slot the sender looks at first
+		std::array<bool, MAX_TOPICS>				resync		= {};		// topic had an incomplete Latest message replace another
+		ClientStats									stats;
+		std::mutex									mutex;					// protects the fields above
+		std::condition_variable						wake;					// signalled on a new message or close
+		std::thread									sender;
+		std::array<int, MAX_TOPICS>					rates		= {};		// subscribed rate per topic, 0 for none, under m_connectionLock
+	};
+
+	/// @brief A topic clients may subscribe to
+	struct TopicInfo
+	{
+		std::string									name;
+		int											defaultRateHz = 0;
+	};
+
+	/// @brief The clients subscribed to a topic at one rate
+	struct Group
+	{
+		int											rateHz		= 0;
+		std::vector<Client*>						members;
+	};
+
+	/// @brief Queue a message for every ready client
+	/// @param json - [in] - message as JSON
+	/// @param cbor - [in] - message as CBOR, nullptr to send JSON to every client
+	/// @param policy - [in] - how the message is queued
+	/// @return number of clients the message was queued for
+	int Enqueue(const std::string& json, const std::string* cbor, const SendPolicy policy);
+
+	/// @brief Queue a message for one client, m_connectionLock held. The encodings are copied
+	/// into text and binary the first time a client needs them and shared after.
+	/// @param client - [in] - client to queue for
+	/// @param text - [in/out] - shared JSON copy
+	/// @param binary - [in/out] - shared CBOR copy
+	/// @param json - [in] - message as JSON
+	/// @param cbor - [in] - message as CBOR, nullptr to send JSON
+	/// @param policy - [in] - how the message is queued
+	/// @param slot - [in] - Latest slot, the topic id or MAX_TOPICS
+	/// @param complete - [in/opt] - the message holds every field of its topic
+	/// @return true if queued, false if the client is not ready
+	bool QueueFor(Client& client, Outgoing& text, Outgoing& binary, const std::string& json, const std::string* cbor,
+		const SendPolicy policy, const size_t slot, const bool complete = true);
+
+	/// @brief Apply a subscription request from a client
+	/// @param client - [in] - client that sent it
+	/// @param request - [in] - message text
+	void HandleSubscription(Client& client, const std::string& request);
+
+	/// @brief Rebuild the subscription groups from every ready client, m_connectionLock held
+	void RebuildGroups();
+
+	/// @brief Round a requested rate down to 1, 2 or 5 times a power of ten
+	/// @param rateHz - [in] - requested rate
+	/// @return rate, 0 for none
+	static int SnapRate(const double rateHz);
+
+	/// @brief Sender thread body, writes the client's messages until it closes
+	/// @param client - [in] - client to service
+	void ClientSender(Client* client);
+
+	/// @brief Stop a client's sender and wait for it, without holding m_connectionLock
+	/// @param client - [in] - client to stop
+	void StopClient(Client& client);
+
 	std::atomic_bool	m_run					= false;
     std::string			m_name					= "";
     LogClient&			m_logger;
@@ -126,9 +306,11 @@ private:
 	char				m_buffer[BUFFER_SIZE]	= {};
 	int					m_maxThreads			= 0;
 	inja::Environment	m_environment;
-	long				m_sendErrorCount		= 0;
 
 	// Items for websocket
 	std::mutex								m_connectionLock	= {};
-	std::map<mg_connection*, bool>			m_connections		= {};
+	std::map<mg_connection*, std::unique_ptr<Client>>	m_connections	= {};
+	std::vector<TopicInfo>					m_topics			= {};	// registered before Start()
+	std::array<std::vector<Group>, MAX_TOPICS>	m_groups		= {};	// per topic, under m_connectionLock
+	std::atomic<uint64_t>					m_subscriptionVersion = 0;
 };
\ No newline at end of file
@@ -13,10 +13,15 @@
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    constexpr int LOG_DISPLAY_SEC = 5;          // time the web page shows a forwarded log
+}
+
 Wasp::Wasp(const std::string& settingsLocation, const std::string& buildLocation, const std::string& configLocation) :
     m_settings(settingsLocation), m_build(buildLocation), m_config(configLocation),
     m_name("WASP"), m_logger(), m_signalManger(m_logger), m_imuManager(m_logger),
-    m_gpsManager(m_logger), m_webServer(m_logger), m_initialized(false)
+    m_gpsManager(m_logger), m_webServer(m_logger), m_telemetry(m_webServer), m_startup(m_logger), m_bus(std::make_unique<DataBus>()), m_sensorHistory(std::make_unique<SensorHistory>()), m_initialized(false)
 {
     // Load the configs and catch any failures
     if (!m_settings.Load())
@@ -34,44 +39,134 @@ Wasp::Wasp(const std::string& settingsLocation, const std::string& buildLocation
         std::cerr << "[WASP] - ERROR - Failed to Load/Create config file.\n";
     }
 
+    // Target frame, computed once so guidance only pays for the vehicle side
+    m_targetFrame = Geodesy::LocalFrame({ m_settings.data.targetLatitude * Geodesy::DEG_TO_RAD,
+        m_settings.data.targetLongitude * Geodesy::DEG_TO_RAD, m_settings.data.targetAltitudeHAE });
+
     // Start the logger, if file logging is enabled in config, enable it. 
     if (m_settings.data.fileLoggingEnabled && !m_settings.data.logFilePath.empty())
     {
         m_logger.EnableFileLogging(m_settings.data.logFilePath);
     }
+
+    // Every log also goes out on the logs topic, the main loop sends them at the clients' rates
+    m_logger.SetForward([this](const LogClient::LogLevel, const std::string& log) { m_telemetry.QueueMessage(log, LOG_DISPLAY_SEC); });
     m_loggingThread = std::thread([this] { m_logger.Run(); });
 
-    // Sleep a little while the logger sets up
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Telemetry is set up here, before any stage runs, the main loop may publish while the
+    // stages are still starting
+    if (!m_telemetry.SetRate(m_settings.data.telemetryRateHz))
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Invalid telemetry rate, keeping the default.");
+    }
+    m_telemetry.SetKeyframeInterval(m_settings.data.telemetryKeyframeMs);
 
-    // Start the web server
-    std::string dir = WEB_FILES_DIR;
-    m_webServer.Configure(m_settings.data.webPort, dir);
-    m_webThread = std::thread([this] { m_webServer.Start(); });
+    // The logger queues from the start, nothing waits on its thread. The devices come up as
+    // independent stages so a slow GPS search does not hold up the IMU or the fins.
+    m_startup.AddStage("Web server", [this] {
+        std::string dir = WEB_FILES_DIR;
+        m_webServer.Configure(m_settings.data.webPort, dir);
+        m_webThread = std::thread([this] { m_webServer.Start(); });
+        return true;
+    }, {}, false);
 
-    // Initialize the signal manager PWMs
-    m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Starting Signal Manager.");
-    m_signalManger.ReadyFin(SignalManager::FIN::ONE,      m_config.data.fin1Path, m_config.data.fin1Channel, m_config.data.finMinDegrees, m_config.data.finMaxDegrees);
-    m_signalManger.ReadyFin(SignalManager::FIN::TWO,      m_config.data.fin2Path, m_config.data.fin2Channel, m_config.data.finMinDegrees, m_config.data.finMaxDegrees);
-    m_signalManger.ReadyFin(SignalManager::FIN::THREE,    m_config.data.fin3Path, m_config.data.fin3Channel, m_config.data.finMinDegrees, m_config.data.finMaxDegrees);
-    m_signalManger.ReadyFin(SignalManager::FIN::FOUR,     m_config.data.fin4Path, m_config.data.fin4Channel, m_config.data.finMinDegrees, m_config.data.finMaxDegrees);
-    m_signalThread = std::thread([this] { m_signalManger.Start(); });
+    m_startup.AddStage("Fins", [this] {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Info, "Starting Signal Manager.");
+        m_signalManger.SetBackend(m_config.data.pwmBackend, m_config.data.pwmTracePath);
+        m_signalManger.SetCalibration(SignalManager::FIN::ONE,      m_config.data.fin1Calibration, m_config.data.fin1TrimDegrees);
+        m_signalManger.SetCalibration(SignalManager::FIN::TWO,      m_config.data.fin2Calibration, m_config.data.fin2TrimDegrees);
+        m_signalManger.SetCalibration(SignalManager::FIN::THREE,    m_config.data.fin3Calibration, m_config.data.fin3TrimDegrees);
+        m_signalManger.SetCalibration(SignalManager::FIN::FOUR,     m_config.data.fin4Calibration, m_config.data.fin4TrimDegrees);
+        bool ready = true;
+        ready &= m_signalManger.ReadyFin(SignalManager::FIN::ONE,      m_config.data.fin1Path, m_config.data.fin1Channel, m_config.data.finMinDegrees, m_config.data.finMaxDegrees);
+        ready &= m_signalManger.ReadyFin(SignalManager::FIN::TWO,      m_config.data.fin2Path, m_config.data.fin2Channel, m_config.data.finMinDegrees, m_config.data.finMaxDegrees);
+        ready &= m_signalManger.ReadyFin(SignalManager::FIN::THREE,    m_config.data.fin3Path, m_config.data.fin3Channel, m_config.data.finMinDegrees, m_config.data.finMaxDegrees);
+        ready &= m_signalManger.ReadyFin(SignalManager::FIN::FOUR,     m_config.data.fin4Path, m_config.data.fin4Channel, m_config.data.finMinDegrees, m_config.data.finMaxDegrees);
+        if (!m_signalManger.SetRate(m_config.data.actuatorRateHz))
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Invalid actuator rate, keeping the default.");
+        }
+        m_signalManger.SetLimits(m_config.data.finSlewRateDegPerSec, m_config.data.finDeadbandDegrees);
 
-    // Configure the IMU
-    if(!m_imuManager.Configure(m_config.data.imuUnit, m_config.data.imuPort, m_config.data.imuBaudRate))
-    {
-        m_logger.AddLog(m_name, LogClient::LogLevel::Info, "IMU Manager failed to configure, exiting.");
-        // Close();
-        //return;
-    }
+        // Arm, release and status share one request, edges come back through the actuator loop
+        if (!m_config.data.discreteChipPath.empty())
+        {
+            std::vector<GPIO::LineConfig> lines;
+            if (m_config.data.armLine >= 0)     lines.push_back({ static_cast<unsigned>(m_config.data.armLine), GPIO::GPIODirection::Output });
+            if (m_config.data.releaseLine >= 0) lines.push_back({ static_cast<unsigned>(m_config.data.releaseLine), GPIO::GPIODirection::Output });
+            if (m_config.data.statusLine >= 0)  lines.push_back({ static_cast<unsigned>(m_config.data.statusLine), GPIO::GPIODirection::Input, GPIO::GPIOEdge::Both });
+            if (!lines.empty())
+            {
+                ready &= m_signalManger.ReadyDiscretes(m_config.data.discreteChipPath, lines);
+                m_signalManger.SetDiscreteTopic(&m_bus->discretes);
+            }
+        }
 
-    // Configure the GPS
-    if (!m_gpsManager.Configure(m_config.data.gpsUnit, m_config.data.gpsPort, m_config.data.gpsBaudRate))
-    {
-        m_logger.AddLog(m_name, LogClient::LogLevel::Info, "GPS Manager failed to configure, exiting.");
-        //Close();
-        //return;
-    }
+        // A replay drives the simulated fins from the reference trace and checks their writes
+        // instead of running the actuator loop
+        if (m_config.data.pwmBackend == PwmBackendType::Simulated && !m_config.data.pwmReferencePath.empty())
+        {
+            return m_signalManger.Replay(m_config.data.pwmReferencePath) && ready;
+        }
+
+        m_signalThread = std::thread([this] { m_signalManger.Start(); });
+        return ready;
+    });
+
+    m_startup.AddStage("IMU", [this] {
+        if (!m_imuManager.Configure(m_config.data.imuUnit, m_config.data.imuPort, m_config.data.imuBaudRate))
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Info, "IMU Manager failed to configure.");
+            return false;
+        }
+
+        // The IMU reads on its own thread so a slow consumer never delays a sample
+        m_imuManager.SetTopic(&m_bus->imu);
+        m_imuManager.Start(m_config.data.imuCpuCore, m_config.data.imuRtPriority, m_config.data.lockMemory);
+        return true;
+    });
+
+    m_startup.AddStage("GPS", [this] {
+        // Raw recording needs a framer buffer that holds a full sky RAWX frame, 0 keeps the default
+        int parserBufferSize = std::max(m_config.data.gpsParserBufferSize, 0);
+        if (!m_config.data.gpsRawLogPath.empty() && parserBufferSize > 0)
+        {
+            parserBufferSize = std::max(parserBufferSize, Ublox::FRAME_BUFFER_SIZE);
+        }
+
+        if (!m_gpsManager.Configure(m_config.data.gpsUnit, m_config.data.gpsPort, m_config.data.gpsBaudRate,
+            m_config.data.gpsNavigationRateHz, m_config.data.gpsHighRateCovDop, parserBufferSize))
+        {
+            m_logger.AddLog(m_name, LogClient::LogLevel::Info, "GPS Manager failed to configure.");
+            return false;
+        }
+
+        if (!m_config.data.gpsRawLogPath.empty())
+        {
+            // Raw measurement recording is optional, keep going without it
+            if (!m_gpsManager.EnableRawMeasurements(m_config.data.gpsRawLogPath))
+            {
+                m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "GPS raw measurement recording failed to start.");
+            }
+        }
+
+        // Add the redundant GPS if one is configured, the primary keeps running without it
+        if (m_config.data.gpsSecondaryUnit != GpsManager::GpsOptions::Unknown)
+        {
+            if (!m_gpsManager.AddReceiver(m_config.data.gpsSecondaryUnit, m_config.data.gpsSecondaryPort, m_config.data.gpsSecondaryBaudRate,
+                std::max(m_config.data.gpsParserBufferSize, 0)))
+            {
+                m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Secondary GPS failed to configure.");
+            }
+        }
+
+        // Each receiver parses on its own thread, Execute() only runs selection
+        m_gpsManager.SetTopic(&m_bus->gps);
+        m_gpsManager.Start();
+        return true;
+    });
+
+    m_startup.Run();
 
     m_initialized = true;
 }
@@ -85,54 +180,134 @@ void Wasp::Execute()
 {
     if (!m_initialized) return;
 
+    // Devices are still coming up, start once every critical stage is done
+    if (!m_startup.WaitReady())
+    {
+        m_logger.AddLog(m_name, LogClient::LogLevel::Warning, "Starting with a failed startup stage.");
+    }
+
     m_run = true;
 
+    // Consumers of the bus, each reads at its own pace without adding work for the publishers
+    Subscriber imuSamples(m_bus->imu, Delivery::Queued);
+    Subscriber gpsEpochs(m_bus->gps, Delivery::Queued);
+    Subscriber navigationHistory(m_bus->navigation, Delivery::Queued);
+    Subscriber discreteEdges(m_bus->discretes, Delivery::Queued);
+
     while (m_run)
     {
-        // Check for GPS updates
-        int gpsRead = m_gpsManager.Read();
-        if (gpsRead < 0) break;
-        else if (gpsRead > 0)
+        // Every IMU sample since the last pass, the newest is kept for attitude
+        ImuData imu;
+        while (imuSamples.Poll(imu))
+        {
+            m_imuData = imu;
+            m_sensorHistory->RecordImu(imu);
+        }
+
+        // Propagate the navigation filter over every sample the IMU has queued
+        ImuIncrement increment = m_imuManager.Integrate(MonotonicNowNs());
+        if (increment.sampleCount > 0)
+        {
+            m_navFilter.Propagate(increment);
+        }
+
+        // Run GPS selection, a new epoch is published on the bus
+        if (m_gpsManager.Read() < 0) break;
+
+        bool gpsUpdated = false;
+        GpsData gps;
+        while (gpsEpochs.Poll(gps))
+        {
+            m_gpsData = gps;
+            m_sensorHistory->RecordGps(gps);
+            gpsUpdated = true;
+
+            // Start on the first 3D fix once the IMU has given an attitude, correct with every fix
+            // after. A fix ahead of the first IMU sample is skipped rather than starting level at
+            // north with a covariance that trusts it.
+            if (!m_navFilter.IsInitialized())
+            {
+                if (m_imuData.sampleCount > 0) m_navFilter.Initialize(gps, m_imuData.roll, m_imuData.pitch, m_imuData.yaw);
+            }
+            else
+            {
+                m_navFilter.Update(gps);
+            }
+        }
+
+        m_navSolution = m_navFilter.GetSolution();
+        if (increment.sampleCount > 0 || gpsUpdated)
         {
-            m_gpsData = m_gpsManager.GetCommonData();
+            m_bus->navigation.Publish(m_navSolution);
         }
 
-        nlohmann::json json = {
-            {"data", {
-                {"hour", m_gpsData.hour},
-                {"min", m_gpsData.min},
-                {"sec", m_gpsData.sec},
-                {"latitude", m_gpsData.latitude},
-                {"longitude", m_gpsData.longitude},
-                {"altitude", m_gpsData.altitude}
-            }}
-        };
+        // Target geometry only means something once the filter has a position
+        if ((increment.sampleCount > 0 || gpsUpdated) && m_navSolution.initialized)
+        {
+            const Geodesy::Geodetic position = { m_navSolution.latitude * Geodesy::DEG_TO_RAD,
+                m_navSolution.longitude * Geodesy::DEG_TO_RAD, m_navSolution.altitude };
+            m_toTarget = Geodesy::Inverse(position, m_targetFrame.Origin());
+            m_targetOffset = m_targetFrame.ToNed(position);
+        }
 
-        static int sendCount = 0;
+        NavigationSolution navigation;
+        while (navigationHistory.Poll(navigation))
+        {
+            m_sensorHistory->RecordNavigation(navigation);
+        }
 
-        if (sendCount == 5)
+        GPIO::Event edge;
+        while (discreteEdges.Poll(edge))
         {
-            json = {
-                {"message", {
-                    {"text", "This is a sample message."},
-                    {"timeout", 5 }
-                }},
-                {"data", {
-                    {"hour", m_gpsData.hour},
-                    {"min", m_gpsData.min},
-                    {"sec", m_gpsData.sec},
-                    {"latitude", m_gpsData.latitude},
-                    {"longitude", m_gpsData.longitude},
-                    {"altitude", m_gpsData.altitude}
-                }}
-            };
+            if (static_cast<int>(edge.offset) == m_config.data.statusLine)
+            {
+                m_logger.AddLog(m_name, LogClient::LogLevel::Info, std::string("Status line ") + (edge.edge == GPIO::GPIOEdge::Rising ? "rose" : "fell")
+                    + " at " + std::to_string(edge.timeNs) + " ns.");
+            }
         }
 
-        if (m_webServer.SendJsonOverWebSocket(json))
+        // Each stream goes at the rates the web clients subscribed at with only the fields that
+        // changed, the values are only gathered when a send is due
+        const int64_t now = MonotonicNowNs();
+        if (m_telemetry.IsDue(TelemetryPublisher::Stream::Imu, now))
         {
-            sendCount++;
+            const std::array<double, 10> imuTelemetry = { m_imuData.roll, m_imuData.pitch, m_imuData.yaw,
+                m_imuData.gyroX, m_imuData.gyroY, m_imuData.gyroZ, m_imuData.accelX, m_imuData.accelY, m_imuData.accelZ,
+                m_imuData.temperature };
+            m_telemetry.Publish(TelemetryPublisher::Stream::Imu, imuTelemetry, now);
         }
 
+        if (m_telemetry.IsDue(TelemetryPublisher::Stream::Fins, now))
+        {
+            const SignalManager::FinCommand command = m_signalManger.GetLastCommand();
+            const SignalManager::ActuatorStats actuator = m_signalManger.GetActuatorStats();
+            const std::array<double, 8> finTelemetry = { command.degrees[0], command.degrees[1], command.degrees[2], command.degrees[3],
+                static_cast<double>(actuator.frames), static_cast<double>(actuator.writes),
+                static_cast<double>(actuator.writeErrors), static_cast<double>(actuator.missedTicks) };
+            m_telemetry.Publish(TelemetryPublisher::Stream::Fins, finTelemetry, now);
+        }
+
+        if (m_telemetry.IsDue(TelemetryPublisher::Stream::Health, now))
+        {
+            const std::array<double, 6> healthTelemetry = { static_cast<double>(m_gpsData.fixType), m_gpsData.navRateHz,
+                static_cast<double>(m_gpsData.droppedCount), static_cast<double>(m_imuData.droppedSampleCount),
+                static_cast<double>(m_imuData.rxErrorCount), m_navFilter.IsInitialized() ? 1.0 : 0.0 };
+            m_telemetry.Publish(TelemetryPublisher::Stream::Health, healthTelemetry, now);
+        }
+
+        if (m_navSolution.initialized && m_telemetry.IsDue(TelemetryPublisher::Stream::Target, now))
+        {
+            const std::array<double, 5> targetTelemetry = { m_toTarget.distance, m_toTarget.initialAzimuth * Geodesy::RAD_TO_DEG,
+                m_targetOffset[0], m_targetOffset[1], m_targetOffset[2] };
+            m_telemetry.Publish(TelemetryPublisher::Stream::Target, targetTelemetry, now);
+        }
+
+        const std::array<double, 6> gpsTelemetry = { static_cast<double>(m_gpsData.hour), static_cast<double>(m_gpsData.min),
+            static_cast<double>(m_gpsData.sec), m_gpsData.latitude, m_gpsData.longitude, m_gpsData.altitude };
+
+        m_telemetry.Publish(TelemetryPublisher::Stream::Gps, gpsTelemetry, now);
+
+        m_telemetry.PublishLogs(now);
     }
 }
 
@@ -141,9 +316,15 @@ void Wasp::Close()
     // Stop the execution loop
     m_run = false;
 
+    // Let startup finish so no stage is still bringing up a manager being stopped
+    m_startup.Wait();
+
     m_signalManger.Stop();
     if (m_signalThread.joinable()) m_signalThread.join();
 
+    m_gpsManager.Stop();
+    m_imuManager.Stop();
+
     m_webServer.Stop();
     if (m_webThread.joinable()) m_webThread.join();
 
@@ -21,8 +21,14 @@
 #include "managers/signal_manager.h"        // signal manager
 #include "imu/imu_manager.h"                // imu manager
 #include "gps/gps_manager.h"                // gps manager
+#include "navigation/nav_filter.h"          // navigation filter
+#include "navigation/sensor_history.h"      // time aligned sensor data
+#include "navigation/geodesy.h"             // target geometry
+#include "managers/data_bus.h"              // topics between managers
 #include "utilities/cot_utility.h"          // cot messaging
 #include "utilities/web_server.h"           // web server
+#include "utilities/telemetry_publisher.h"  // web telemetry
+#include "utilities/startup_graph.h"        // device bring up
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -59,10 +65,19 @@ private:
     GpsManager                      m_gpsManager;           /// Manager for GPS units
     ImuManager                      m_imuManager;           /// Manager for IMU units
     WebServer                       m_webServer;            /// Web server interface
+    TelemetryPublisher              m_telemetry;            /// Data messages to the web clients
+    StartupGraph                    m_startup;              /// Brings the managers up concurrently
 
     // Data Storage
+    std::unique_ptr<DataBus>        m_bus;                  /// Topics the managers publish on, too large for the stack
     GpsData                         m_gpsData;              /// Holds GPS Data
     ImuData                         m_imuData;              /// Holds IMU Data
+    NavigationFilter                m_navFilter;            /// GPS / IMU fusion
+    NavigationSolution              m_navSolution;          /// Holds the fused solution
+    std::unique_ptr<SensorHistory>  m_sensorHistory;        /// Last seconds of every stream, too large for the stack
+    Geodesy::LocalFrame             m_targetFrame;          /// Frame at the settings target
+    Geodesy::Geodesic               m_toTarget;             /// Range and bearing from the solution to the target
+    Vector3                         m_targetOffset;         /// Solution north east down of the target, m
 
     // Utilities
     COT_Utility                     m_cot;                  /// Utility to generate and handle CoT stuff. 
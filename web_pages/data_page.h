@@ -29,50 +29,142 @@ const std::string dataPage = R"(
         <input type="number" id="altitude" name="altitude" readonly><br>
     </form>
     <script>
-        // Create a WebSocket connection
-        var ws = new WebSocket("ws://localhost:" + window.location.port + "/websocket");
+        // Binary telemetry keys, stream then field index, see telemetry_publisher.h
+        var STREAMS = [
+            { name: "gps",    fields: ["hour", "min", "sec", "latitude", "longitude", "altitude"] },
+            { name: "logs",   fields: ["lines", "timeout"] },
+            { name: "imu",    fields: ["roll", "pitch", "yaw", "gyroX", "gyroY", "gyroZ", "accelX", "accelY", "accelZ", "temperature"] },
+            { name: "fins",   fields: ["fin1", "fin2", "fin3", "fin4", "frames", "writes", "writeErrors", "missedTicks"] },
+            { name: "health", fields: ["gpsFix", "gpsRateHz", "gpsDropped", "imuDropped", "imuErrors", "navInitialized"] },
+            { name: "target", fields: ["range", "bearing", "north", "east", "down"] }
+        ];
+
+        // Decode one CBOR item, the subset the server writes
+        function decodeCbor(buffer) {
+            var view = new DataView(buffer);
+            var offset = 0;
+
+            function argument(info) {
+                if (info < 24) return info;
+                var value;
+                if (info === 24) { value = view.getUint8(offset); offset += 1; }
+                else if (info === 25) { value = view.getUint16(offset); offset += 2; }
+                else if (info === 26) { value = view.getUint32(offset); offset += 4; }
+                else if (info === 27) { value = view.getUint32(offset) * 4294967296 + view.getUint32(offset + 4); offset += 8; }
+                else throw new Error("Unsupported CBOR length");
+                return value;
+            }
+
+            function item() {
+                var initial = view.getUint8(offset++);
+                var major = initial >> 5;
+                var info = initial & 0x1f;
+
+                if (major === 7) {
+                    if (info === 20) return false;
+                    if (info === 21) return true;
+                    if (info === 22) return null;
+                    var value;
+                    if (info === 25) {
+                        var half = view.getUint16(offset);
+                        var exponent = (half >> 10) & 0x1f, fraction = half & 0x3ff;
+                        value = exponent === 0 ? fraction * Math.pow(2, -24)
+                              : exponent === 31 ? (fraction ? NaN : Infinity)
+                              : (fraction + 1024) * Math.pow(2, exponent - 25);
+                        if (half & 0x8000) value = -value;
+                        offset += 2;
+                    }
+                    else if (info === 26) { value = view.getFloat32(offset); offset += 4; }
+                    else if (info === 27) { value = view.getFloat64(offset); offset += 8; }
+                    else throw new Error("Unsupported CBOR simple value");
+                    return value;
+                }
+
+                var length = argument(info);
+                if (major === 0) return length;
+                if (major === 1) return -1 - length;
+                if (major === 2 || major === 3) {
+                    var bytes = new Uint8Array(buffer, offset, length);
+                    offset += length;
+                    return major === 3 ? new TextDecoder().decode(bytes) : bytes;
+                }
+                if (major === 4) {
+                    var array = [];
+                    for (var i = 0; i < length; i++) array.push(item());
+                    return array;
+                }
+                if (major === 5) {
+                    var map = {};
+                    for (var j = 0; j < length; j++) { var key = item(); map[key] = item(); }
+                    return map;
+                }
+                throw new Error("Unsupported CBOR type");
+            }
+
+            return item();
+        }
+
+        // Put a binary message in the same shape as the JSON one
+        function fromBinary(root) {
+            var message = {};
+            for (var streamKey in root) {
+                var stream = STREAMS[streamKey];
+                if (stream === undefined) continue;
+                message[stream.name] = {};
+                for (var key in root[streamKey]) {
+                    var name = stream.fields[key];
+                    if (name !== undefined) message[stream.name][name] = root[streamKey][key];
+                }
+            }
+            return message;
+        }
+
+        // Create a WebSocket connection, binary telemetry unless the page was opened with ?encoding=json.
+        // GPS comes at 10Hz unless the page was opened with ?rate=N
+        var params = new URLSearchParams(window.location.search);
+        var binary = params.get("encoding") !== "json";
+        var gpsRate = Number(params.get("rate")) || 10;
+        var ws = binary ? new WebSocket("ws://localhost:" + window.location.port + "/websocket", ["wasp.cbor"])
+                        : new WebSocket("ws://localhost:" + window.location.port + "/websocket");
+        ws.binaryType = "arraybuffer";
 
         // WebSocket event handler for message reception
         ws.onmessage = function(event) {
-            // Parse received JSON data
-            var message = JSON.parse(event.data);
+            // Binary frames are CBOR, text frames are JSON
+            var message = (event.data instanceof ArrayBuffer) ? fromBinary(decodeCbor(event.data)) : JSON.parse(event.data);
             
-            // Check if message follows the "data" schema
-            if (message.hasOwnProperty("data"))
+            // Check if message is on the "gps" stream
+            if (message.hasOwnProperty("gps"))
             {
-                if(message.data.hasOwnProperty("latitude")) { document.getElementById("latitude").value = message.data.latitude; }
-                if(message.data.hasOwnProperty("longitude")) { document.getElementById("longitude").value = message.data.longitude; }
-                if(message.data.hasOwnProperty("altitude")) { document.getElementById("altitude").value = message.data.altitude; }
-                if(message.data.hasOwnProperty("hour")) { document.getElementById("hour").value = message.data.hour; }
-                if(message.data.hasOwnProperty("min")) { document.getElementById("min").value = message.data.min; }
-                if(message.data.hasOwnProperty("sec")) { document.getElementById("sec").value = message.data.sec; }
+                if(message.gps.hasOwnProperty("latitude")) { document.getElementById("latitude").value = message.gps.latitude; }
+                if(message.gps.hasOwnProperty("longitude")) { document.getElementById("longitude").value = message.gps.longitude; }
+                if(message.gps.hasOwnProperty("altitude")) { document.getElementById("altitude").value = message.gps.altitude; }
+                if(message.gps.hasOwnProperty("hour")) { document.getElementById("hour").value = message.gps.hour; }
+                if(message.gps.hasOwnProperty("min")) { document.getElementById("min").value = message.gps.min; }
+                if(message.gps.hasOwnProperty("sec")) { document.getElementById("sec").value = message.gps.sec; }
             }
 
-            // Check if message has any new messages
-            if (message.hasOwnProperty("message"))
+            // Logs come as lines, each shown for the message's timeout
+            if (message.hasOwnProperty("logs") && message.logs.hasOwnProperty("lines"))
             {
-                // Check if message has any new messages
-                if (message.message.hasOwnProperty("text")) 
-                {
-                    // Display received JSON message with timestamp
-                    var receivedTime = new Date().toLocaleTimeString();
-                    var messagesDiv = document.getElementById("messages");
-                    messagesDiv.innerHTML = "<p>Received at " + receivedTime + ": " + JSON.stringify(message.message.text) + "</p>";
-                }
-
-                if (message.message.hasOwnProperty("timeout"))
-                {
-                    // Start a timer to clear the content after timeout
-                    setTimeout(function() {
-                        messagesDiv.innerHTML = ""; // Clear the content
-                    }, message.message.timeout * 1000);
-                }
+                var receivedTime = new Date().toLocaleTimeString();
+                var messagesDiv = document.getElementById("messages");
+                var timeout = (message.logs.timeout || 5) * 1000;
+                message.logs.lines.forEach(function(line) {
+                    var paragraph = document.createElement("p");
+                    paragraph.textContent = "Received at " + receivedTime + ": " + line;
+                    messagesDiv.appendChild(paragraph);
+                    setTimeout(function() { paragraph.remove(); }, timeout);
+                });
             }
         };
 
         // WebSocket event handler for connection open
         ws.onopen = function(event) {
             console.log("WebSocket connection opened");
+
+            // Only the streams this page shows
+            ws.send(JSON.stringify({ subscribe: { gps: gpsRate, logs: 10 } }));
         };
 
         // WebSocket event handler for connection close